@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_ARTICULATION_HPP
+#define PEGASUS_ARTICULATION_HPP
+
+#include <pegasus/Asset.hpp>
+#include <pegasus/Body.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace pegasus
+{
+namespace mechanics
+{
+
+//!Parent index of a link attached directly to the articulation base
+uint32_t const ARTICULATION_BASE = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Stores a single link of the articulation and the revolute joint that connects it to its parent
+ *
+ * The link orientation is the parent orientation rotated by the rest orientation and then
+ * by the joint angle around the joint axis.
+ */
+struct ArticulationLink
+{
+    //!Handle of the body that represents the link in the scene
+    scene::Handle body = scene::ZERO_HANDLE;
+
+    //!Index of the parent link or ARTICULATION_BASE
+    uint32_t parent = ARTICULATION_BASE;
+
+    //!Joint position relative to the parent center of mass in the parent space
+    glm::vec3 parentOffset = { 0, 0, 0 };
+
+    //!Link center of mass relative to the joint position in the link space
+    glm::vec3 childOffset = { 0, 0, 0 };
+
+    //!Link orientation in the parent space at the zero joint angle
+    glm::quat restOrientation;
+
+    //!Joint axis in the link space
+    glm::vec3 axis = { 1, 0, 0 };
+
+    //!Joint coordinate, its rate and the torque applied along the joint axis
+    float angle = 0.0f;
+    float velocity = 0.0f;
+    float torque = 0.0f;
+
+    //!Body velocities written by the last integration, used to pick up the contact impulses
+    glm::vec3 linearVelocity = { 0, 0, 0 };
+    glm::vec3 angularVelocity = { 0, 0, 0 };
+};
+
+/**
+ * @brief Stores a tree of links connected by revolute joints to a fixed base
+ *
+ * The state of the articulation is stored in the joint coordinates, link bodies are
+ * placed by the forward kinematics after each integration, so the links never drift apart.
+ * Links collide as regular rigid bodies, velocity and position changes of their bodies made by the
+ * contact solver are converted into joint changes during the next integration.
+ * Links connected by a joint should not overlap, otherwise the contacts between them are resolved too.
+ */
+struct Articulation
+{
+    //!Handle of the body the root links are attached to, the base is not moved by the articulation
+    scene::Handle base = scene::ZERO_HANDLE;
+
+    //!Links, each parent must precede its children
+    std::vector<ArticulationLink> links;
+
+    //!Number of joint space integration steps per frame, long chains need more to stay stable
+    uint32_t substeps = 4;
+
+    //!Joint velocity damping per second
+    float damping = 0.5f;
+};
+
+/**
+ * @brief Makes a link connected with a revolute joint from the current body transforms
+ * @param parent      parent body data, the base body for the root links
+ * @param parentIndex index of the parent link or ARTICULATION_BASE
+ * @param handle      handle of the link body
+ * @param body        link body data
+ * @param anchor      world space joint position
+ * @param axis        world space joint axis
+ * @return link data with the zero joint angle
+ */
+ArticulationLink MakeRevoluteLink(
+    Body const& parent, uint32_t parentIndex, scene::Handle handle, Body const& body, glm::vec3 anchor, glm::vec3 axis
+);
+
+/**
+ * @brief Integrates the articulation in the joint space and places its link bodies
+ *
+ * Forces and torques accumulated by the link bodies are applied and cleared. Joint accelerations
+ * are calculated by the articulated body algorithm in O(n) of the number of links on each substep.
+ *
+ * @param[in,out] articulation articulation data
+ * @param[in,out] bodies       scene bodies
+ * @param[in]     duration     delta time of the integration
+ */
+void IntegrateArticulation(Articulation& articulation, std::vector<scene::Asset<Body>>& bodies, float duration);
+
+} // namespace mechanics
+} // namespace pegasus
+#endif // PEGASUS_ARTICULATION_HPP
@@ -47,6 +47,16 @@ struct DynamicBody : RigidBody
     DynamicBody(Scene& scene, Handle body, Handle shape);
 };
 
+/**
+ * @brief Represents a body with an infinite mass that moves with the velocity set by the user
+ *
+ * Forces are not applied to the body, contacts do not change its velocity.
+ */
+struct KinematicBody : RigidBody
+{
+    KinematicBody(Scene& scene, Handle body, Handle shape);
+};
+
 /**
  * @brief Stores handles to a physical body and a binded force
  */
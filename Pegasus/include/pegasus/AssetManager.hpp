@@ -6,9 +6,13 @@
 #ifndef PEGASUS_SCENE_ASSET_MANAGER_HPP
 #define PEGASUS_SCENE_ASSET_MANAGER_HPP
 
+#include <pegasus/Articulation.hpp>
 #include <pegasus/Asset.hpp>
 #include <pegasus/Force.hpp>
+#include <pegasus/ForceRegistry.hpp>
+#include <pegasus/Joint.hpp>
 #include <Arion/Shape.hpp>
+#include <cstdint>
 #include <vector>
 #include <deque>
 
@@ -40,6 +44,7 @@ public:
     template < typename T >
     Handle MakeAsset(std::vector<Asset<T>>& data)
     {
+        ++m_revision;
         for (size_t i = 0; i < data.size(); ++i)
         {
             if (data[i].id == ZERO_HANDLE)
@@ -79,9 +84,23 @@ public:
     template < typename T >
     void RemoveAsset(std::vector<Asset<T>>& data, Handle id)
     {
+        ++m_revision;
         data[id - 1].id = 0;
     }
 
+    /**
+     * @brief Returns revision of the asset layout
+     *
+     * Revision changes each time assets are made, removed or restored from the stack,
+     * so data derived from the handles stays valid while the revision is the same.
+     *
+     * @return asset layout revision
+     */
+    uint64_t GetRevision() const
+    {
+        return m_revision;
+    }
+
     /**
      * @brief Returns body buffer
      * @return physical body buffer
@@ -108,13 +127,30 @@ public:
     template < typename Object, typename Shape >
     std::vector<Asset<RigidBody>>& GetObjects();
 
+    /**
+     * @brief Registers the user force type
+     *
+     * @attention Types must be registered before the frames that use them are pushed
+     *
+     * @tparam Force force type
+     * @return index of the force type
+     */
+    template < typename Force >
+    uint32_t RegisterForce()
+    {
+        return m_asset.m_forces.Register<Force>();
+    }
+
     /**
      * @brief Return @t Force buffer
      * @tparam Force force type
      * @return force buffer
      */
     template < typename Force >
-    std::vector<Asset<Force>>& GetForces();
+    std::vector<Asset<Force>>& GetForces()
+    {
+        return m_asset.m_forces.GetStorage<Force>().forces;
+    }
 
     /**
      * @brief Returns body force bind buffer
@@ -122,7 +158,36 @@ public:
      * @return body force bind buffer
      */
     template < typename Force >
-    std::vector<Asset<ForceBind>>& GetForceBinds();
+    std::vector<Asset<ForceBind>>& GetForceBinds()
+    {
+        return m_asset.m_forces.GetStorage<Force>().binds;
+    }
+
+    /**
+     * @brief Returns storages of all registered force types
+     * @return force registry
+     */
+    inline ForceRegistry& GetForceRegistry()
+    {
+        return m_asset.m_forces;
+    }
+
+    /**
+     * @brief Returns @t Joint buffer
+     * @tparam Joint joint type
+     * @return joint buffer
+     */
+    template < typename Joint >
+    std::vector<Asset<Joint>>& GetJoints();
+
+    /**
+     * @brief Returns articulation buffer
+     * @return articulation buffer
+     */
+    inline std::vector<Asset<mechanics::Articulation>>& GetArticulations()
+    {
+        return m_asset.m_articulations;
+    }
 
     /**
      * @brief Saves a copy of current scene on asset stack
@@ -151,6 +216,7 @@ public:
         if (!m_assetStack.empty())
         {
             m_asset = m_assetStack.back();
+            ++m_revision;
         }
     }
 
@@ -174,27 +240,27 @@ public:
         std::vector<Asset<RigidBody>> m_dynamicSpheres;
         std::vector<Asset<RigidBody>> m_staticBoxes;
         std::vector<Asset<RigidBody>> m_dynamicBoxes;
+        std::vector<Asset<RigidBody>> m_kinematicPlanes;
+        std::vector<Asset<RigidBody>> m_kinematicSpheres;
+        std::vector<Asset<RigidBody>> m_kinematicBoxes;
+
+        //!Forces and their binds
+        ForceRegistry m_forces;
 
-        //!Forces
-        std::vector<Asset<force::StaticField>> m_staticFieldForces;
-        std::vector<Asset<force::SquareDistanceSource>> m_squareDistanceSourceForces;
-        std::vector<Asset<force::Drag>> m_dragForces;
-        std::vector<Asset<force::Spring>> m_springForces;
-        std::vector<Asset<force::Bungee>> m_bungeeForces;
-        std::vector<Asset<force::Buoyancy>> m_buoyancyForces;
-
-        //!ForceBind bindings
-        std::vector<Asset<ForceBind>> m_staticFieldForceBindings;
-        std::vector<Asset<ForceBind>> m_squareDistanceSourceForceBindings;
-        std::vector<Asset<ForceBind>> m_dragForceBindings;
-        std::vector<Asset<ForceBind>> m_springForceBindings;
-        std::vector<Asset<ForceBind>> m_bungeeForceBindings;
-        std::vector<Asset<ForceBind>> m_buoyancyForceBindings;
+        //!Joints
+        std::vector<Asset<joint::BallSocket>> m_ballSocketJoints;
+        std::vector<Asset<joint::Hinge>> m_hingeJoints;
+        std::vector<Asset<joint::Distance>> m_distanceJoints;
+        std::vector<Asset<joint::Fixed>> m_fixedJoints;
+
+        //!Articulations
+        std::vector<Asset<mechanics::Articulation>> m_articulations;
     };
 
 private:
     Assets m_asset;
     std::deque<Assets> m_assetStack;
+    uint64_t m_revision = 0;
 };
 
 template <>
@@ -252,75 +318,45 @@ inline std::vector<Asset<RigidBody>>& AssetManager::GetObjects<DynamicBody, ario
 }
 
 template <>
-inline std::vector<Asset<force::StaticField>>& AssetManager::GetForces<force::StaticField>()
-{
-    return m_asset.m_staticFieldForces;
-}
-
-template <>
-inline std::vector<Asset<force::SquareDistanceSource>>& AssetManager::GetForces<force::SquareDistanceSource>()
-{
-    return m_asset.m_squareDistanceSourceForces;
-}
-
-template <>
-inline std::vector<Asset<force::Drag>>& AssetManager::GetForces<force::Drag>()
-{
-    return m_asset.m_dragForces;
-}
-
-template <>
-inline std::vector<Asset<force::Spring>>& AssetManager::GetForces<force::Spring>()
-{
-    return m_asset.m_springForces;
-}
-
-template <>
-inline std::vector<Asset<force::Bungee>>& AssetManager::GetForces<force::Bungee>()
-{
-    return m_asset.m_bungeeForces;
-}
-
-template <>
-inline std::vector<Asset<force::Buoyancy>>& AssetManager::GetForces<force::Buoyancy>()
+inline std::vector<Asset<RigidBody>>& AssetManager::GetObjects<KinematicBody, arion::Plane>()
 {
-    return m_asset.m_buoyancyForces;
+    return m_asset.m_kinematicPlanes;
 }
 
 template <>
-inline std::vector<Asset<ForceBind>>& AssetManager::GetForceBinds<force::StaticField>()
+inline std::vector<Asset<RigidBody>>& AssetManager::GetObjects<KinematicBody, arion::Sphere>()
 {
-    return m_asset.m_staticFieldForceBindings;
+    return m_asset.m_kinematicSpheres;
 }
 
 template <>
-inline std::vector<Asset<ForceBind>>& AssetManager::GetForceBinds<force::SquareDistanceSource>()
+inline std::vector<Asset<RigidBody>>& AssetManager::GetObjects<KinematicBody, arion::Box>()
 {
-    return m_asset.m_squareDistanceSourceForceBindings;
+    return m_asset.m_kinematicBoxes;
 }
 
 template <>
-inline std::vector<Asset<ForceBind>>& AssetManager::GetForceBinds<force::Drag>()
+inline std::vector<Asset<joint::BallSocket>>& AssetManager::GetJoints<joint::BallSocket>()
 {
-    return m_asset.m_dragForceBindings;
+    return m_asset.m_ballSocketJoints;
 }
 
 template <>
-inline std::vector<Asset<ForceBind>>& AssetManager::GetForceBinds<force::Spring>()
+inline std::vector<Asset<joint::Hinge>>& AssetManager::GetJoints<joint::Hinge>()
 {
-    return m_asset.m_springForceBindings;
+    return m_asset.m_hingeJoints;
 }
 
 template <>
-inline std::vector<Asset<ForceBind>>& AssetManager::GetForceBinds<force::Bungee>()
+inline std::vector<Asset<joint::Distance>>& AssetManager::GetJoints<joint::Distance>()
 {
-    return m_asset.m_bungeeForceBindings;
+    return m_asset.m_distanceJoints;
 }
 
 template <>
-inline std::vector<Asset<ForceBind>>& AssetManager::GetForceBinds<force::Buoyancy>()
+inline std::vector<Asset<joint::Fixed>>& AssetManager::GetJoints<joint::Fixed>()
 {
-    return m_asset.m_buoyancyForceBindings;
+    return m_asset.m_fixedJoints;
 }
 
 } // namespace scene
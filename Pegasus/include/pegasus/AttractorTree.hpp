@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_ATTRACTOR_TREE_HPP
+#define PEGASUS_ATTRACTOR_TREE_HPP
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace pegasus
+{
+namespace force
+{
+
+//!Number of consecutive attractor groups evaluated by one task
+uint32_t const ATTRACTOR_GROUP_CHUNK_SIZE = 16;
+
+/**
+ * @brief Point source of an inverse square field
+ */
+struct Attractor
+{
+    glm::vec3 position;
+
+    //!Field magnitude at the unit distance
+    float strength;
+
+    //!Body index of the attractor, used to skip self interaction
+    uint32_t index;
+};
+
+/**
+ * @brief Barnes-Hut octree over the attractors
+ *
+ * Distant groups of attractors are approximated by their center of mass,
+ * so the field at a point is calculated in O(log N) instead of O(N).
+ */
+class AttractorTree
+{
+public:
+    /**
+     * @brief Removes all attractors and nodes
+     */
+    void Clear();
+
+    /**
+     * @brief Adds the attractor, the tree has to be rebuilt afterwards
+     * @param attractor attractor data
+     */
+    void Add(Attractor const& attractor);
+
+    /**
+     * @brief Builds the octree over the added attractors
+     */
+    void Build();
+
+    /**
+     * @brief Calculates the field of the attractors at the given position
+     *
+     * The field is calculated by the following equation:
+     * a = sum(s * r / (|r|^2 + e^2)^(3/2))
+     * Where s is attractor strength, r is vector to the attractor and e is softening distance.
+     *
+     * @param position     point the field is calculated at
+     * @param exclude      index of the attractor to skip
+     * @param openingAngle ratio of the node size to the distance below which the node is approximated
+     * @param softening    distance that limits the field near the attractors
+     * @return field vector
+     */
+    glm::vec3 CalculateField(glm::vec3 position, uint32_t exclude, float openingAngle, float softening) const;
+
+    /**
+     * @brief Returns number of the attractor groups
+     *
+     * Groups are the largest nodes holding a few attractors, they split the attractors into disjoint sets.
+     *
+     * @return number of the attractor groups
+     */
+    uint32_t GetGroupCount() const;
+
+    /**
+     * @brief Adds fields at the attractors of the groups to the buffer
+     *
+     * Attractors of a group share one list of the nodes accepted for the whole group,
+     * so the tree is traversed once per group instead of once per attractor.
+     *
+     * @param[in]     begin        first group
+     * @param[in]     end          group past the last one
+     * @param[in]     openingAngle ratio of the node size to the distance below which the node is approximated
+     * @param[in]     softening    distance that limits the field near the attractors
+     * @param[in,out] fields       fields indexed by the attractor index
+     */
+    void AddGroupFields(
+        uint32_t begin, uint32_t end, float openingAngle, float softening, std::vector<glm::vec3>& fields
+    ) const;
+
+private:
+    struct Node
+    {
+        glm::vec3 center;
+        float halfSize;
+        glm::vec3 centerOfMass;
+        float strength;
+
+        //!First child node
+        uint32_t firstChild;
+
+        //!Number of child nodes, zero for the leaves
+        uint32_t childCount;
+
+        //!First attractor of the node subtree
+        uint32_t firstAttractor;
+
+        //!Number of attractors in the node subtree
+        uint32_t attractorCount;
+    };
+
+    std::vector<Attractor> m_attractors;
+    std::vector<Attractor> m_scratch;
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_groups;
+
+    /**
+     * @brief Subdivides the node until its attractors fit into the leaves
+     * @param node    node index
+     * @param depth   node depth
+     * @param grouped true if an ancestor of the node is a group
+     */
+    void BuildNode(uint32_t node, uint32_t depth, bool grouped);
+};
+
+} // namespace force
+} // namespace pegasus
+#endif // PEGASUS_ATTRACTOR_TREE_HPP
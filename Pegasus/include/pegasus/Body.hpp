@@ -7,10 +7,12 @@
 #define PEGASUS_BODY_HPP
 
 #include <pegasus/Material.hpp>
+#include <pegasus/SymmetricMatrix.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/optimum_pow.hpp>
+#include <cstdint>
 
 namespace pegasus
 {
@@ -52,8 +54,29 @@ struct Body
     Material material;
     LinearMotion linearMotion;
     AngularMotion angularMotion;
+
+    //!World space inverse moment of inertia, call UpdateInverseInertia after changing the material directly
+    SymmetricMatrix3 inverseInertia;
+
+    //!Body is skipped by the simulation until it is woken up
+    bool asleep;
+
+    //!Time the body has been moving slower than the scene sleep thresholds
+    float restDuration;
+
+    //!Groups the body belongs to, matched against the group masks of global force fields
+    uint32_t groups;
 };
 
+/**
+ * @brief Updates world space inverse moment of inertia of the body from its orientation
+ * @param body body data
+ */
+inline void UpdateInverseInertia(Body& body)
+{
+    body.inverseInertia = RotateInertia(body.angularMotion.orientation, body.material.GetInverseMomentOfInertia());
+}
+
 /**
  * @brief  Calculates moment of inertia for the given sphere
  * @param  radius sphere's radius
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_BODY_BINDINGS_HPP
+#define PEGASUS_BODY_BINDINGS_HPP
+
+#include <pegasus/AssetManager.hpp>
+#include <pegasus/Body.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace pegasus
+{
+namespace scene
+{
+
+/**
+ * @brief Stores an asset bound to a body together with the function that applies it
+ */
+struct BodyBinding
+{
+    //!Applies the asset to the body
+    using Callback = void (*)(AssetManager& assets, Handle asset, mechanics::Body& body, float duration);
+
+    Callback callback;
+    Handle asset;
+};
+
+/**
+ * @brief Stores bindings grouped by the body index
+ *
+ * Bindings of a body keep the order they were added in.
+ */
+struct BodyBindings
+{
+    //!Binding offsets of each body, the last element is the total number of bindings
+    std::vector<uint32_t> offsets;
+
+    //!Bindings grouped by body
+    std::vector<BodyBinding> bindings;
+
+    //!Body index of each added binding
+    std::vector<uint32_t> addedBodies;
+
+    //!Added bindings in the order they were added
+    std::vector<BodyBinding> addedBindings;
+};
+
+/**
+ * @brief Removes all bindings
+ * @param[out] bodyBindings bindings
+ */
+inline void ClearBodyBindings(BodyBindings& bodyBindings)
+{
+    bodyBindings.addedBodies.clear();
+    bodyBindings.addedBindings.clear();
+}
+
+/**
+ * @brief Adds binding of the asset to the body
+ * @param[in,out] bodyBindings bindings
+ * @param[in]     body         body handle
+ * @param[in]     binding      asset binding
+ */
+inline void AddBodyBinding(BodyBindings& bodyBindings, Handle body, BodyBinding binding)
+{
+    bodyBindings.addedBodies.push_back(body - 1);
+    bodyBindings.addedBindings.push_back(binding);
+}
+
+/**
+ * @brief Groups added bindings by the body index
+ * @param[in,out] bodyBindings bindings
+ * @param[in]     bodyCount    number of bodies
+ */
+inline void SortBodyBindings(BodyBindings& bodyBindings, uint32_t bodyCount)
+{
+    std::vector<uint32_t>& offsets = bodyBindings.offsets;
+    offsets.assign(bodyCount + 1, 0);
+    for (uint32_t body : bodyBindings.addedBodies)
+    {
+        ++offsets[body + 1];
+    }
+    for (size_t i = 1; i < offsets.size(); ++i)
+    {
+        offsets[i] += offsets[i - 1];
+    }
+
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    bodyBindings.bindings.resize(offsets.back());
+    for (size_t i = 0; i < bodyBindings.addedBodies.size(); ++i)
+    {
+        bodyBindings.bindings[cursors[bodyBindings.addedBodies[i]]++] = bodyBindings.addedBindings[i];
+    }
+}
+
+/**
+ * @brief Applies bindings of the body
+ * @param[in]     bodyBindings bindings grouped by the body index
+ * @param[in]     index        body index
+ * @param[in,out] assets       assets of the bindings
+ * @param[in,out] body         body data
+ * @param[in]     duration     duration passed to the bindings
+ */
+inline void ApplyBodyBindings(
+    BodyBindings const& bodyBindings, uint32_t index, AssetManager& assets, mechanics::Body& body, float duration
+)
+{
+    for (uint32_t i = bodyBindings.offsets[index]; i < bodyBindings.offsets[index + 1]; ++i)
+    {
+        BodyBinding const& binding = bodyBindings.bindings[i];
+        binding.callback(assets, binding.asset, body, duration);
+    }
+}
+
+} // namespace scene
+} // namespace pegasus
+#endif // PEGASUS_BODY_BINDINGS_HPP
@@ -34,6 +34,30 @@ inline bool IsPersistent(
     return glm::distance2(curPoint, prevPoint) < persistentThresholdSq;
 }
 
+/**
+ * @brief Checks if the body has an infinite mass and a velocity set by the user
+ * @param body body data
+ * @return @c true if the body is kinematic and moving, @c false otherwise
+ */
+inline bool IsMovingKinematic(mechanics::Body const& body)
+{
+    return body.material.HasInfiniteMass()
+        && (glm::length2(body.linearMotion.velocity) > 0 || glm::length2(body.angularMotion.velocity) > 0);
+}
+
+/**
+ * @brief Checks if the body moves and has to be tested against the bodies that do not
+ *
+ * Moving kinematic bodies are tested against sleeping bodies, so they can wake them up.
+ *
+ * @param body body data
+ * @return @c true if the body is awake and has a finite mass or is kinematic and moving, @c false otherwise
+ */
+inline bool IsSimulated(mechanics::Body const& body)
+{
+    return !body.asleep && (!body.material.HasInfiniteMass() || IsMovingKinematic(body));
+}
+
 /**
  * @brief Detects collisions in the given set of rigid bodies
  * @tparam Object rigid body type
@@ -57,7 +81,7 @@ void DetectContacts(scene::AssetManager& assetManager, std::vector<Contact>& con
 
             mechanics::Body const& aBody = assetManager.GetAsset(assetManager.GetBodies(), aObject.data.body);
             mechanics::Body const& bBody = assetManager.GetAsset(assetManager.GetBodies(), bObject.data.body);
-            if (aBody.material.HasInfiniteMass() && bBody.material.HasInfiniteMass())
+            if (!IsSimulated(aBody) && !IsSimulated(bBody))
             {
                 continue;
             }
@@ -133,7 +157,7 @@ void DetectContacts(scene::AssetManager& assetManager, std::vector<Contact>& con
 
             mechanics::Body const& aBody = assetManager.GetAsset(assetManager.GetBodies(), aObject.data.body);
             mechanics::Body const& bBody = assetManager.GetAsset(assetManager.GetBodies(), bObject.data.body);
-            if (aBody.material.HasInfiniteMass() && bBody.material.HasInfiniteMass())
+            if (!IsSimulated(aBody) && !IsSimulated(bBody))
             {
                 continue;
             }
@@ -190,17 +214,26 @@ inline std::vector<Contact> DetectContacts(scene::AssetManager& assetManager)
     DetectContacts<scene::DynamicBody, arion::Plane, scene::StaticBody, arion::Plane>(assetManager, contacts);
     DetectContacts<scene::DynamicBody, arion::Plane, scene::StaticBody, arion::Sphere>(assetManager, contacts);
     DetectContacts<scene::DynamicBody, arion::Plane, scene::StaticBody, arion::Box>(assetManager, contacts);
+    DetectContacts<scene::DynamicBody, arion::Plane, scene::KinematicBody, arion::Plane>(assetManager, contacts);
+    DetectContacts<scene::DynamicBody, arion::Plane, scene::KinematicBody, arion::Sphere>(assetManager, contacts);
+    DetectContacts<scene::DynamicBody, arion::Plane, scene::KinematicBody, arion::Box>(assetManager, contacts);
 
     DetectContacts<scene::DynamicBody, arion::Sphere>(assetManager, contacts);
     DetectContacts<scene::DynamicBody, arion::Sphere, scene::DynamicBody, arion::Box>(assetManager, contacts);
     DetectContacts<scene::DynamicBody, arion::Sphere, scene::StaticBody, arion::Plane>(assetManager, contacts);
     DetectContacts<scene::DynamicBody, arion::Sphere, scene::StaticBody, arion::Sphere>(assetManager, contacts);
     DetectContacts<scene::DynamicBody, arion::Sphere, scene::StaticBody, arion::Box>(assetManager, contacts);
+    DetectContacts<scene::DynamicBody, arion::Sphere, scene::KinematicBody, arion::Plane>(assetManager, contacts);
+    DetectContacts<scene::DynamicBody, arion::Sphere, scene::KinematicBody, arion::Sphere>(assetManager, contacts);
+    DetectContacts<scene::DynamicBody, arion::Sphere, scene::KinematicBody, arion::Box>(assetManager, contacts);
 
     DetectContacts<scene::DynamicBody, arion::Box>(assetManager, contacts);
     DetectContacts<scene::DynamicBody, arion::Box, scene::StaticBody, arion::Plane>(assetManager, contacts);
     DetectContacts<scene::DynamicBody, arion::Box, scene::StaticBody, arion::Sphere>(assetManager, contacts);
     DetectContacts<scene::DynamicBody, arion::Box, scene::StaticBody, arion::Box>(assetManager, contacts);
+    DetectContacts<scene::DynamicBody, arion::Box, scene::KinematicBody, arion::Plane>(assetManager, contacts);
+    DetectContacts<scene::DynamicBody, arion::Box, scene::KinematicBody, arion::Sphere>(assetManager, contacts);
+    DetectContacts<scene::DynamicBody, arion::Box, scene::KinematicBody, arion::Box>(assetManager, contacts);
 
     return contacts;
 }
@@ -6,15 +6,56 @@
 #pragma once
 
 #include <pegasus/AssetManager.hpp>
+#include <pegasus/CollisionDetector.hpp>
 #include <pegasus/Contact.hpp>
+#include <pegasus/SolverBody.hpp>
+#include <pegasus/Island.hpp>
+#include <pegasus/JointSolver.hpp>
+#include <pegasus/Coloring.hpp>
+#include <pegasus/JacobiSolver.hpp>
+#include <pegasus/ThreadPool.hpp>
+#include <pegasus/WideContactSolver.hpp>
 #include <glm/gtx/norm.hpp>
 #include <algorithm>
+#include <limits>
+#include <utility>
 
 namespace pegasus
 {
 namespace collision
 {
 
+/**
+ * @brief Calculates velocity bias of the contact constraint
+ * @param[in] contact  contact data
+ * @param[in] duration duration of the frame
+ * @param[in] beta     factor of the penetration fed into the velocity, zero disables Baumgarte stabilization
+ * @return velocity bias
+ */
+inline float CalculateContactVelocityBias(Contact const& contact, float duration, float beta)
+{
+    float constexpr penetrationSlop = 0.0125f;
+    return contact.manifold.penetration < 0.0f
+        //Separated contact, allow the bodies to approach until they touch
+        ? -contact.manifold.penetration / duration
+        : -(beta / duration) * glm::max(contact.manifold.penetration + penetrationSlop, 0.0f) - contact.restitutionSpeed;
+}
+
+/**
+ * @brief Returns Jacobian of the contact constraint
+ * @param[in] contact contact data
+ * @return Jacobian
+ */
+inline Jacobian GetContactJacobian(Contact const& contact)
+{
+    return {
+        -contact.manifold.normal,
+        glm::cross(-contact.aRelativePosition, contact.manifold.normal),
+        contact.manifold.normal,
+        glm::cross(contact.bRelativePosition, contact.manifold.normal),
+    };
+}
+
 /**
  * @brief Resolves contact constraints and updates total lagrangian multiplier
  * @param[in,out] contact contact data
@@ -23,10 +64,12 @@ namespace collision
  * @param[in] rA contact point vector from the center of the body
  * @param[in] rB contact point vector from the center of the body
  * @param[in,out] totalLagrangianMultiplier total lagrangian multiplier for contact constraint
+ * @param[in] beta factor of the penetration fed into the velocity, zero disables Baumgarte stabilization
  */
 inline void SolveContactConstraint(
     Contact& contact, float duration,
-    Velocity const& V, glm::vec3 const& rA, glm::vec3 const& rB, float& totalLagrangianMultiplier
+    Velocity const& V, glm::vec3 const& rA, glm::vec3 const& rB, float& totalLagrangianMultiplier,
+    float beta = 0.1f
 )
 {
     contact.jacobian = Jacobian {
@@ -36,14 +79,7 @@ inline void SolveContactConstraint(
         glm::cross(rB, contact.manifold.normal),
     };
 
-    float const separationSpeed =
-        -glm::dot(V.vB + glm::cross(V.wB, rB) - (V.vA + glm::cross(V.wA, rA)), contact.manifold.normal);
-    float constexpr restitutionSlop = 0.5f;
-    float const restitution = contact.restitution * glm::max(separationSpeed - restitutionSlop, 0.0f);
-    float constexpr beta = 0.1f;
-    float constexpr penetrationSlop = 0.0125f;
-    float const baumgarteStabilizationTerm =
-        -(beta / duration) * glm::max(contact.manifold.penetration + penetrationSlop, 0.0f) + restitution;
+    float const baumgarteStabilizationTerm = CalculateContactVelocityBias(contact, duration, beta);
 
     float const lagrangianMultiplierDivisor = contact.jacobian * (contact.inverseEffectiveMass * contact.jacobian)
         + epona::fp::g_floatingPointThreshold;
@@ -133,69 +169,83 @@ inline void SolveFrictionConstraint(
     }
 }
 
+/**
+ * @brief Aligns friction tangents of the contact with the angular velocity of its first body
+ * @param[in,out] contact         contact data
+ * @param[in]     angularVelocity angular velocity of the first body
+ */
+inline void UpdateFrictionTangents(Contact& contact, glm::vec3 const& angularVelocity)
+{
+    if (epona::fp::IsZero(glm::length2(angularVelocity)))
+    {
+        return;
+    }
+
+    glm::vec3 const velocityCrossNormal = glm::cross(angularVelocity, contact.manifold.normal);
+    if (!epona::fp::IsZero(glm::length2(velocityCrossNormal)))
+    {
+        contact.manifold.firstTangent = glm::normalize(velocityCrossNormal);
+        assert(!glm::isnan(contact.manifold.firstTangent.x));
+        assert(!glm::isnan(contact.manifold.firstTangent.y));
+        assert(!glm::isnan(contact.manifold.firstTangent.z));
+    }
+
+    glm::vec3 const tangentCrossNormal = glm::cross(contact.manifold.firstTangent, contact.manifold.normal);
+    if (!epona::fp::IsZero(glm::length2(tangentCrossNormal)))
+    {
+        contact.manifold.secondTangent = glm::normalize(tangentCrossNormal);
+        assert(!glm::isnan(contact.manifold.secondTangent.x));
+        assert(!glm::isnan(contact.manifold.secondTangent.y));
+        assert(!glm::isnan(contact.manifold.secondTangent.z));
+    }
+}
+
 /**
  * @brief Calculates and solves contact and friction constraints and updates lambdas
- * @param[in,out] assetManager asset manager
+ * @param[in]     solverBodies solver bodies
  * @param[in,out] contact contact data
  * @param[in]     duration duration of the frame
  * @param[in,out] contactLambda lagrangian multiplier for contact constraint
  * @param[in,out] frictionLamda1 lagrangian multiplier for friction constraint
  * @param[in,out] frictionLamda2 lagrangian multiplier for friction constraint
+ * @param[in]     beta Baumgarte stabilization factor
  */
 inline void SolveConstraints(
-    scene::AssetManager& assetManager, Contact& contact, float duration,
-    float& contactLambda, float& frictionLamda1, float& frictionLamda2
+    SolverBodies const& solverBodies, Contact& contact, float duration,
+    float& contactLambda, float& frictionLamda1, float& frictionLamda2,
+    float beta = 0.1f
 )
 {
-    mechanics::Body const& aBody = assetManager.GetAsset(assetManager.GetBodies(), contact.aBodyHandle);
-    mechanics::Body const& bBody = assetManager.GetAsset(assetManager.GetBodies(), contact.bBodyHandle);
+    SolverBody const& aBody = solverBodies.bodies[contact.aSolverBody];
+    SolverBody const& bBody = solverBodies.bodies[contact.bSolverBody];
 
-    assert(!std::isinf(aBody.angularMotion.velocity.x)
-        && !std::isinf(aBody.angularMotion.velocity.y)
-        && !std::isinf(aBody.angularMotion.velocity.z));
-    assert(!std::isinf(bBody.angularMotion.velocity.x)
-        && !std::isinf(bBody.angularMotion.velocity.y)
-        && !std::isinf(bBody.angularMotion.velocity.z));
+    assert(!std::isinf(aBody.angularVelocity.x)
+        && !std::isinf(aBody.angularVelocity.y)
+        && !std::isinf(aBody.angularVelocity.z));
+    assert(!std::isinf(bBody.angularVelocity.x)
+        && !std::isinf(bBody.angularVelocity.y)
+        && !std::isinf(bBody.angularVelocity.z));
 
     Velocity const V{
-        aBody.linearMotion.velocity,
-        aBody.angularMotion.velocity,
-        bBody.linearMotion.velocity,
-        bBody.angularMotion.velocity,
+        aBody.linearVelocity,
+        aBody.angularVelocity,
+        bBody.linearVelocity,
+        bBody.angularVelocity,
     };
 
     contact.inverseEffectiveMass = MassMatrix{
-        aBody.material.HasInfiniteMass() ? glm::mat3(0) : glm::inverse(glm::mat3(aBody.material.GetMass())),
-        aBody.material.GetInverseMomentOfInertia(),
-        bBody.material.HasInfiniteMass() ? glm::mat3(0) : glm::inverse(glm::mat3(bBody.material.GetMass())),
-        bBody.material.GetInverseMomentOfInertia(),
+        aBody.inverseMass,
+        aBody.inverseInertia,
+        bBody.inverseMass,
+        bBody.inverseInertia,
     };
 
-    glm::vec3 const rA = contact.manifold.points.aWorldSpace - aBody.linearMotion.position;
-    glm::vec3 const rB = contact.manifold.points.bWorldSpace - bBody.linearMotion.position;
-
-    if (!epona::fp::IsZero(glm::length2(aBody.angularMotion.velocity)))
-    {
-        glm::vec3 const velocityCrossNormal = glm::cross(aBody.angularMotion.velocity, contact.manifold.normal);
-        if (!epona::fp::IsZero(glm::length2(velocityCrossNormal)))
-        {
-            contact.manifold.firstTangent = glm::normalize(velocityCrossNormal);
-            assert(!glm::isnan(contact.manifold.firstTangent.x));
-            assert(!glm::isnan(contact.manifold.firstTangent.y));
-            assert(!glm::isnan(contact.manifold.firstTangent.z));
-        }
+    glm::vec3 const& rA = contact.aRelativePosition;
+    glm::vec3 const& rB = contact.bRelativePosition;
 
-        glm::vec3 const tangentCrossNormal = glm::cross(contact.manifold.firstTangent, contact.manifold.normal);
-        if (!epona::fp::IsZero(glm::length2(tangentCrossNormal)))
-        {
-            contact.manifold.secondTangent = glm::normalize(tangentCrossNormal);
-            assert(!glm::isnan(contact.manifold.secondTangent.x));
-            assert(!glm::isnan(contact.manifold.secondTangent.y));
-            assert(!glm::isnan(contact.manifold.secondTangent.z));
-        }
-    }
+    UpdateFrictionTangents(contact, aBody.angularVelocity);
 
-    SolveContactConstraint(contact, duration, V, rA, rB, contactLambda);
+    SolveContactConstraint(contact, duration, V, rA, rB, contactLambda, beta);
     assert(!glm::isnan(contact.deltaVelocity.nA.x + contact.deltaVelocity.nA.y + contact.deltaVelocity.nA.z));
     assert(!glm::isnan(contact.deltaVelocity.nwA.x + contact.deltaVelocity.nwA.y + contact.deltaVelocity.nwA.z));
     assert(!glm::isnan(contact.deltaVelocity.nB.x + contact.deltaVelocity.nB.y + contact.deltaVelocity.nB.z));
@@ -208,12 +258,1142 @@ inline void SolveConstraints(
     assert(!glm::isnan(contact.deltaVelocity.nwB.x + contact.deltaVelocity.nwB.y + contact.deltaVelocity.nwB.z));
 }
 
+/**
+ * @brief Applies velocity change of the contact to its solver bodies
+ * @param[in,out] solverBodies solver bodies
+ * @param[in]     contact contact data
+ * @param[in]     factor velocity change factor
+ */
+inline void ApplyDeltaVelocity(SolverBodies& solverBodies, Contact const& contact, float factor = 1.0f)
+{
+    SolverBody& aBody = solverBodies.bodies[contact.aSolverBody];
+    SolverBody& bBody = solverBodies.bodies[contact.bSolverBody];
+
+    //Bodies with an infinite mass are shared between islands and must stay untouched
+    if (aBody.inverseMass != 0)
+    {
+        aBody.linearVelocity += contact.deltaVelocity.nA * factor;
+        aBody.angularVelocity += contact.deltaVelocity.nwA * factor;
+    }
+    if (bBody.inverseMass != 0)
+    {
+        bBody.linearVelocity += contact.deltaVelocity.nB * factor;
+        bBody.angularVelocity += contact.deltaVelocity.nwB * factor;
+    }
+
+    assert(!std::isinf(aBody.angularVelocity.x) && !std::isinf(aBody.angularVelocity.y) && !std::isinf(aBody.angularVelocity.z));
+    assert(!std::isinf(bBody.angularVelocity.x) && !std::isinf(bBody.angularVelocity.y) && !std::isinf(bBody.angularVelocity.z));
+}
+
+/**
+ * @brief Calculates separation speeds targeted by the restitution of the contacts
+ *
+ * Speeds are calculated from the velocities before the first velocity iteration,
+ * so that subsequent iterations do not cancel the bounce.
+ *
+ * @param[in]     solverBodies solver bodies
+ * @param[in,out] contacts     contacts
+ */
+inline void CalculateRestitutionSpeeds(SolverBodies const& solverBodies, std::vector<Contact>& contacts)
+{
+    float constexpr restitutionSlop = 0.5f;
+    for (Contact& contact : contacts)
+    {
+        SolverBody const& aBody = solverBodies.bodies[contact.aSolverBody];
+        SolverBody const& bBody = solverBodies.bodies[contact.bSolverBody];
+
+        float const approachSpeed = -glm::dot(
+            bBody.linearVelocity + glm::cross(bBody.angularVelocity, contact.bRelativePosition)
+                - (aBody.linearVelocity + glm::cross(aBody.angularVelocity, contact.aRelativePosition)),
+            contact.manifold.normal
+        );
+        contact.restitutionSpeed = contact.restitution * glm::max(approachSpeed - restitutionSlop, 0.0f);
+    }
+}
+
+/**
+ * @brief Resolves penetration of the contact by changing pseudo velocities of its solver bodies
+ *
+ * Only the penetration exceeding the slop is corrected. Pseudo velocities move the bodies
+ * once at the end of the step and never add to their momentum.
+ *
+ * @param[in,out] solverBodies solver bodies
+ * @param[in]     contact      contact data
+ * @param[in]     duration     duration of the frame
+ */
+inline void SolvePositionConstraint(SolverBodies& solverBodies, Contact const& contact, float duration)
+{
+    float constexpr beta = 0.8f;
+    float constexpr penetrationSlop = 0.005f;
+
+    float const penetration = contact.manifold.penetration - penetrationSlop;
+    if (penetration <= 0.0f)
+    {
+        return;
+    }
+
+    SolverBody& aBody = solverBodies.bodies[contact.aSolverBody];
+    SolverBody& bBody = solverBodies.bodies[contact.bSolverBody];
+
+    glm::vec3 const& n = contact.manifold.normal;
+    glm::vec3 const nwA = glm::cross(n, contact.aRelativePosition);
+    glm::vec3 const nwB = glm::cross(contact.bRelativePosition, n);
+    glm::vec3 const inertiaNwA = aBody.inverseInertia * nwA;
+    glm::vec3 const inertiaNwB = bBody.inverseInertia * nwB;
+
+    float const divisor = (aBody.inverseMass + bBody.inverseMass) * glm::dot(n, n)
+        + glm::dot(nwA, inertiaNwA) + glm::dot(nwB, inertiaNwB) + epona::fp::g_floatingPointThreshold;
+    float const separationSpeed = glm::dot(n, bBody.pseudoLinearVelocity - aBody.pseudoLinearVelocity)
+        + glm::dot(nwA, aBody.pseudoAngularVelocity) + glm::dot(nwB, bBody.pseudoAngularVelocity);
+    float const lagrangianMultiplier = glm::max(((beta / duration) * penetration - separationSpeed) / divisor, 0.0f);
+
+    if (aBody.inverseMass != 0)
+    {
+        aBody.pseudoLinearVelocity -= n * (aBody.inverseMass * lagrangianMultiplier);
+        aBody.pseudoAngularVelocity += inertiaNwA * lagrangianMultiplier;
+    }
+    if (bBody.inverseMass != 0)
+    {
+        bBody.pseudoLinearVelocity += n * (bBody.inverseMass * lagrangianMultiplier);
+        bBody.pseudoAngularVelocity += inertiaNwB * lagrangianMultiplier;
+    }
+}
+
+/**
+ * @brief Solves contact and friction constraints of the contact and applies velocity change
+ *
+ * Stored lagrangian multipliers are used as the initial totals and are replaced by the new totals.
+ *
+ * @param[in,out] solverBodies solver bodies
+ * @param[in,out] contact      contact data
+ * @param[in]     settings     solver pass parameters
+ */
+inline void SolveContact(SolverBodies& solverBodies, Contact& contact, ContactSolverSettings const& settings)
+{
+    float contactLambda = contact.lagrangianMultiplier * settings.warmStartFactor;
+    float frictionLamda1 = contact.tangentLagrangianMultiplier1 * settings.warmStartFactor;
+    float frictionLamda2 = contact.tangentLagrangianMultiplier2 * settings.warmStartFactor;
+
+    SolveConstraints(
+        solverBodies, contact, settings.duration,
+        contactLambda, frictionLamda1, frictionLamda2, settings.baumgarteFactor
+    );
+
+    contact.lagrangianMultiplier = contactLambda;
+    contact.tangentLagrangianMultiplier1 = frictionLamda1;
+    contact.tangentLagrangianMultiplier2 = frictionLamda2;
+
+    ApplyDeltaVelocity(solverBodies, contact, settings.impulseFactor);
+}
+
+/**
+ * @brief Solves friction constraints of the contact and applies velocity change
+ *
+ * The stored contact lagrangian multiplier is used as the total normal impulse.
+ *
+ * @param[in,out] solverBodies solver bodies
+ * @param[in,out] contact      contact data
+ * @param[in]     settings     solver pass parameters
+ */
+inline void SolveContactFriction(SolverBodies& solverBodies, Contact& contact, ContactSolverSettings const& settings)
+{
+    SolverBody const& aBody = solverBodies.bodies[contact.aSolverBody];
+    SolverBody const& bBody = solverBodies.bodies[contact.bSolverBody];
+
+    Velocity const V{
+        aBody.linearVelocity,
+        aBody.angularVelocity,
+        bBody.linearVelocity,
+        bBody.angularVelocity,
+    };
+
+    contact.inverseEffectiveMass = MassMatrix{
+        aBody.inverseMass,
+        aBody.inverseInertia,
+        bBody.inverseMass,
+        bBody.inverseInertia,
+    };
+
+    UpdateFrictionTangents(contact, aBody.angularVelocity);
+
+    float frictionLamda1 = contact.tangentLagrangianMultiplier1 * settings.warmStartFactor;
+    float frictionLamda2 = contact.tangentLagrangianMultiplier2 * settings.warmStartFactor;
+
+    contact.deltaVelocity = Jacobian();
+    SolveFrictionConstraint(
+        contact, V, contact.aRelativePosition, contact.bRelativePosition,
+        contact.lagrangianMultiplier, frictionLamda1, frictionLamda2
+    );
+
+    contact.tangentLagrangianMultiplier1 = frictionLamda1;
+    contact.tangentLagrangianMultiplier2 = frictionLamda2;
+
+    ApplyDeltaVelocity(solverBodies, contact, settings.impulseFactor);
+}
+
+/**
+ * @brief Solves contact constraints of two contacts between the same bodies as a single block
+ *
+ * Total normal impulses are found from the 2x2 linear complementarity problem by enumerating
+ * its active sets, friction constraints of each contact are solved afterwards.
+ * Nothing is changed if the problem is ill-conditioned or none of the active sets gives a solution,
+ * in this case the contacts are expected to be solved one at a time.
+ *
+ * @param[in,out] solverBodies solver bodies
+ * @param[in,out] first        contact data
+ * @param[in,out] second       contact data, must share both bodies with the first contact
+ * @param[in]     settings     solver pass parameters
+ * @return @c true if the contacts were solved
+ */
+inline bool SolveContactPair(
+    SolverBodies& solverBodies, Contact& first, Contact& second, ContactSolverSettings const& settings
+)
+{
+    float constexpr maxConditionNumber = 1000.0f;
+
+    SolverBody const& aBody = solverBodies.bodies[first.aSolverBody];
+    SolverBody const& bBody = solverBodies.bodies[first.bSolverBody];
+
+    Velocity const V{
+        aBody.linearVelocity,
+        aBody.angularVelocity,
+        bBody.linearVelocity,
+        bBody.angularVelocity,
+    };
+
+    MassMatrix const inverseEffectiveMass{
+        aBody.inverseMass,
+        aBody.inverseInertia,
+        bBody.inverseMass,
+        bBody.inverseInertia,
+    };
+
+    //Both Jacobians are expressed in the body order of the first contact
+    Jacobian const firstJacobian = GetContactJacobian(first);
+    Jacobian secondJacobian = GetContactJacobian(second);
+    if (second.aSolverBody != first.aSolverBody)
+    {
+        secondJacobian = { secondJacobian.nB, secondJacobian.nwB, secondJacobian.nA, secondJacobian.nwA };
+    }
+
+    float const k11 = firstJacobian * (inverseEffectiveMass * firstJacobian);
+    float const k12 = firstJacobian * (inverseEffectiveMass * secondJacobian);
+    float const k22 = secondJacobian * (inverseEffectiveMass * secondJacobian);
+    float const determinant = k11 * k22 - k12 * k12;
+    if (k11 * k11 >= maxConditionNumber * determinant)
+    {
+        return false;
+    }
+
+    float const total1 = first.lagrangianMultiplier * settings.warmStartFactor;
+    float const total2 = second.lagrangianMultiplier * settings.warmStartFactor;
+
+    //Relative velocities with the current totals removed, so that the new totals solve w = K * x + b
+    float const b1 = firstJacobian * V + CalculateContactVelocityBias(first, settings.duration, settings.baumgarteFactor)
+        - (k11 * total1 + k12 * total2);
+    float const b2 = secondJacobian * V + CalculateContactVelocityBias(second, settings.duration, settings.baumgarteFactor)
+        - (k12 * total1 + k22 * total2);
+
+    float x1 = 0.0f;
+    float x2 = 0.0f;
+    do
+    {
+        //Both constraints are active
+        x1 = (k12 * b2 - k22 * b1) / determinant;
+        x2 = (k12 * b1 - k11 * b2) / determinant;
+        if (x1 >= 0.0f && x2 >= 0.0f)
+        {
+            break;
+        }
+
+        //Only the first constraint is active
+        x1 = -b1 / k11;
+        x2 = 0.0f;
+        if (x1 >= 0.0f && k12 * x1 + b2 >= 0.0f)
+        {
+            break;
+        }
+
+        //Only the second constraint is active
+        x1 = 0.0f;
+        x2 = -b2 / k22;
+        if (x2 >= 0.0f && k12 * x2 + b1 >= 0.0f)
+        {
+            break;
+        }
+
+        //Both constraints are separating
+        x1 = 0.0f;
+        x2 = 0.0f;
+        if (b1 >= 0.0f && b2 >= 0.0f)
+        {
+            break;
+        }
+
+        return false;
+    } while (false);
+
+    Jacobian impulse = firstJacobian * (x1 - total1);
+    impulse += secondJacobian * (x2 - total2);
+    first.jacobian = firstJacobian;
+    first.deltaVelocity = inverseEffectiveMass * impulse;
+    ApplyDeltaVelocity(solverBodies, first, settings.impulseFactor);
+
+    first.lagrangianMultiplier = x1;
+    second.lagrangianMultiplier = x2;
+    SolveContactFriction(solverBodies, first, settings);
+    SolveContactFriction(solverBodies, second, settings);
+
+    return true;
+}
+
+/**
+ * @brief Defines the order in which contact constraints are solved
+ */
+enum class SolverMode : uint8_t
+{
+    //!Islands are solved in parallel, contacts of an island are solved sequentially
+    SEQUENTIAL,
+
+    //!Contacts are partitioned into batches without shared bodies, each batch is solved in parallel
+    COLORED,
+
+    //!All contacts are solved in parallel from the velocities of the previous iteration
+    JACOBI
+};
+
+/**
+ * @brief Defines how contact penetration is resolved
+ */
+enum class PositionCorrection : uint8_t
+{
+    //!Penetration is fed into the contact velocity
+    BAUMGARTE,
+
+    //!Penetration is resolved by a separate pass over pseudo velocities
+    SPLIT_IMPULSE
+};
+
+//!Partner index of a contact that is not paired
+uint32_t const INVALID_CONTACT = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Stores pairs of contacts between the same bodies
+ */
+struct ContactPairs
+{
+    //!Index of the paired contact for each contact
+    std::vector<uint32_t> partners;
+
+    //!Body pair keys with the contact indices, sorted by the key
+    std::vector<std::pair<uint64_t, uint32_t>> keys;
+};
+
+/**
+ * @brief Pairs contacts that share both bodies
+ *
+ * Contacts between the same bodies are paired in the order of their indices,
+ * an odd contact of the body pair stays unpaired.
+ *
+ * @param[in]  contacts contacts
+ * @param[out] pairs    contact pairs
+ */
+inline void BuildContactPairs(std::vector<Contact> const& contacts, ContactPairs& pairs)
+{
+    pairs.keys.resize(contacts.size());
+    for (uint32_t i = 0; i < contacts.size(); ++i)
+    {
+        uint64_t const a = glm::min(contacts[i].aSolverBody, contacts[i].bSolverBody);
+        uint64_t const b = glm::max(contacts[i].aSolverBody, contacts[i].bSolverBody);
+        pairs.keys[i] = std::make_pair((a << 32) | b, i);
+    }
+    std::sort(pairs.keys.begin(), pairs.keys.end());
+
+    pairs.partners.assign(contacts.size(), INVALID_CONTACT);
+    for (size_t i = 0; i + 1 < pairs.keys.size(); ++i)
+    {
+        if (pairs.keys[i].first == pairs.keys[i + 1].first)
+        {
+            pairs.partners[pairs.keys[i].second] = pairs.keys[i + 1].second;
+            pairs.partners[pairs.keys[i + 1].second] = pairs.keys[i].second;
+            ++i;
+        }
+    }
+}
+
+/**
+ * @brief Stores convergence data of the last contact resolution step
+ */
+struct SolverStatistics
+{
+    //!Sum of the absolute lagrangian multiplier changes of the contacts and joints made by each velocity iteration
+    std::vector<float> residuals;
+
+    //!Largest contact penetration expected after the step
+    float maxPenetration = 0.0f;
+
+    //!Number of contact solves made by the velocity iterations
+    uint32_t contactSolves = 0;
+};
+
+//!Maximum number of velocity iterations of a single island in the adaptive mode
+uint32_t const MAX_ISLAND_VELOCITY_ITERATIONS = 32;
+
+/**
+ * @brief Stores velocity iteration counts planned for the islands by the adaptive mode
+ */
+struct IslandIterations
+{
+    //!Number of velocity iterations of each island
+    std::vector<uint32_t> iterations;
+
+    //!Relative residual of the last iteration of each island
+    std::vector<float> residuals;
+
+    //!Relative residual of the island of each scene body during the previous step, indexed by handle - 1
+    std::vector<float> bodyResiduals;
+
+    //!Handles of the bodies with a residual stored during the previous step
+    std::vector<scene::Handle> residualHandles;
+
+    //!Contact graph distance of each solver body to a static body
+    std::vector<uint32_t> depths;
+
+    //!Breadth-first search queue
+    std::vector<uint32_t> queue;
+};
+
+/**
+ * @brief Stores contact solver settings and buffers reused between the resolution steps
+ */
+struct SolverData
+{
+    //!Constraint solving order
+    SolverMode mode = SolverMode::SEQUENTIAL;
+
+    //!Penetration resolution method
+    PositionCorrection positionCorrection = PositionCorrection::SPLIT_IMPULSE;
+
+    //!Instruction set used to solve colored batches
+    SimdInstructionSet instructionSet = DetectSimdInstructionSet();
+
+    //!Number of passes over the contact velocity constraints
+    uint32_t velocityIterations = 8;
+
+    //!Number of passes over the contact position constraints, used by the split impulse only
+    uint32_t positionIterations = 2;
+
+    //!Solve pairs of contacts between the same bodies as a single block, used by the sequential mode only
+    bool blockSolverEnabled = false;
+
+    //!Velocity iterations stop once the residual falls below the tolerance, 0 disables the early out
+    float tolerance = 0.0f;
+
+    //!Fraction of the contact impulses applied by each iteration, used by the Jacobi mode only
+    float relaxation = 0.5f;
+
+    //!Pick velocity iterations of each island from its depth and residual, used by the sequential mode only
+    bool adaptiveIterations = false;
+
+    //!Maximum number of contact solves per step of the adaptive mode, 0 means unlimited
+    uint32_t iterationBudget = 0;
+
+    //!Iteration plan of the adaptive mode
+    IslandIterations islandIterations;
+
+    //!Convergence data of the last resolution step
+    SolverStatistics statistics;
+
+    //!Lagrangian multipliers of the previous velocity iteration
+    std::vector<float> multipliers;
+
+    //!Bodies referenced by the contacts of the last resolution step
+    SolverBodies bodies;
+
+    //!Islands of the last resolution step
+    Islands islands;
+
+    //!Colored batches of the last resolution step
+    ColoredBatches batches;
+
+    //!Contact pairs of the last resolution step
+    ContactPairs pairs;
+
+    //!Contact slots of the solver bodies of the last resolution step
+    BodyContacts bodyContacts;
+
+    //!Joint constraints of the last resolution step
+    JointRows joints;
+};
+
+//!Number of contacts of a colored batch processed by a single task
+uint32_t const COLORED_BATCH_CHUNK_SIZE = 64;
+
+/**
+ * @brief Builds islands and, if needed, colored batches or pairs of the contacts
+ * @param[in,out] solver   solver data, must have the bodies loaded
+ * @param[in]     contacts contacts
+ */
+inline void BuildContactOrder(SolverData& solver, std::vector<Contact> const& contacts)
+{
+    BuildIslands(solver.bodies, contacts, solver.islands, solver.joints.links);
+
+    if (solver.mode == SolverMode::COLORED)
+    {
+        BuildColoredBatches(solver.bodies, contacts, solver.batches);
+    }
+    else if (solver.mode == SolverMode::JACOBI || solver.adaptiveIterations)
+    {
+        BuildBodyContacts(solver.bodies, contacts, solver.bodyContacts);
+    }
+
+    if (solver.mode == SolverMode::SEQUENTIAL && solver.blockSolverEnabled)
+    {
+        BuildContactPairs(contacts, solver.pairs);
+    }
+}
+
+/**
+ * @brief Calls the solvers for all contacts in the order defined by the solver mode
+ *
+ * Each contact's result is visible to the contacts solved after it.
+ * The result does not depend on the number of threads in the pool.
+ *
+ * @tparam ContactSolver callable type
+ * @tparam BatchSolver   callable type
+ * @param[in]     solver        solver data with the contact order built
+ * @param[in,out] threadPool    thread pool
+ * @param[in]     solveContact  function called with a contact index
+ * @param[in]     solveBatch    function called with indices and count of contacts that do not share bodies
+ */
+template < typename ContactSolver, typename BatchSolver >
+void ForEachContact(
+    SolverData const& solver, ThreadPool& threadPool, ContactSolver solveContact, BatchSolver solveBatch
+)
+{
+    switch (solver.mode)
+    {
+        //Jacobi mode solves velocities on its own, the remaining passes use the island order
+        case SolverMode::SEQUENTIAL:
+        case SolverMode::JACOBI:
+        {
+            Islands const& islands = solver.islands;
+            threadPool.ParallelFor(islands.islands.size(), [&islands, &solveContact](size_t index) {
+                Island const& island = islands.islands[index];
+                uint32_t const* indices = islands.contacts.data() + island.contactOffset;
+                for (uint32_t i = 0; i < island.contactCount; ++i)
+                {
+                    solveContact(indices[i]);
+                }
+            });
+            break;
+        }
+        case SolverMode::COLORED:
+        {
+            ColoredBatches const& batches = solver.batches;
+            for (size_t batch = 0; batch + 1 < batches.offsets.size(); ++batch)
+            {
+                uint32_t const offset = batches.offsets[batch];
+                uint32_t const count = batches.offsets[batch + 1] - offset;
+                size_t const chunkCount = (count + COLORED_BATCH_CHUNK_SIZE - 1) / COLORED_BATCH_CHUNK_SIZE;
+
+                threadPool.ParallelFor(chunkCount, [&batches, &solveBatch, offset, count](size_t chunk) {
+                    uint32_t const begin = static_cast<uint32_t>(chunk) * COLORED_BATCH_CHUNK_SIZE;
+                    uint32_t const end = glm::min(begin + COLORED_BATCH_CHUNK_SIZE, count);
+                    solveBatch(batches.contacts.data() + offset + begin, end - begin);
+                });
+            }
+
+            for (uint32_t const index : batches.overflow)
+            {
+                solveContact(index);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+//!Number of contacts or bodies processed by a single Jacobi task
+uint32_t const JACOBI_CHUNK_SIZE = 256;
+
+/**
+ * @brief Solves contact and friction constraints of the contact without applying the velocity change
+ *
+ * The increments of the lagrangian multipliers are scaled by the relaxation factor,
+ * the scaled velocity change is left in the contact.
+ *
+ * @param[in]     solverBodies solver bodies
+ * @param[in,out] contact      contact data
+ * @param[in]     settings     solver pass parameters
+ * @param[in]     relaxation   fraction of the impulse applied
+ */
+inline void SolveContactRelaxed(
+    SolverBodies const& solverBodies, Contact& contact, ContactSolverSettings const& settings, float relaxation
+)
+{
+    float const initialLambda = contact.lagrangianMultiplier * settings.warmStartFactor;
+    float const initialFrictionLambda1 = contact.tangentLagrangianMultiplier1 * settings.warmStartFactor;
+    float const initialFrictionLambda2 = contact.tangentLagrangianMultiplier2 * settings.warmStartFactor;
+
+    float contactLambda = initialLambda;
+    float frictionLamda1 = initialFrictionLambda1;
+    float frictionLamda2 = initialFrictionLambda2;
+
+    SolveConstraints(
+        solverBodies, contact, settings.duration,
+        contactLambda, frictionLamda1, frictionLamda2, settings.baumgarteFactor
+    );
+
+    //Blends of the old and the new totals stay inside of the friction cone
+    contact.lagrangianMultiplier = initialLambda + (contactLambda - initialLambda) * relaxation;
+    contact.tangentLagrangianMultiplier1 = initialFrictionLambda1 + (frictionLamda1 - initialFrictionLambda1) * relaxation;
+    contact.tangentLagrangianMultiplier2 = initialFrictionLambda2 + (frictionLamda2 - initialFrictionLambda2) * relaxation;
+    contact.deltaVelocity = contact.deltaVelocity * (relaxation * settings.impulseFactor);
+}
+
+/**
+ * @brief Solves all contacts from the same velocities and then sums velocity changes of each body
+ *
+ * Both passes run in parallel and the result does not depend on the number of threads in the pool.
+ *
+ * @param[in,out] solver     solver data with the body contacts built
+ * @param[in,out] threadPool thread pool
+ * @param[in,out] contacts   contacts
+ * @param[in]     settings   solver pass parameters
+ */
+inline void SolveContactsJacobi(
+    SolverData& solver, ThreadPool& threadPool, std::vector<Contact>& contacts, ContactSolverSettings const& settings
+)
+{
+    SolverBodies& solverBodies = solver.bodies;
+    float const relaxation = solver.relaxation;
+
+    size_t const contactChunks = (contacts.size() + JACOBI_CHUNK_SIZE - 1) / JACOBI_CHUNK_SIZE;
+    threadPool.ParallelFor(contactChunks, [&solverBodies, &contacts, &settings, relaxation](size_t chunk) {
+        size_t const begin = chunk * JACOBI_CHUNK_SIZE;
+        size_t const end = glm::min(begin + JACOBI_CHUNK_SIZE, contacts.size());
+        for (size_t i = begin; i < end; ++i)
+        {
+            SolveContactRelaxed(solverBodies, contacts[i], settings, relaxation);
+        }
+    });
+
+    BodyContacts const& bodyContacts = solver.bodyContacts;
+    size_t const bodyChunks = (solverBodies.bodies.size() + JACOBI_CHUNK_SIZE - 1) / JACOBI_CHUNK_SIZE;
+    threadPool.ParallelFor(bodyChunks, [&solverBodies, &contacts, &bodyContacts](size_t chunk) {
+        size_t const begin = chunk * JACOBI_CHUNK_SIZE;
+        size_t const end = glm::min(begin + JACOBI_CHUNK_SIZE, solverBodies.bodies.size());
+        for (size_t i = begin; i < end; ++i)
+        {
+            SolverBody& body = solverBodies.bodies[i];
+            if (body.inverseMass == 0)
+            {
+                continue;
+            }
+
+            for (uint32_t j = bodyContacts.offsets[i]; j < bodyContacts.offsets[i + 1]; ++j)
+            {
+                uint32_t const slot = bodyContacts.slots[j];
+                Jacobian const& deltaVelocity = contacts[slot / 2].deltaVelocity;
+                body.linearVelocity += (slot % 2) ? deltaVelocity.nB : deltaVelocity.nA;
+                body.angularVelocity += (slot % 2) ? deltaVelocity.nwB : deltaVelocity.nwA;
+            }
+        }
+    });
+}
+
+/**
+ * @brief Returns partner contact of each contact if the block solver is used
+ * @param solver solver data with the contact order built
+ * @return partner contact indices or @c nullptr
+ */
+inline uint32_t const* GetContactPartners(SolverData const& solver)
+{
+    return solver.mode == SolverMode::SEQUENTIAL && solver.blockSolverEnabled ? solver.pairs.partners.data() : nullptr;
+}
+
+/**
+ * @brief Solves the contact, or its pair if the contact has a partner
+ * @param[in,out] solverBodies solver bodies
+ * @param[in,out] contacts     contacts
+ * @param[in]     partners     partner contact indices or @c nullptr
+ * @param[in]     index        contact index
+ * @param[in]     settings     solver pass parameters
+ */
+inline void SolveSequentialContact(
+    SolverBodies& solverBodies, std::vector<Contact>& contacts, uint32_t const* partners, uint32_t index,
+    ContactSolverSettings const& settings
+)
+{
+    uint32_t const partner = partners ? partners[index] : INVALID_CONTACT;
+    if (partner == INVALID_CONTACT)
+    {
+        SolveContact(solverBodies, contacts[index], settings);
+    }
+    //The pair is solved once, when its contact with the lower index is reached
+    else if (index < partner && !SolveContactPair(solverBodies, contacts[index], contacts[partner], settings))
+    {
+        SolveContact(solverBodies, contacts[index], settings);
+        SolveContact(solverBodies, contacts[partner], settings);
+    }
+}
+
+/**
+ * @brief Calculates contact graph distance of each island body to a static body
+ *
+ * Bodies touching a static body have the depth of 1. Islands without static contacts
+ * are measured from their first body.
+ *
+ * @param[in]     solver   solver data with the islands and the body contacts built
+ * @param[in]     contacts contacts
+ * @param[in,out] plan     iteration plan, receives the depths
+ */
+inline void CalculateIslandDepths(SolverData const& solver, std::vector<Contact> const& contacts, IslandIterations& plan)
+{
+    std::vector<SolverBody> const& bodies = solver.bodies.bodies;
+    BodyContacts const& bodyContacts = solver.bodyContacts;
+    Islands const& islands = solver.islands;
+
+    auto const getOther = [&contacts](uint32_t slot) {
+        Contact const& contact = contacts[slot / 2];
+        return (slot % 2) ? contact.aSolverBody : contact.bSolverBody;
+    };
+
+    plan.depths.assign(bodies.size(), 0);
+    for (Island const& island : islands.islands)
+    {
+        plan.queue.clear();
+        for (uint32_t i = 0; i < island.bodyCount; ++i)
+        {
+            uint32_t const body = islands.bodies[island.bodyOffset + i];
+            for (uint32_t j = bodyContacts.offsets[body]; j < bodyContacts.offsets[body + 1]; ++j)
+            {
+                if (bodies[getOther(bodyContacts.slots[j])].inverseMass == 0)
+                {
+                    plan.depths[body] = 1;
+                    plan.queue.push_back(body);
+                    break;
+                }
+            }
+        }
+        if (plan.queue.empty())
+        {
+            plan.depths[islands.bodies[island.bodyOffset]] = 1;
+            plan.queue.push_back(islands.bodies[island.bodyOffset]);
+        }
+
+        for (size_t front = 0; front < plan.queue.size(); ++front)
+        {
+            uint32_t const body = plan.queue[front];
+            for (uint32_t j = bodyContacts.offsets[body]; j < bodyContacts.offsets[body + 1]; ++j)
+            {
+                uint32_t const other = getOther(bodyContacts.slots[j]);
+                if (bodies[other].inverseMass != 0 && plan.depths[other] == 0)
+                {
+                    plan.depths[other] = plan.depths[body] + 1;
+                    plan.queue.push_back(other);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Picks velocity iterations of each island
+ *
+ * An island gets 2 * depth - 1 iterations, scaled up by up to two times when the island did not
+ * converge during the previous step. When the iterations exceed the budget, all islands are
+ * scaled down proportionally, keeping at least one iteration each.
+ * The number of bodies is not used: bodies side by side do not lengthen the path impulses
+ * travel through the island, only the depth does, and the cost of an island already grows
+ * with its contact count.
+ *
+ * @param[in,out] solver   solver data with the islands and the body contacts built
+ * @param[in]     contacts contacts
+ * @return largest number of iterations of an island
+ */
+inline uint32_t PlanIslandIterations(SolverData& solver, std::vector<Contact> const& contacts)
+{
+    IslandIterations& plan = solver.islandIterations;
+    Islands const& islands = solver.islands;
+    std::vector<scene::Handle> const& handles = solver.bodies.handles;
+
+    CalculateIslandDepths(solver, contacts, plan);
+
+    std::vector<float> desired(islands.islands.size());
+    float cost = 0.0f;
+    for (size_t i = 0; i < islands.islands.size(); ++i)
+    {
+        Island const& island = islands.islands[i];
+        uint32_t depth = 1;
+        float residual = 0.0f;
+        for (uint32_t j = 0; j < island.bodyCount; ++j)
+        {
+            uint32_t const body = islands.bodies[island.bodyOffset + j];
+            depth = glm::max(depth, plan.depths[body]);
+            if (handles[body] <= plan.bodyResiduals.size())
+            {
+                residual = glm::max(residual, plan.bodyResiduals[handles[body] - 1]);
+            }
+        }
+
+        desired[i] = (2.0f * depth - 1.0f) * (1.0f + glm::min(residual, 1.0f));
+        desired[i] = glm::min(desired[i], static_cast<float>(MAX_ISLAND_VELOCITY_ITERATIONS));
+        cost += desired[i] * island.contactCount;
+    }
+
+    float const scale = (solver.iterationBudget != 0 && cost > solver.iterationBudget)
+        ? solver.iterationBudget / cost : 1.0f;
+
+    uint32_t maxIterations = 0;
+    plan.iterations.resize(islands.islands.size());
+    plan.residuals.assign(islands.islands.size(), 0.0f);
+    for (size_t i = 0; i < islands.islands.size(); ++i)
+    {
+        plan.iterations[i] = glm::max(static_cast<uint32_t>(desired[i] * scale + 0.5f), 1u);
+        maxIterations = glm::max(maxIterations, plan.iterations[i]);
+    }
+
+    return maxIterations;
+}
+
+/**
+ * @brief Solves contacts of the islands that have not used up their planned iterations
+ *
+ * Islands record the relative residual of their last iteration.
+ *
+ * @param[in,out] solver     solver data with the iteration plan built
+ * @param[in,out] threadPool thread pool
+ * @param[in,out] contacts   contacts
+ * @param[in]     settings   solver pass parameters
+ * @param[in]     iteration  index of the current iteration
+ * @return number of contacts solved
+ */
+inline uint32_t SolveIslandContacts(
+    SolverData& solver, ThreadPool& threadPool, std::vector<Contact>& contacts, ContactSolverSettings const& settings,
+    uint32_t iteration
+)
+{
+    SolverBodies& solverBodies = solver.bodies;
+    Islands const& islands = solver.islands;
+    IslandIterations& plan = solver.islandIterations;
+    uint32_t const* partners = GetContactPartners(solver);
+
+    threadPool.ParallelFor(islands.islands.size(),
+        [&solverBodies, &contacts, &settings, &islands, &plan, partners, iteration](size_t index) {
+            if (iteration >= plan.iterations[index])
+            {
+                return;
+            }
+
+            Island const& island = islands.islands[index];
+            uint32_t const* indices = islands.contacts.data() + island.contactOffset;
+            bool const isLast = iteration + 1 == plan.iterations[index];
+            float change = 0.0f;
+            float total = 0.0f;
+            for (uint32_t i = 0; i < island.contactCount; ++i)
+            {
+                Contact const& contact = contacts[indices[i]];
+                float const previous = contact.lagrangianMultiplier;
+                SolveSequentialContact(solverBodies, contacts, partners, indices[i], settings);
+
+                if (isLast)
+                {
+                    change += glm::abs(contact.lagrangianMultiplier - previous);
+                    total += glm::abs(contact.lagrangianMultiplier);
+                }
+            }
+
+            if (isLast)
+            {
+                plan.residuals[index] = change / (total + epona::fp::g_floatingPointThreshold);
+            }
+        }
+    );
+
+    uint32_t solved = 0;
+    for (size_t i = 0; i < islands.islands.size(); ++i)
+    {
+        solved += iteration < plan.iterations[i] ? islands.islands[i].contactCount : 0;
+    }
+    return solved;
+}
+
+/**
+ * @brief Saves residuals of the islands for the next step
+ *
+ * Residuals of the bodies that left all islands are reset.
+ *
+ * @param[in,out] solver solver data with the islands solved
+ */
+inline void StoreIslandResiduals(SolverData& solver)
+{
+    IslandIterations& plan = solver.islandIterations;
+    Islands const& islands = solver.islands;
+    std::vector<scene::Handle> const& handles = solver.bodies.handles;
+
+    for (scene::Handle const handle : plan.residualHandles)
+    {
+        plan.bodyResiduals[handle - 1] = 0.0f;
+    }
+    plan.residualHandles.clear();
+
+    for (size_t i = 0; i < islands.islands.size(); ++i)
+    {
+        Island const& island = islands.islands[i];
+        for (uint32_t j = 0; j < island.bodyCount; ++j)
+        {
+            scene::Handle const handle = handles[islands.bodies[island.bodyOffset + j]];
+            if (plan.bodyResiduals.size() < handle)
+            {
+                plan.bodyResiduals.resize(handle, 0.0f);
+            }
+            plan.bodyResiduals[handle - 1] = plan.residuals[i];
+            plan.residualHandles.push_back(handle);
+        }
+    }
+}
+
+/**
+ * @brief Solves contact velocity constraints in the order defined by the solver mode
+ * @param[in,out] solver     solver data with the contact order built
+ * @param[in,out] threadPool thread pool
+ * @param[in,out] contacts   contacts
+ * @param[in]     settings   solver pass parameters
+ */
+inline void SolveContacts(
+    SolverData& solver, ThreadPool& threadPool, std::vector<Contact>& contacts, ContactSolverSettings const& settings
+)
+{
+    if (solver.mode == SolverMode::JACOBI)
+    {
+        SolveContactsJacobi(solver, threadPool, contacts, settings);
+        return;
+    }
+
+    SolverBodies& solverBodies = solver.bodies;
+    SimdInstructionSet const instructionSet = solver.instructionSet;
+    uint32_t const* partners = GetContactPartners(solver);
+    ForEachContact(solver, threadPool,
+        [&solverBodies, &contacts, &settings, partners](uint32_t index) {
+            SolveSequentialContact(solverBodies, contacts, partners, index, settings);
+        },
+        [&solverBodies, &contacts, &settings, instructionSet](uint32_t const* indices, uint32_t count) {
+            SolveContactBatch(solverBodies, contacts, indices, count, settings, instructionSet);
+        }
+    );
+}
+
+/**
+ * @brief Solves contact position constraints in the order defined by the solver mode
+ * @param[in,out] solver     solver data with the contact order built
+ * @param[in,out] threadPool thread pool
+ * @param[in,out] contacts   contacts
+ * @param[in]     duration   delta time of the frame
+ */
+inline void SolvePositionContacts(
+    SolverData& solver, ThreadPool& threadPool, std::vector<Contact>& contacts, float duration
+)
+{
+    SolverBodies& solverBodies = solver.bodies;
+    ForEachContact(solver, threadPool,
+        [&solverBodies, &contacts, duration](uint32_t index) {
+            SolvePositionConstraint(solverBodies, contacts[index], duration);
+        },
+        [&solverBodies, &contacts, duration](uint32_t const* indices, uint32_t count) {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                SolvePositionConstraint(solverBodies, contacts[indices[i]], duration);
+            }
+        }
+    );
+}
+
+/**
+ * @brief Saves lagrangian multipliers the first velocity iteration starts from
+ * @param[in]  contacts        contacts
+ * @param[in]  joints          joint constraints
+ * @param[in]  warmStartFactor warm start factor of the first iteration
+ * @param[out] multipliers     saved lagrangian multipliers
+ */
+inline void SaveLagrangianMultipliers(
+    std::vector<Contact> const& contacts, JointRows const& joints, float warmStartFactor,
+    std::vector<float>& multipliers
+)
+{
+    multipliers.clear();
+    multipliers.reserve(contacts.size() * 3 + joints.rows.size());
+    for (Contact const& contact : contacts)
+    {
+        multipliers.push_back(contact.lagrangianMultiplier * warmStartFactor);
+        multipliers.push_back(contact.tangentLagrangianMultiplier1 * warmStartFactor);
+        multipliers.push_back(contact.tangentLagrangianMultiplier2 * warmStartFactor);
+    }
+    for (JointRow const& row : joints.rows)
+    {
+        multipliers.push_back(row.lagrangianMultiplier);
+    }
+}
+
+/**
+ * @brief Calculates total change of the lagrangian multipliers since they were saved and saves them again
+ * @param[in]     contacts    contacts
+ * @param[in]     joints      joint constraints
+ * @param[in,out] multipliers saved lagrangian multipliers
+ * @return sum of the absolute lagrangian multiplier changes
+ */
+inline float UpdateLagrangianMultipliers(
+    std::vector<Contact> const& contacts, JointRows const& joints, std::vector<float>& multipliers
+)
+{
+    float residual = 0.0f;
+    float* saved = multipliers.data();
+    auto const update = [&residual, &saved](float multiplier) {
+        residual += glm::abs(multiplier - *saved);
+        *saved++ = multiplier;
+    };
+
+    for (Contact const& contact : contacts)
+    {
+        update(contact.lagrangianMultiplier);
+        update(contact.tangentLagrangianMultiplier1);
+        update(contact.tangentLagrangianMultiplier2);
+    }
+    for (JointRow const& row : joints.rows)
+    {
+        update(row.lagrangianMultiplier);
+    }
+
+    return residual;
+}
+
+/**
+ * @brief Calculates the largest contact penetration left after the bodies move with the solved velocities
+ * @param solverBodies solver bodies
+ * @param contacts     contacts
+ * @param duration     delta time of the frame
+ * @return largest expected penetration, 0 if all contacts separate
+ */
+inline float CalculateMaxPenetration(
+    SolverBodies const& solverBodies, std::vector<Contact> const& contacts, float duration
+)
+{
+    float maxPenetration = 0.0f;
+    for (Contact const& contact : contacts)
+    {
+        SolverBody const& aBody = solverBodies.bodies[contact.aSolverBody];
+        SolverBody const& bBody = solverBodies.bodies[contact.bSolverBody];
+
+        glm::vec3 const& n = contact.manifold.normal;
+        glm::vec3 const nwA = glm::cross(n, contact.aRelativePosition);
+        glm::vec3 const nwB = glm::cross(contact.bRelativePosition, n);
+        float const separationSpeed =
+            glm::dot(n, bBody.linearVelocity + bBody.pseudoLinearVelocity
+                - aBody.linearVelocity - aBody.pseudoLinearVelocity)
+            + glm::dot(nwA, aBody.angularVelocity + aBody.pseudoAngularVelocity)
+            + glm::dot(nwB, bBody.angularVelocity + bBody.pseudoAngularVelocity);
+
+        maxPenetration = glm::max(maxPenetration, contact.manifold.penetration - separationSpeed * duration);
+    }
+
+    return maxPenetration;
+}
+
+/**
+ * @brief Solves contact and joint velocity constraints for the configured number of iterations
+ *
+ * Joints are solved sequentially after the contacts of each iteration.
+ * The first iteration starts from the stored lagrangian multipliers scaled by the warm start factor,
+ * subsequent iterations continue from the totals of the previous one. The residual of each iteration
+ * is recorded and the iterations stop early once it falls below the solver tolerance.
+ * With the adaptive iterations each island stops after its own planned number of iterations.
+ *
+ * @param[in,out] solver     solver data with the contact order built
+ * @param[in,out] threadPool thread pool
+ * @param[in,out] contacts   contacts
+ * @param[in]     settings   solver pass parameters of the first iteration
+ */
+inline void SolveContactVelocities(
+    SolverData& solver, ThreadPool& threadPool, std::vector<Contact>& contacts, ContactSolverSettings settings
+)
+{
+    CalculateRestitutionSpeeds(solver.bodies, contacts);
+    SaveLagrangianMultipliers(contacts, solver.joints, settings.warmStartFactor, solver.multipliers);
+    solver.statistics.residuals.clear();
+    solver.statistics.contactSolves = 0;
+
+    bool const isAdaptive = solver.adaptiveIterations && solver.mode == SolverMode::SEQUENTIAL;
+    uint32_t const iterations = isAdaptive ? PlanIslandIterations(solver, contacts) : solver.velocityIterations;
+
+    for (uint32_t iteration = 0; iteration < iterations; ++iteration)
+    {
+        if (isAdaptive)
+        {
+            solver.statistics.contactSolves += SolveIslandContacts(solver, threadPool, contacts, settings, iteration);
+        }
+        else
+        {
+            SolveContacts(solver, threadPool, contacts, settings);
+            solver.statistics.contactSolves += static_cast<uint32_t>(contacts.size());
+        }
+        SolveJointRows(solver.bodies, solver.joints);
+        settings.warmStartFactor = 1.0f;
+
+        float const residual = UpdateLagrangianMultipliers(contacts, solver.joints, solver.multipliers);
+        solver.statistics.residuals.push_back(residual);
+        if (residual < solver.tolerance)
+        {
+            break;
+        }
+    }
+
+    if (isAdaptive)
+    {
+        StoreIslandResiduals(solver);
+    }
+}
+
+/**
+ * @brief Resolves contact penetrations with pseudo velocities and moves the bodies
+ * @param[in,out] assetManager asset manager
+ * @param[in,out] solver       solver data with the contact order built
+ * @param[in,out] threadPool   thread pool
+ * @param[in,out] contacts     contacts
+ * @param[in]     duration     delta time of the frame
+ */
+inline void SolveContactPositions(
+    scene::AssetManager& assetManager, SolverData& solver, ThreadPool& threadPool,
+    std::vector<Contact>& contacts, float duration
+)
+{
+    for (uint32_t iteration = 0; iteration < solver.positionIterations; ++iteration)
+    {
+        SolvePositionContacts(solver, threadPool, contacts, duration);
+    }
+
+    ApplyPseudoVelocities(assetManager, solver.bodies, duration);
+}
+
+/**
+ * @brief Returns Baumgarte stabilization factor of the position correction method
+ * @param positionCorrection position correction method
+ * @return Baumgarte stabilization factor
+ */
+inline float GetBaumgarteFactor(PositionCorrection positionCorrection)
+{
+    return positionCorrection == PositionCorrection::BAUMGARTE ? 0.1f : 0.0f;
+}
+
 /**
  * @brief Resolves collisions
  *
  * @note This method is inteded to be called once during the pipeline execution
  *
  * @param[in,out] assetManager        asset manager
+ * @param[in,out] solver              solver data
+ * @param[in,out] threadPool          thread pool used by the solver
  * @param[in,out] persistentContacts  persistent contacts
  * @param[in,out] contacts            contacts information
  * @param[in]     previousContacts    previous frame contacts
@@ -222,6 +1402,8 @@ inline void SolveConstraints(
  */
 inline void ResolveContacts(
     scene::AssetManager& assetManager,
+    SolverData& solver,
+    ThreadPool& threadPool,
     std::vector<Contact>& persistentContacts,
     std::vector<Contact>& contacts,
     std::vector<Contact> const& previousContacts,
@@ -229,38 +1411,25 @@ inline void ResolveContacts(
     float persistentThreshold = 1e-3f
 )
 {
-    //Solve constraints
-    float contactLambda = 0;
-    float frictionLamda1 = 0;
-    float frictionLamda2 = 0;
-    for (auto& contact : contacts)
+    LoadSolverBodies(assetManager, contacts, solver.bodies);
+    LoadJointRows(assetManager, solver.bodies, duration, solver.joints);
+    BuildContactOrder(solver, contacts);
+
+    ContactSolverSettings settings;
+    settings.duration = duration;
+    settings.baumgarteFactor = GetBaumgarteFactor(solver.positionCorrection);
+    SolveContactVelocities(solver, threadPool, contacts, settings);
+
+    if (solver.positionCorrection == PositionCorrection::SPLIT_IMPULSE)
     {
-        SolveConstraints(
-            assetManager, contact, duration, contactLambda, frictionLamda1, frictionLamda2
-        );
+        SolveContactPositions(assetManager, solver, threadPool, contacts, duration);
     }
+    solver.statistics.maxPenetration = CalculateMaxPenetration(solver.bodies, contacts, duration);
 
     //Set current contacts buffer and find persistent contacts
     DetectPersistentContacts(contacts, previousContacts, persistentThreshold*persistentThreshold, persistentContacts);
 
-    //Resolve constraints
-    for (auto& contact : contacts)
-    {
-        auto& aBody = assetManager.GetAsset(assetManager.GetBodies(), contact.aBodyHandle);
-        auto& bBody = assetManager.GetAsset(assetManager.GetBodies(), contact.bBodyHandle);
-
-        aBody.linearMotion.velocity += contact.deltaVelocity.nA;
-        aBody.angularMotion.velocity += contact.deltaVelocity.nwA;
-        bBody.linearMotion.velocity += contact.deltaVelocity.nB;
-        bBody.angularMotion.velocity += contact.deltaVelocity.nwB;
-
-#ifndef NDEBUG
-        auto a = assetManager.GetAsset(assetManager.GetBodies(), contact.aBodyHandle).angularMotion.velocity;
-        auto b = assetManager.GetAsset(assetManager.GetBodies(), contact.bBodyHandle).angularMotion.velocity;
-        assert(!std::isinf(a.x) && !std::isinf(a.y) && !std::isinf(a.z));
-        assert(!std::isinf(b.x) && !std::isinf(b.y) && !std::isinf(b.z));
-#endif
-    }
+    StoreSolverBodies(assetManager, solver.bodies);
 }
 
 /**
@@ -269,57 +1438,110 @@ inline void ResolveContacts(
  * @note This method is inteded to be called once during the pipeline execution
  *
  * @param[in,out] assetManager       asset manager
+ * @param[in,out] solver             solver data
+ * @param[in,out] threadPool         thread pool used by the solver
  * @param[in,out] persistentContacts persistent contacts
  * @param[in]     duration           delta time of the frame
  * @param[in]     persistentFactor   factors amount of energy applied during persistent contact resolution
  */
 inline void ResolvePersistantContacts(
     scene::AssetManager& assetManager,
+    SolverData& solver,
+    ThreadPool& threadPool,
     std::vector<Contact>& persistentContacts,
     float duration,
     float persistentFactor = 0.05f
 )
 {
-    //Solve constraints
-    for (auto& contact : persistentContacts)
-    {
-        float lagrangianMultiplier = contact.lagrangianMultiplier;
-        float tangentLagrangianMultiplier1 = contact.tangentLagrangianMultiplier1;
-        float tangentLagrangianMultiplier2 = contact.tangentLagrangianMultiplier2;
+    //Joints are solved only along with the contacts detected during the frame
+    LoadSolverBodies(assetManager, persistentContacts, solver.bodies);
+    solver.joints.rows.clear();
+    solver.joints.links.clear();
+    BuildContactOrder(solver, persistentContacts);
 
-        float constexpr reduction = 0.01f;
-        lagrangianMultiplier *= reduction;
-        tangentLagrangianMultiplier1 *= reduction;
-        tangentLagrangianMultiplier2 *= reduction;
+    ContactSolverSettings settings;
+    settings.duration = duration;
+    settings.baumgarteFactor = GetBaumgarteFactor(solver.positionCorrection);
+    settings.warmStartFactor = 0.01f;
+    settings.impulseFactor = persistentFactor;
+    CalculateRestitutionSpeeds(solver.bodies, persistentContacts);
+    SolveContacts(solver, threadPool, persistentContacts, settings);
 
-        SolveConstraints(
-            assetManager, contact, duration,
-            lagrangianMultiplier, tangentLagrangianMultiplier1, tangentLagrangianMultiplier2
-        );
+    StoreSolverBodies(assetManager, solver.bodies);
+}
+
+/**
+ * @brief Updates contact points and penetrations from the body motion since the contact detection
+ *
+ * Contact points move rigidly with their bodies while the contact normal stays fixed.
+ *
+ * @param[in]     assetManager asset manager
+ * @param[in]     solverBodies solver bodies with the transforms at the time of the detection
+ * @param[in,out] contacts     contacts
+ */
+inline void UpdateContactSeparations(
+    scene::AssetManager& assetManager, SolverBodies const& solverBodies, std::vector<Contact>& contacts
+)
+{
+    std::vector<scene::Asset<mechanics::Body>>& bodies = assetManager.GetBodies();
+    for (Contact& contact : contacts)
+    {
+        SolverBody const& aSolverBody = solverBodies.bodies[contact.aSolverBody];
+        SolverBody const& bSolverBody = solverBodies.bodies[contact.bSolverBody];
+        mechanics::Body const& aBody = assetManager.GetAsset(bodies, contact.aBodyHandle);
+        mechanics::Body const& bBody = assetManager.GetAsset(bodies, contact.bBodyHandle);
 
-        contact.lagrangianMultiplier = lagrangianMultiplier;
-        contact.tangentLagrangianMultiplier1 = tangentLagrangianMultiplier1;
-        contact.tangentLagrangianMultiplier2 = tangentLagrangianMultiplier2;
+        contact.aRelativePosition = aBody.angularMotion.orientation * glm::conjugate(aSolverBody.orientation)
+            * (contact.manifold.points.aWorldSpace - aSolverBody.position);
+        contact.bRelativePosition = bBody.angularMotion.orientation * glm::conjugate(bSolverBody.orientation)
+            * (contact.manifold.points.bWorldSpace - bSolverBody.position);
+
+        glm::vec3 const aDisplacement =
+            aBody.linearMotion.position + contact.aRelativePosition - contact.manifold.points.aWorldSpace;
+        glm::vec3 const bDisplacement =
+            bBody.linearMotion.position + contact.bRelativePosition - contact.manifold.points.bWorldSpace;
+        contact.manifold.penetration =
+            contact.initialPenetration - glm::dot(bDisplacement - aDisplacement, contact.manifold.normal);
     }
+}
 
-    //Resolve constraints
-    for (auto& contact : persistentContacts)
-    {
-        auto& aBody = assetManager.GetAsset(assetManager.GetBodies(), contact.aBodyHandle);
-        auto& bBody = assetManager.GetAsset(assetManager.GetBodies(), contact.bBodyHandle);
+/**
+ * @brief Resolves contacts detected at the beginning of the frame during a single sub-step
+ *
+ * @note This method is intended to be called after each sub-step integration,
+ * the solver bodies must be loaded from the contacts before the first sub-step
+ *
+ * @param[in,out] assetManager asset manager
+ * @param[in,out] solver       solver data
+ * @param[in,out] threadPool   thread pool used by the solver
+ * @param[in,out] contacts     contacts detected at the beginning of the frame
+ * @param[in]     duration     delta time of the sub-step
+ */
+inline void ResolveSubstepContacts(
+    scene::AssetManager& assetManager,
+    SolverData& solver,
+    ThreadPool& threadPool,
+    std::vector<Contact>& contacts,
+    float duration
+)
+{
+    ReloadSolverBodies(assetManager, solver.bodies);
+    UpdateContactSeparations(assetManager, solver.bodies, contacts);
+    LoadJointRows(assetManager, solver.bodies, duration, solver.joints);
+    BuildContactOrder(solver, contacts);
 
-        aBody.linearMotion.velocity += contact.deltaVelocity.nA  * persistentFactor;
-        aBody.angularMotion.velocity += contact.deltaVelocity.nwA * persistentFactor;
-        bBody.linearMotion.velocity += contact.deltaVelocity.nB  * persistentFactor;
-        bBody.angularMotion.velocity += contact.deltaVelocity.nwB * persistentFactor;
+    ContactSolverSettings settings;
+    settings.duration = duration;
+    settings.baumgarteFactor = GetBaumgarteFactor(solver.positionCorrection);
+    SolveContactVelocities(solver, threadPool, contacts, settings);
 
-#ifndef NDEBUG
-        auto a = assetManager.GetAsset(assetManager.GetBodies(), contact.aBodyHandle).angularMotion.velocity;
-        auto b = assetManager.GetAsset(assetManager.GetBodies(), contact.bBodyHandle).angularMotion.velocity;
-        assert(!std::isinf(a.x) && !std::isinf(a.y) && !std::isinf(a.z));
-        assert(!std::isinf(b.x) && !std::isinf(b.y) && !std::isinf(b.z));
-#endif
+    if (solver.positionCorrection == PositionCorrection::SPLIT_IMPULSE)
+    {
+        SolveContactPositions(assetManager, solver, threadPool, contacts, duration);
     }
+    solver.statistics.maxPenetration = CalculateMaxPenetration(solver.bodies, contacts, duration);
+
+    StoreSolverBodies(assetManager, solver.bodies);
 }
 
 } // namespace collision
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_COLORING_HPP
+#define PEGASUS_COLORING_HPP
+
+#include <pegasus/Contact.hpp>
+#include <pegasus/SolverBody.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace pegasus
+{
+namespace collision
+{
+
+//!Maximum number of colors assigned to the constraints
+uint32_t const MAX_CONSTRAINT_COLORS = 64;
+
+/**
+ * @brief Stores contacts partitioned into batches without shared bodies
+ *
+ * No two contacts of a batch share a body with a finite mass, so the contacts
+ * of a batch can be solved in any order or in parallel. Contacts that did not
+ * fit into any of the colors are stored separately and must be solved sequentially.
+ */
+struct ColoredBatches
+{
+    //!Contact indices grouped by batch
+    std::vector<uint32_t> contacts;
+
+    //!Batch offsets in the contacts buffer, the last element is the total number of colored contacts
+    std::vector<uint32_t> offsets;
+
+    //!Indices of the contacts that did not fit into any of the colors
+    std::vector<uint32_t> overflow;
+
+    //!Mask of the colors used by each solver body
+    std::vector<uint64_t> bodyColors;
+
+    //!Color of each contact
+    std::vector<uint32_t> contactColors;
+
+    //!Fill positions of the batches
+    std::vector<uint32_t> cursors;
+};
+
+/**
+ * @brief Returns index of the lowest zero bit
+ * @param mask bit mask, must not have all bits set
+ * @return bit index
+ */
+inline uint32_t FindFirstZeroBit(uint64_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward64(&index, ~mask);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(~mask));
+#endif
+}
+
+/**
+ * @brief Partitions contacts into batches using greedy graph coloring
+ *
+ * Each contact gets the lowest color that is not used yet by any of its bodies
+ * with a finite mass. Contacts keep their relative order inside a batch.
+ *
+ * @param[in] solverBodies solver bodies referenced by the contacts
+ * @param[in] contacts contacts
+ * @param[out] batches colored batches
+ */
+inline void BuildColoredBatches(
+    SolverBodies const& solverBodies, std::vector<Contact> const& contacts, ColoredBatches& batches
+)
+{
+    std::vector<SolverBody> const& bodies = solverBodies.bodies;
+    uint32_t const overflowColor = MAX_CONSTRAINT_COLORS;
+
+    batches.bodyColors.assign(bodies.size(), 0);
+    batches.contactColors.resize(contacts.size());
+    batches.offsets.assign(MAX_CONSTRAINT_COLORS + 1, 0);
+    batches.overflow.clear();
+
+    uint32_t colorCount = 0;
+    for (uint32_t i = 0; i < contacts.size(); ++i)
+    {
+        uint32_t const a = contacts[i].aSolverBody;
+        uint32_t const b = contacts[i].bSolverBody;
+        bool const aDynamic = bodies[a].inverseMass != 0;
+        bool const bDynamic = bodies[b].inverseMass != 0;
+
+        uint64_t const usedColors = (aDynamic ? batches.bodyColors[a] : 0) | (bDynamic ? batches.bodyColors[b] : 0);
+        if (usedColors == ~uint64_t(0))
+        {
+            batches.contactColors[i] = overflowColor;
+            batches.overflow.push_back(i);
+            continue;
+        }
+
+        uint32_t const color = FindFirstZeroBit(usedColors);
+        uint64_t const colorBit = uint64_t(1) << color;
+        if (aDynamic)
+        {
+            batches.bodyColors[a] |= colorBit;
+        }
+        if (bDynamic)
+        {
+            batches.bodyColors[b] |= colorBit;
+        }
+
+        batches.contactColors[i] = color;
+        ++batches.offsets[color + 1];
+        colorCount = std::max(colorCount, color + 1);
+    }
+
+    //Calculate offsets
+    batches.offsets.resize(colorCount + 1);
+    for (uint32_t color = 1; color <= colorCount; ++color)
+    {
+        batches.offsets[color] += batches.offsets[color - 1];
+    }
+
+    //Fill batches
+    batches.contacts.resize(batches.offsets.back());
+    batches.cursors.assign(batches.offsets.begin(), batches.offsets.end() - 1);
+    for (uint32_t i = 0; i < contacts.size(); ++i)
+    {
+        uint32_t const color = batches.contactColors[i];
+        if (color != overflowColor)
+        {
+            batches.contacts[batches.cursors[color]++] = i;
+        }
+    }
+}
+
+} // namespace collision
+} // namespace pegasus
+#endif // PEGASUS_COLORING_HPP
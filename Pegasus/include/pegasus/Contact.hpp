@@ -7,6 +7,7 @@
 #define PEGASUS_CONTACT_HPP
 
 #include <pegasus/Asset.hpp>
+#include <pegasus/SymmetricMatrix.hpp>
 #include <Arion/Intersection.hpp>
 #include <glm/glm.hpp>
 
@@ -82,10 +83,10 @@ struct MassMatrix
         };
     }
 
-    glm::mat3 massA = glm::mat3(1);
-    glm::mat3 inertiaA = glm::mat3(1);
-    glm::mat3 massB = glm::mat3(1);
-    glm::mat3 inertiaB = glm::mat3(1);
+    float massA = 1.0f;
+    mechanics::SymmetricMatrix3 inertiaA = mechanics::SymmetricMatrix3(glm::mat3(1));
+    float massB = 1.0f;
+    mechanics::SymmetricMatrix3 inertiaB = mechanics::SymmetricMatrix3(glm::mat3(1));
 };
 
 /**
@@ -110,6 +111,10 @@ struct Contact
         , manifold(manifold)
         , restitution(restitution)
         , friction(friction)
+        , initialPenetration(manifold.penetration)
+        , restitutionSpeed(0.0f)
+        , aSolverBody(0)
+        , bSolverBody(0)
         , lagrangianMultiplier(0.0f)
         , tangentLagrangianMultiplier1(0.0f)
         , tangentLagrangianMultiplier2(0.0f)
@@ -127,6 +132,20 @@ struct Contact
     float restitution;
     float friction;
 
+    //!Penetration at the time of the detection
+    float initialPenetration;
+
+    //!Separation speed targeted by the restitution, calculated once before the velocity iterations
+    float restitutionSpeed;
+
+    //!Solver body indices
+    uint32_t aSolverBody;
+    uint32_t bSolverBody;
+
+    //!Contact points relative to the centers of mass of the bodies
+    glm::vec3 aRelativePosition = { 0, 0, 0 };
+    glm::vec3 bRelativePosition = { 0, 0, 0 };
+
     //!Contact constraint resolution data
     Jacobian deltaVelocity;
 
@@ -199,6 +199,72 @@ private:
     float m_waterHeight;
     float m_liquidDensity;
 };
+
+/**
+ * @brief Scene wide force field applied to the dynamic bodies of the selected groups
+ *
+ * Combines a mass independent acceleration such as gravity with drag relative
+ * to the velocity of the medium such as wind.
+ */
+struct GlobalField
+{
+    /**
+     * @brief Calculates force applied to the body, regardless of its groups
+     *
+     * The drag is calculated by the following equation:
+     * F = -u * (k1 + k2*s)
+     * Where u and s are velocity and speed of the body relative to the flow.
+     * @param body body data
+     * @return applied force
+     */
+    glm::vec3 CalculateForce(mechanics::Body const& body) const;
+
+    /**
+     * @brief Calculates drag torque applied to the spinning body
+     * @param body body data
+     * @return applied torque
+     */
+    glm::vec3 CalculateTorque(mechanics::Body const& body) const;
+
+    //!Acceleration applied to the bodies regardless of their mass
+    glm::vec3 acceleration = glm::vec3(0);
+
+    //!Velocity of the medium the drag is relative to
+    glm::vec3 flowVelocity = glm::vec3(0);
+
+    //!Drag factor of the relative speed
+    float linearDrag = 0.0f;
+
+    //!Drag factor of the squared relative speed
+    float quadraticDrag = 0.0f;
+
+    //!Groups of the bodies the field applies to
+    uint32_t groupMask = ~0u;
+};
+
+/**
+ * @brief Inverse square attraction between the bodies of the selected groups
+ *
+ * Attracting bodies are put into a Barnes-Hut octree each step, so the force
+ * on a body is calculated in O(log N) instead of visiting every other body.
+ */
+struct MutualAttraction
+{
+    //!Force scale, the bodies attract with G * m1 * m2 / r^2
+    float gravitationalConstant = 1.0f;
+
+    //!Ratio of the octree node size to its distance below which the node is approximated by its center of mass
+    float openingAngle = 0.7f;
+
+    //!Distance that limits the force between close bodies
+    float softening = 0.01f;
+
+    //!Groups of the bodies the attraction applies to
+    uint32_t groupMask = ~0u;
+
+    //!Groups of the bodies that attract others
+    uint32_t sourceMask = ~0u;
+};
 } // namespace force
 } // namespace pegasus
 
@@ -0,0 +1,573 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_FORCE_REGISTRY_HPP
+#define PEGASUS_FORCE_REGISTRY_HPP
+
+#include <pegasus/Asset.hpp>
+#include <pegasus/Body.hpp>
+#include <pegasus/Force.hpp>
+#include <Epona/FloatingPoint.hpp>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace pegasus
+{
+namespace scene
+{
+
+//!Index of a force type that is not registered
+uint32_t const INVALID_FORCE_TYPE = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Force bind resolved to the body and force indices
+ */
+struct BoundForce
+{
+    uint32_t body;
+    uint32_t force;
+};
+
+/**
+ * @brief Consecutive range of bodies the forces are applied to
+ */
+struct ForceTargets
+{
+    //!Index of the first body of the range
+    uint32_t begin;
+
+    //!Number of bodies in the range
+    uint32_t count;
+
+    //!Body of each index in the range, null for the bodies that are skipped
+    mechanics::Body* const* bodies;
+};
+
+/**
+ * @brief Adds force of the instance to the body
+ * @tparam Force type of the force
+ * @param[in]     force    force instance
+ * @param[in,out] body     body data
+ * @param[in]     duration force duration
+ */
+template < typename Force >
+void ApplyForce(Force const& force, mechanics::Body& body, float duration)
+{
+    body.linearMotion.force += force.CalculateForce(body) * duration;
+}
+
+/**
+ * @brief Adds drag force and drag torque of the spinning body
+ * @param[in]     drag     drag instance
+ * @param[in,out] body     body data
+ * @param[in]     duration force duration
+ */
+inline void ApplyForce(force::Drag const& drag, mechanics::Body& body, float duration)
+{
+    body.linearMotion.force += drag.CalculateForce(body) * duration;
+
+    glm::vec3 const velocity = body.linearMotion.velocity;
+    body.linearMotion.velocity = body.angularMotion.velocity;
+    body.angularMotion.torque += drag.CalculateForce(body) * duration;
+    body.linearMotion.velocity = velocity;
+
+    {
+        if (epona::fp::IsZero(body.angularMotion.torque.x))
+            body.angularMotion.torque.x = 0;
+        if (epona::fp::IsZero(body.angularMotion.torque.y))
+            body.angularMotion.torque.y = 0;
+        if (epona::fp::IsZero(body.angularMotion.torque.z))
+            body.angularMotion.torque.z = 0;
+    }
+}
+
+/**
+ * @brief Checks if the force type calculates the force of a single body
+ *
+ * Such types provide glm::vec3 CalculateForce(mechanics::Body const&) const.
+ *
+ * @tparam Force type of the force
+ */
+template < typename Force, typename = void >
+struct HasBodyForce : std::false_type
+{
+};
+
+template < typename Force >
+struct HasBodyForce<Force, decltype(
+    std::declval<Force const&>().CalculateForce(std::declval<mechanics::Body const&>()), void()
+)> : std::true_type
+{
+};
+
+/**
+ * @brief Checks if the force type calculates the forces of all bound bodies at once
+ *
+ * Such types provide void CalculateForces(mechanics::Body const* const* bodies, glm::vec3* forces,
+ * glm::vec3* torques, size_t count) const, which is preferred over the single body calculation.
+ * The forces and torques are zero on the call and are written for each of the count bodies.
+ *
+ * @tparam Force type of the force
+ */
+template < typename Force, typename = void >
+struct HasBatchedForces : std::false_type
+{
+};
+
+template < typename Force >
+struct HasBatchedForces<Force, decltype(
+    std::declval<Force const&>().CalculateForces(
+        std::declval<mechanics::Body const* const*>(), std::declval<glm::vec3*>(), std::declval<glm::vec3*>(),
+        std::declval<size_t>()
+    ), void()
+)> : std::true_type
+{
+};
+
+/**
+ * @brief Stores binds of the force type and the way they are applied
+ */
+class ForceStorageBase
+{
+public:
+    virtual ~ForceStorageBase() = default;
+
+    /**
+     * @brief Makes a copy of the storage
+     * @return storage copy
+     */
+    virtual std::unique_ptr<ForceStorageBase> Clone() const = 0;
+
+    /**
+     * @brief Resolves active binds to the body and force indices sorted by the body index
+     */
+    virtual void SortBinds() = 0;
+
+    /**
+     * @brief Adds forces of the sorted binds to the bodies of the range
+     * @param targets  bodies of the range
+     * @param duration force duration
+     */
+    virtual void ApplyForces(ForceTargets const& targets, float duration) const = 0;
+
+    /**
+     * @brief Adds batched forces of the sorted binds to the body forces
+     *
+     * Sleeping bodies and bodies with an infinite mass are skipped.
+     *
+     * @param[in]     bodies  body assets
+     * @param[in,out] forces  forces indexed by the body index
+     * @param[in,out] torques torques indexed by the body index
+     */
+    virtual void AddBatchedForces(
+        std::vector<Asset<mechanics::Body>> const& bodies, std::vector<glm::vec3>& forces, std::vector<glm::vec3>& torques
+    ) = 0;
+
+    //!Body force binds
+    std::vector<Asset<ForceBind>> binds;
+
+    //!Active binds sorted by the body index, binds of a body keep the order they were made in
+    std::vector<BoundForce> bound;
+
+    //!True if the binds are calculated by AddBatchedForces
+    bool batched = false;
+};
+
+/**
+ * @brief Stores instances and binds of the force type
+ * @tparam Force type of the force
+ */
+template < typename Force >
+class ForceStorage final : public ForceStorageBase
+{
+public:
+    ForceStorage()
+    {
+        batched = HasBatchedForces<Force>::value;
+    }
+
+    std::unique_ptr<ForceStorageBase> Clone() const override
+    {
+        return std::unique_ptr<ForceStorageBase>(new ForceStorage(*this));
+    }
+
+    void SortBinds() override
+    {
+        bound.clear();
+        for (Asset<ForceBind> const& bind : binds)
+        {
+            if (bind.id != ZERO_HANDLE && forces[bind.data.force - 1].id != ZERO_HANDLE)
+            {
+                bound.push_back({ bind.data.body - 1, bind.data.force - 1 });
+            }
+        }
+
+        GroupBatches(HasBatchedForces<Force>());
+
+        std::stable_sort(bound.begin(), bound.end(), [](BoundForce const& lhs, BoundForce const& rhs) {
+            return lhs.body < rhs.body;
+        });
+    }
+
+    void ApplyForces(ForceTargets const& targets, float duration) const override
+    {
+        ApplyForces(targets, duration, std::integral_constant<bool,
+            HasBodyForce<Force>::value && !HasBatchedForces<Force>::value
+        >());
+    }
+
+    void AddBatchedForces(
+        std::vector<Asset<mechanics::Body>> const& bodies, std::vector<glm::vec3>& forces, std::vector<glm::vec3>& torques
+    ) override
+    {
+        AddBatchedForces(bodies, forces, torques, HasBatchedForces<Force>());
+    }
+
+    //!Force instances
+    std::vector<Asset<Force>> forces;
+
+private:
+    //!Offsets of the force instances in the batch bodies, the last element is the number of the batch bodies
+    std::vector<uint32_t> m_batchOffsets;
+
+    //!Body indices of the binds grouped by the force instance
+    std::vector<uint32_t> m_batchBodies;
+
+    //!Bodies passed to the batched calculation
+    std::vector<mechanics::Body const*> m_batchTargets;
+
+    //!Body index of each batch target
+    std::vector<uint32_t> m_batchIndices;
+
+    std::vector<glm::vec3> m_batchForces;
+    std::vector<glm::vec3> m_batchTorques;
+
+    void GroupBatches(std::false_type)
+    {
+    }
+
+    /**
+     * @brief Groups the bound bodies by the force instance, keeping the bind order inside each group
+     */
+    void GroupBatches(std::true_type)
+    {
+        m_batchOffsets.assign(forces.size() + 1, 0);
+        for (BoundForce const& bind : bound)
+        {
+            ++m_batchOffsets[bind.force + 1];
+        }
+        for (size_t i = 1; i < m_batchOffsets.size(); ++i)
+        {
+            m_batchOffsets[i] += m_batchOffsets[i - 1];
+        }
+
+        std::vector<uint32_t> cursors(m_batchOffsets.begin(), m_batchOffsets.end() - 1);
+        m_batchBodies.resize(bound.size());
+        for (BoundForce const& bind : bound)
+        {
+            m_batchBodies[cursors[bind.force]++] = bind.body;
+        }
+    }
+
+    void ApplyForces(ForceTargets const&, float, std::false_type) const
+    {
+    }
+
+    void ApplyForces(ForceTargets const& targets, float duration, std::true_type) const
+    {
+        std::vector<BoundForce>::const_iterator bind = std::lower_bound(bound.begin(), bound.end(), targets.begin,
+            [](BoundForce const& lhs, uint32_t body) {
+                return lhs.body < body;
+            }
+        );
+
+        uint32_t const end = targets.begin + targets.count;
+        for (; bind != bound.end() && bind->body < end; ++bind)
+        {
+            mechanics::Body* body = targets.bodies[bind->body - targets.begin];
+            if (body != nullptr)
+            {
+                ApplyForce(forces[bind->force].data, *body, duration);
+            }
+        }
+    }
+
+    void AddBatchedForces(
+        std::vector<Asset<mechanics::Body>> const&, std::vector<glm::vec3>&, std::vector<glm::vec3>&, std::false_type
+    )
+    {
+    }
+
+    void AddBatchedForces(
+        std::vector<Asset<mechanics::Body>> const& bodies, std::vector<glm::vec3>& bodyForces,
+        std::vector<glm::vec3>& bodyTorques, std::true_type
+    )
+    {
+        for (size_t force = 0; force + 1 < m_batchOffsets.size(); ++force)
+        {
+            m_batchTargets.clear();
+            m_batchIndices.clear();
+            for (uint32_t i = m_batchOffsets[force]; i < m_batchOffsets[force + 1]; ++i)
+            {
+                Asset<mechanics::Body> const& body = bodies[m_batchBodies[i]];
+                if (body.id != ZERO_HANDLE && !body.data.asleep && !body.data.material.HasInfiniteMass())
+                {
+                    m_batchTargets.push_back(&body.data);
+                    m_batchIndices.push_back(m_batchBodies[i]);
+                }
+            }
+
+            if (m_batchTargets.empty())
+            {
+                continue;
+            }
+
+            m_batchForces.assign(m_batchTargets.size(), glm::vec3(0));
+            m_batchTorques.assign(m_batchTargets.size(), glm::vec3(0));
+            forces[force].data.CalculateForces(
+                m_batchTargets.data(), m_batchForces.data(), m_batchTorques.data(), m_batchTargets.size()
+            );
+
+            for (size_t i = 0; i < m_batchIndices.size(); ++i)
+            {
+                bodyForces[m_batchIndices[i]] += m_batchForces[i];
+                bodyTorques[m_batchIndices[i]] += m_batchTorques[i];
+            }
+        }
+    }
+};
+
+/**
+ * @brief List of the force types
+ * @tparam Forces force types
+ */
+template < typename... Forces >
+struct ForceTypeList
+{
+};
+
+//!Built-in force types in the order their binds are applied
+using BuiltinForceTypes = ForceTypeList<
+    force::StaticField,
+    force::SquareDistanceSource,
+    force::Drag,
+    force::Spring,
+    force::Bungee,
+    force::Buoyancy,
+    force::GlobalField,
+    force::MutualAttraction
+>;
+
+/**
+ * @brief Finds position of the force type in the list
+ *
+ * Value is INVALID_FORCE_TYPE if the list does not contain the type.
+ *
+ * @tparam Force type of the force
+ * @tparam List  list of the force types
+ */
+template < typename Force, typename List >
+struct ForceTypeIndex;
+
+template < typename Force >
+struct ForceTypeIndex<Force, ForceTypeList<>> : std::integral_constant<uint32_t, INVALID_FORCE_TYPE>
+{
+};
+
+template < typename Force, typename... Rest >
+struct ForceTypeIndex<Force, ForceTypeList<Force, Rest...>> : std::integral_constant<uint32_t, 0>
+{
+};
+
+template < typename Force, typename First, typename... Rest >
+struct ForceTypeIndex<Force, ForceTypeList<First, Rest...>> : std::integral_constant<uint32_t,
+    (ForceTypeIndex<Force, ForceTypeList<Rest...>>::value == INVALID_FORCE_TYPE)
+        ? INVALID_FORCE_TYPE
+        : ForceTypeIndex<Force, ForceTypeList<Rest...>>::value + 1
+>
+{
+};
+
+/**
+ * @brief Stores force storages of the registered force types
+ *
+ * Built-in types are stored at their positions in BuiltinForceTypes. User types are
+ * registered explicitly and appended in the registration order, they are looked up
+ * by their type info, so the library and the application agree on them.
+ * Binds are applied in the order of the types.
+ */
+class ForceRegistry
+{
+public:
+    ForceRegistry()
+    {
+        AddStorages(BuiltinForceTypes());
+    }
+
+    ForceRegistry(ForceRegistry&&) = default;
+    ForceRegistry& operator=(ForceRegistry&&) = default;
+
+    ForceRegistry(ForceRegistry const& other)
+        : m_userTypes(other.m_userTypes)
+    {
+        for (std::unique_ptr<ForceStorageBase> const& storage : other.m_storages)
+        {
+            m_storages.push_back(storage->Clone());
+        }
+    }
+
+    ForceRegistry& operator=(ForceRegistry const& other)
+    {
+        ForceRegistry copy(other);
+        *this = std::move(copy);
+        return *this;
+    }
+
+    /**
+     * @brief Registers the user force type
+     *
+     * Registering a type again returns its existing index.
+     *
+     * @tparam Force type of the force
+     * @return index of the force type
+     */
+    template < typename Force >
+    uint32_t Register()
+    {
+        static_assert(ForceTypeIndex<Force, BuiltinForceTypes>::value == INVALID_FORCE_TYPE,
+            "built-in force types are registered by the registry"
+        );
+        static_assert(HasBodyForce<Force>::value || HasBatchedForces<Force>::value,
+            "force types calculate the force of a body or the forces of all bound bodies"
+        );
+
+        return AddUserType<Force>();
+    }
+
+    /**
+     * @brief Returns index of the force type
+     * @tparam Force type of the force
+     * @return index of the force type or INVALID_FORCE_TYPE if the user type is not registered
+     */
+    template < typename Force >
+    uint32_t GetTypeIndex() const
+    {
+        uint32_t const builtin = ForceTypeIndex<Force, BuiltinForceTypes>::value;
+        return (builtin != INVALID_FORCE_TYPE) ? builtin : FindUserType(typeid(Force));
+    }
+
+    /**
+     * @brief Returns storage of the force type
+     *
+     * User types are registered on the first use.
+     *
+     * @attention Types must be registered before the frames that use them are pushed
+     *
+     * @tparam Force type of the force
+     * @return force storage
+     */
+    template < typename Force >
+    ForceStorage<Force>& GetStorage()
+    {
+        static_assert(ForceTypeIndex<Force, BuiltinForceTypes>::value != INVALID_FORCE_TYPE
+            || HasBodyForce<Force>::value || HasBatchedForces<Force>::value,
+            "force types calculate the force of a body or the forces of all bound bodies"
+        );
+
+        uint32_t const index = GetTypeIndex<Force>();
+        return static_cast<ForceStorage<Force>&>(
+            *m_storages[(index != INVALID_FORCE_TYPE) ? index : AddUserType<Force>()]
+        );
+    }
+
+    /**
+     * @brief Returns number of the registered force types
+     * @return number of the registered force types
+     */
+    uint32_t GetTypeCount() const
+    {
+        return static_cast<uint32_t>(m_storages.size());
+    }
+
+    /**
+     * @brief Returns storage of the registered force type
+     * @param type index of the type
+     * @return force storage
+     */
+    ForceStorageBase& GetStorage(uint32_t type)
+    {
+        return *m_storages[type];
+    }
+
+private:
+    //!Types of the registered user forces, stored after the built-in ones
+    std::vector<std::type_index> m_userTypes;
+
+    std::vector<std::unique_ptr<ForceStorageBase>> m_storages;
+
+    /**
+     * @brief Makes storages of the listed force types
+     * @tparam Forces force types
+     */
+    template < typename... Forces >
+    void AddStorages(ForceTypeList<Forces...>)
+    {
+        std::unique_ptr<ForceStorageBase> storages[] = { std::unique_ptr<ForceStorageBase>(new ForceStorage<Forces>())... };
+        for (std::unique_ptr<ForceStorageBase>& storage : storages)
+        {
+            m_storages.push_back(std::move(storage));
+        }
+    }
+
+    /**
+     * @brief Makes storage of the user force type unless it is registered already
+     * @tparam Force type of the force
+     * @return index of the force type
+     */
+    template < typename Force >
+    uint32_t AddUserType()
+    {
+        uint32_t index = FindUserType(typeid(Force));
+        if (index == INVALID_FORCE_TYPE)
+        {
+            index = static_cast<uint32_t>(m_storages.size());
+            m_userTypes.emplace_back(typeid(Force));
+            m_storages.emplace_back(new ForceStorage<Force>());
+        }
+
+        return index;
+    }
+
+    /**
+     * @brief Finds index of the registered user force type
+     * @param type type info of the force
+     * @return index of the force type or INVALID_FORCE_TYPE if it is not registered
+     */
+    uint32_t FindUserType(std::type_index type) const
+    {
+        for (size_t i = 0; i < m_userTypes.size(); ++i)
+        {
+            if (m_userTypes[i] == type)
+            {
+                return static_cast<uint32_t>(m_storages.size() - m_userTypes.size() + i);
+            }
+        }
+
+        return INVALID_FORCE_TYPE;
+    }
+};
+
+} // namespace scene
+} // namespace pegasus
+#endif // PEGASUS_FORCE_REGISTRY_HPP
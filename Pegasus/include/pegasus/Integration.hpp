@@ -7,6 +7,10 @@
 #define PEGASUS_INTEGRATION_HPP
 
 #include <pegasus/Body.hpp>
+#include <pegasus/WideContactSolver.hpp>
+#include <cassert>
+#include <cstdint>
+#include <vector>
 
 namespace pegasus
 {
@@ -29,9 +33,329 @@ inline glm::vec3 IntegrateTorque(glm::vec3 accumulatedTorque, glm::vec3 appliedT
 }
 
 /**
- * @brief Calculates integrated body position
- * @param[in,out] body point mass data
- * @param[in] duration delta time
+ * @brief Defines the scheme used to advance body motion
+ */
+enum class Integrator : uint8_t
+{
+    //!Bodies move with the velocity they had before the step
+    EXPLICIT_EULER,
+
+    //!Bodies move with the velocity updated by the step, conserves energy of orbits and oscillators
+    SEMI_IMPLICIT_EULER,
+
+    //!Forces are evaluated again at the predicted position, the velocity uses their average
+    VELOCITY_VERLET,
+
+    //!Forces are evaluated at four stages, meant for bodies driven by force fields only
+    RUNGE_KUTTA_4
+};
+
+//!Number of bodies copied into the body motions buffer at once, small enough to stay in the cache
+uint32_t const BODY_MOTIONS_TILE_SIZE = 64;
+
+//!Number of consecutive body assets integrated by one task, tasks share cache lines only at the chunk edges
+uint32_t const BODY_CHUNK_SIZE = 4 * BODY_MOTIONS_TILE_SIZE;
+
+//!Number of rows of the body motions buffer, one for each value of the motion state
+uint32_t const BODY_MOTION_LANE_COUNT = 42;
+
+/**
+ * @brief Stores the state of a tile of bodies kept aside while the integrator stages move them
+ *
+ * Stages change only the linear position and velocity of the bodies, so these are saved together with
+ * the torque of the current state and restored once the stage forces are known.
+ */
+struct StageMotions
+{
+    //!Linear motion and torque of the bodies at the current state
+    glm::vec3 positions[BODY_MOTIONS_TILE_SIZE];
+    glm::vec3 velocities[BODY_MOTIONS_TILE_SIZE];
+    glm::vec3 torques[BODY_MOTIONS_TILE_SIZE];
+
+    //!Stage velocities and forces of the fourth order scheme
+    glm::vec3 stageVelocities[BODY_MOTIONS_TILE_SIZE];
+    glm::vec3 secondForces[BODY_MOTIONS_TILE_SIZE];
+    glm::vec3 thirdForces[BODY_MOTIONS_TILE_SIZE];
+};
+
+/**
+ * @brief Evaluates forces at the stages of the integrator and stores the ones that change the velocity in the bodies
+ *
+ * Only linear motion uses the stages, torque is evaluated once at the current state.
+ * Stages move the bodies themselves and restore them afterwards, so the forces must depend only on the bodies
+ * themselves. Each stage calculates the forces of all bodies at once, so the forces of one type are applied together.
+ *
+ * @tparam CalculateForces callable that replaces forces and torques of the bodies of the array it is given
+ * @param[in]     integrator      integrator scheme
+ * @param[in,out] bodies          body data, null entries are skipped
+ * @param[out]    positionForces  forces that move the bodies, passed to LoadBodyMotion
+ * @param[in]     count           number of entries, at most BODY_MOTIONS_TILE_SIZE of them are not null
+ * @param[in]     duration        delta time of the integration
+ * @param[out]    stages          scratch state of the bodies, reused between the calls
+ * @param[in]     calculateForces force calculation
+ */
+template < typename CalculateForces >
+void ApplyStageForces(
+    Integrator integrator, mechanics::Body* const* bodies, glm::vec3* positionForces, uint32_t count, float duration,
+    StageMotions& stages, CalculateForces const& calculateForces
+)
+{
+    calculateForces(bodies);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (bodies[i] != nullptr)
+        {
+            positionForces[i] = bodies[i]->linearMotion.force;
+        }
+    }
+
+    if (integrator != Integrator::VELOCITY_VERLET && integrator != Integrator::RUNGE_KUTTA_4)
+    {
+        return;
+    }
+
+    //Bodies are numbered densely in the scratch state
+    uint32_t stageCount = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (bodies[i] != nullptr)
+        {
+            assert(stageCount < BODY_MOTIONS_TILE_SIZE);
+            stages.positions[stageCount] = bodies[i]->linearMotion.position;
+            stages.velocities[stageCount] = bodies[i]->linearMotion.velocity;
+            stages.torques[stageCount] = bodies[i]->angularMotion.torque;
+            ++stageCount;
+        }
+    }
+
+    auto const accelerate = [bodies](uint32_t i, glm::vec3 const& stageForce) {
+        return bodies[i]->linearMotion.acceleration + stageForce * bodies[i]->material.GetInverseMass();
+    };
+
+    //Moves the bodies to the state set by the callable and calculates their forces there
+    auto const evaluate = [bodies, count, &calculateForces](auto const& setStage) {
+        uint32_t stage = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (bodies[i] != nullptr)
+            {
+                setStage(i, stage++, bodies[i]->linearMotion);
+            }
+        }
+        calculateForces(bodies);
+    };
+
+    //Returns the bodies to the current state with the force that changes the velocity
+    auto const restore = [bodies, count, &stages](auto const& getForce) {
+        uint32_t stage = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (bodies[i] != nullptr)
+            {
+                bodies[i]->linearMotion.force = getForce(i, stage, bodies[i]->linearMotion.force);
+                bodies[i]->linearMotion.position = stages.positions[stage];
+                bodies[i]->linearMotion.velocity = stages.velocities[stage];
+                bodies[i]->angularMotion.torque = stages.torques[stage];
+                ++stage;
+            }
+        }
+    };
+
+    float const halfDuration = duration * 0.5f;
+    if (integrator == Integrator::VELOCITY_VERLET)
+    {
+        evaluate([&](uint32_t i, uint32_t stage, mechanics::Body::LinearMotion& motion) {
+            glm::vec3 const acceleration = accelerate(i, positionForces[i]);
+            glm::vec3 const& velocity = stages.velocities[stage];
+            motion.position = stages.positions[stage] + (velocity + acceleration * halfDuration) * duration;
+            motion.velocity = velocity + acceleration * duration;
+        });
+
+        restore([&](uint32_t i, uint32_t, glm::vec3 const& stageForce) {
+            return (positionForces[i] + stageForce) * 0.5f;
+        });
+        return;
+    }
+
+    evaluate([&](uint32_t i, uint32_t stage, mechanics::Body::LinearMotion& motion) {
+        stages.stageVelocities[stage] = stages.velocities[stage] + accelerate(i, positionForces[i]) * halfDuration;
+        motion.position = stages.positions[stage] + stages.velocities[stage] * halfDuration;
+        motion.velocity = stages.stageVelocities[stage];
+    });
+
+    evaluate([&](uint32_t i, uint32_t stage, mechanics::Body::LinearMotion& motion) {
+        stages.secondForces[stage] = motion.force;
+        motion.position = stages.positions[stage] + stages.stageVelocities[stage] * halfDuration;
+        stages.stageVelocities[stage] =
+            stages.velocities[stage] + accelerate(i, stages.secondForces[stage]) * halfDuration;
+        motion.velocity = stages.stageVelocities[stage];
+    });
+
+    evaluate([&](uint32_t i, uint32_t stage, mechanics::Body::LinearMotion& motion) {
+        stages.thirdForces[stage] = motion.force;
+        motion.position = stages.positions[stage] + stages.stageVelocities[stage] * duration;
+        motion.velocity = stages.velocities[stage] + accelerate(i, stages.thirdForces[stage]) * duration;
+    });
+
+    restore([&](uint32_t i, uint32_t stage, glm::vec3 const& fourthForce) {
+        glm::vec3 const force = positionForces[i];
+        glm::vec3 const& secondForce = stages.secondForces[stage];
+        glm::vec3 const& thirdForce = stages.thirdForces[stage];
+        positionForces[i] = (force + secondForce + thirdForce) / 3.0f;
+        return (force + (secondForce + thirdForce) * 2.0f + fourthForce) / 6.0f;
+    });
+}
+
+/**
+ * @brief Evaluates forces at the stages of the integrator and stores the ones that change the velocity in the body
+ *
+ * Only linear motion uses the stages, torque is evaluated once at the current state.
+ * Stages move the body itself and restore it afterwards, so the forces must depend only on the body itself.
+ *
+ * @tparam CalculateForces callable that replaces forces and torques of the body it is given
+ * @param[in]     integrator      integrator scheme
+ * @param[in,out] body            body data
+ * @param[in]     duration        delta time of the integration
+ * @param[in]     calculateForces force calculation
+ * @return force that moves the body, passed to LoadBodyMotion
+ */
+template < typename CalculateForces >
+glm::vec3 ApplyStageForces(
+    Integrator integrator, mechanics::Body& body, float duration, CalculateForces const& calculateForces
+)
+{
+    mechanics::Body* const bodies[] = { &body };
+    glm::vec3 positionForce;
+    StageMotions stages;
+    ApplyStageForces(integrator, bodies, &positionForce, 1, duration, stages,
+        [&calculateForces](mechanics::Body* const* stage) {
+            calculateForces(**stage);
+        }
+    );
+
+    return positionForce;
+}
+
+/**
+ * @brief Stores motion state of bodies in the structure of arrays form
+ *
+ * Each value of the motion state is a row of stride floats, one column per body.
+ */
+struct BodyMotions
+{
+    //!Number of bodies
+    uint32_t count = 0;
+
+    //!Distance between the rows, padded to the widest instruction set
+    uint32_t stride = 0;
+
+    //!Rows of the motion state values
+    std::vector<float> lanes;
+};
+
+/**
+ * @brief Sets the number of bodies stored in the buffer
+ * @param[in,out] motions body motions buffer
+ * @param[in]     count   number of bodies
+ */
+void ResizeBodyMotions(BodyMotions& motions, uint32_t count);
+
+/**
+ * @brief Copies motion state of the body into the buffer
+ * @param[in,out] motions body motions buffer
+ * @param[in]     index   body column in the buffer
+ * @param[in]     body    body data
+ */
+void LoadBodyMotion(BodyMotions& motions, uint32_t index, mechanics::Body const& body);
+
+/**
+ * @brief Copies motion state of the body into the buffer with a separate force that moves it
+ * @param[in,out] motions       body motions buffer
+ * @param[in]     index         body column in the buffer
+ * @param[in]     body          body data
+ * @param[in]     positionForce force returned by ApplyStageForces
+ */
+void LoadBodyMotion(BodyMotions& motions, uint32_t index, mechanics::Body const& body, glm::vec3 const& positionForce);
+
+/**
+ * @brief Copies motion state of the body into a caller owned buffer with a separate force that moves it
+ * @param[out] lanes         first row of the buffer of BODY_MOTION_LANE_COUNT rows
+ * @param[in]  stride        distance between the rows
+ * @param[in]  index         body column in the buffer
+ * @param[in]  body          body data
+ * @param[in]  positionForce force returned by ApplyStageForces
+ */
+void LoadBodyMotion(
+    float* lanes, uint32_t stride, uint32_t index, mechanics::Body const& body, glm::vec3 const& positionForce
+);
+
+/**
+ * @brief Copies integrated motion state from the buffer back into the body and clears its forces
+ * @param[in]     motions body motions buffer
+ * @param[in]     index   body column in the buffer
+ * @param[in,out] body    body data
+ */
+void StoreBodyMotion(BodyMotions const& motions, uint32_t index, mechanics::Body& body);
+
+/**
+ * @brief Copies integrated motion state from a caller owned buffer back into the body and clears its forces
+ * @param[in]     lanes  first row of the buffer of BODY_MOTION_LANE_COUNT rows
+ * @param[in]     stride distance between the rows
+ * @param[in]     index  body column in the buffer
+ * @param[in,out] body   body data
+ */
+void StoreBodyMotion(float const* lanes, uint32_t stride, uint32_t index, mechanics::Body& body);
+
+/**
+ * @brief Integrates motion of all bodies in the buffer and updates their world space inverse inertia
+ *
+ * Bodies are processed in groups of the instruction set width, the remaining ones one at a time.
+ * The result does not depend on the instruction set.
+ *
+ * @param[in,out] motions          body motions buffer
+ * @param[in]     duration         delta time of the integration
+ * @param[in]     integrator       integrator scheme
+ * @param[in]     gyroscopicTorque true to apply gyroscopic torque implicitly
+ * @param[in]     instructionSet   instruction set, must be supported by the CPU
+ */
+void Integrate(
+    BodyMotions& motions, float duration, Integrator integrator, bool gyroscopicTorque,
+    collision::SimdInstructionSet instructionSet
+);
+
+/**
+ * @brief Integrates motion of the bodies of a caller owned buffer and updates their world space inverse inertia
+ *
+ * Works as the BodyMotions version, the stride must be a multiple of the widest instruction set width,
+ * which BODY_MOTIONS_TILE_SIZE is.
+ *
+ * @param[in,out] lanes            first row of the buffer of BODY_MOTION_LANE_COUNT rows
+ * @param[in]     stride           distance between the rows
+ * @param[in]     count            number of bodies
+ * @param[in]     duration         delta time of the integration
+ * @param[in]     integrator       integrator scheme
+ * @param[in]     gyroscopicTorque true to apply gyroscopic torque implicitly
+ * @param[in]     instructionSet   instruction set, must be supported by the CPU
+ */
+void Integrate(
+    float* lanes, uint32_t stride, uint32_t count, float duration, Integrator integrator, bool gyroscopicTorque,
+    collision::SimdInstructionSet instructionSet
+);
+
+/**
+ * @brief Moves the body with its velocities, ignoring forces, accelerations and damping
+ *
+ * World space inverse inertia is updated as for the other bodies.
+ *
+ * @param[in,out] body     body data
+ * @param[in]     duration delta time of the integration
+ */
+void IntegrateKinematic(mechanics::Body& body, float duration);
+
+/**
+ * @brief Integrates motion of the body with the explicit Euler scheme and updates its world space inverse inertia
+ * @param[in,out] body     body data
+ * @param[in]     duration delta time of the integration
  */
 void Integrate(mechanics::Body& body, float duration);
 } // namespace integration
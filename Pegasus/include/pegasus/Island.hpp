@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_ISLAND_HPP
+#define PEGASUS_ISLAND_HPP
+
+#include <pegasus/Contact.hpp>
+#include <pegasus/SolverBody.hpp>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace pegasus
+{
+namespace collision
+{
+
+//!Island index of a body that does not belong to any island
+uint32_t const INVALID_ISLAND = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Union-find structure over the dense indices
+ */
+class DisjointSet
+{
+public:
+    /**
+     * @brief Makes a singleton set for each of the given number of elements
+     * @param size number of elements
+     */
+    void Reset(size_t size)
+    {
+        m_parents.resize(size);
+        m_sizes.assign(size, 1);
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_parents[i] = static_cast<uint32_t>(i);
+        }
+    }
+
+    /**
+     * @brief Returns representative element of the set containing the given element
+     * @param index element index
+     * @return representative element index
+     */
+    uint32_t Find(uint32_t index)
+    {
+        while (m_parents[index] != index)
+        {
+            m_parents[index] = m_parents[m_parents[index]];
+            index = m_parents[index];
+        }
+
+        return index;
+    }
+
+    /**
+     * @brief Merges sets containing the given elements
+     * @param a element index
+     * @param b element index
+     */
+    void Union(uint32_t a, uint32_t b)
+    {
+        a = Find(a);
+        b = Find(b);
+        if (a == b)
+        {
+            return;
+        }
+
+        if (m_sizes[a] < m_sizes[b])
+        {
+            std::swap(a, b);
+        }
+        m_parents[b] = a;
+        m_sizes[a] += m_sizes[b];
+    }
+
+private:
+    std::vector<uint32_t> m_parents;
+    std::vector<uint32_t> m_sizes;
+};
+
+/**
+ * @brief Stores ranges of a single island in the Islands buffers
+ */
+struct Island
+{
+    uint32_t bodyOffset = 0;
+    uint32_t bodyCount = 0;
+    uint32_t contactOffset = 0;
+    uint32_t contactCount = 0;
+};
+
+/**
+ * @brief Stores groups of bodies connected by contacts
+ *
+ * Bodies with an infinite mass do not connect islands and do not belong to any of them,
+ * so each island can be solved independently of the others.
+ */
+struct Islands
+{
+    //!Island ranges
+    std::vector<Island> islands;
+
+    //!Solver body indices grouped by island
+    std::vector<uint32_t> bodies;
+
+    //!Contact indices grouped by island
+    std::vector<uint32_t> contacts;
+
+    //!Island index of each solver body
+    std::vector<uint32_t> bodyIslands;
+
+    //!Union-find buffer
+    DisjointSet sets;
+};
+
+/**
+ * @brief Splits solver bodies and contacts into islands
+ * @param[in] solverBodies solver bodies referenced by the contacts
+ * @param[in] contacts contacts
+ * @param[out] islands islands data
+ * @param[in] links pairs of solver bodies that are connected without a contact
+ */
+inline void BuildIslands(
+    SolverBodies const& solverBodies, std::vector<Contact> const& contacts, Islands& islands,
+    std::vector<std::pair<uint32_t, uint32_t>> const& links = {}
+)
+{
+    std::vector<SolverBody> const& bodies = solverBodies.bodies;
+
+    islands.islands.clear();
+    islands.sets.Reset(bodies.size());
+    for (Contact const& contact : contacts)
+    {
+        if (bodies[contact.aSolverBody].inverseMass != 0 && bodies[contact.bSolverBody].inverseMass != 0)
+        {
+            islands.sets.Union(contact.aSolverBody, contact.bSolverBody);
+        }
+    }
+    for (std::pair<uint32_t, uint32_t> const& link : links)
+    {
+        if (bodies[link.first].inverseMass != 0 && bodies[link.second].inverseMass != 0)
+        {
+            islands.sets.Union(link.first, link.second);
+        }
+    }
+
+    //Assign island indices to the set representatives and count bodies
+    islands.bodyIslands.assign(bodies.size(), INVALID_ISLAND);
+    for (uint32_t i = 0; i < bodies.size(); ++i)
+    {
+        if (bodies[i].inverseMass == 0)
+        {
+            continue;
+        }
+
+        uint32_t const root = islands.sets.Find(i);
+        if (islands.bodyIslands[root] == INVALID_ISLAND)
+        {
+            islands.bodyIslands[root] = static_cast<uint32_t>(islands.islands.size());
+            islands.islands.emplace_back();
+        }
+        islands.bodyIslands[i] = islands.bodyIslands[root];
+        ++islands.islands[islands.bodyIslands[i]].bodyCount;
+    }
+
+    //Count contacts
+    for (Contact const& contact : contacts)
+    {
+        uint32_t const island = bodies[contact.aSolverBody].inverseMass != 0
+            ? islands.bodyIslands[contact.aSolverBody] : islands.bodyIslands[contact.bSolverBody];
+        if (island != INVALID_ISLAND)
+        {
+            ++islands.islands[island].contactCount;
+        }
+    }
+
+    //Calculate offsets
+    uint32_t bodyOffset = 0;
+    uint32_t contactOffset = 0;
+    for (Island& island : islands.islands)
+    {
+        island.bodyOffset = bodyOffset;
+        island.contactOffset = contactOffset;
+        bodyOffset += island.bodyCount;
+        contactOffset += island.contactCount;
+        island.bodyCount = 0;
+        island.contactCount = 0;
+    }
+
+    //Fill island buffers
+    islands.bodies.resize(bodyOffset);
+    islands.contacts.resize(contactOffset);
+    for (uint32_t i = 0; i < bodies.size(); ++i)
+    {
+        if (islands.bodyIslands[i] != INVALID_ISLAND)
+        {
+            Island& island = islands.islands[islands.bodyIslands[i]];
+            islands.bodies[island.bodyOffset + island.bodyCount++] = i;
+        }
+    }
+    for (uint32_t i = 0; i < contacts.size(); ++i)
+    {
+        uint32_t const index = bodies[contacts[i].aSolverBody].inverseMass != 0
+            ? islands.bodyIslands[contacts[i].aSolverBody] : islands.bodyIslands[contacts[i].bSolverBody];
+        if (index != INVALID_ISLAND)
+        {
+            Island& island = islands.islands[index];
+            islands.contacts[island.contactOffset + island.contactCount++] = i;
+        }
+    }
+}
+
+} // namespace collision
+} // namespace pegasus
+#endif // PEGASUS_ISLAND_HPP
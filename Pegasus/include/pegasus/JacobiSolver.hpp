@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_JACOBI_SOLVER_HPP
+#define PEGASUS_JACOBI_SOLVER_HPP
+
+#include <pegasus/Contact.hpp>
+#include <pegasus/SolverBody.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace pegasus
+{
+namespace collision
+{
+
+/**
+ * @brief Stores contact slots that change the velocity of each solver body
+ *
+ * A slot is the contact index multiplied by two, plus one when the body is the second body
+ * of the contact. Slots of a body are stored in the contact order, so summing them
+ * gives the same result regardless of the number of threads.
+ */
+struct BodyContacts
+{
+    //!Slot offsets of each solver body, the last element is the total number of slots
+    std::vector<uint32_t> offsets;
+
+    //!Contact slots grouped by solver body
+    std::vector<uint32_t> slots;
+};
+
+/**
+ * @brief Groups contact slots by the solver bodies with a finite mass
+ * @param[in]  solverBodies solver bodies referenced by the contacts
+ * @param[in]  contacts     contacts
+ * @param[out] bodyContacts contact slots of the bodies
+ */
+inline void BuildBodyContacts(
+    SolverBodies const& solverBodies, std::vector<Contact> const& contacts, BodyContacts& bodyContacts
+)
+{
+    std::vector<SolverBody> const& bodies = solverBodies.bodies;
+    std::vector<uint32_t>& offsets = bodyContacts.offsets;
+    offsets.assign(bodies.size() + 1, 0);
+
+    for (Contact const& contact : contacts)
+    {
+        ++offsets[contact.aSolverBody + 1];
+        ++offsets[contact.bSolverBody + 1];
+    }
+    for (size_t i = 1; i < offsets.size(); ++i)
+    {
+        offsets[i] += offsets[i - 1];
+    }
+
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    bodyContacts.slots.resize(offsets.back());
+    for (uint32_t i = 0; i < contacts.size(); ++i)
+    {
+        bodyContacts.slots[cursors[contacts[i].aSolverBody]++] = 2 * i;
+        bodyContacts.slots[cursors[contacts[i].bSolverBody]++] = 2 * i + 1;
+    }
+}
+
+} // namespace collision
+} // namespace pegasus
+#endif // PEGASUS_JACOBI_SOLVER_HPP
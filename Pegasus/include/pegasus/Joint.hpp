@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_JOINT_HPP
+#define PEGASUS_JOINT_HPP
+
+#include <pegasus/Asset.hpp>
+#include <pegasus/Body.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace pegasus
+{
+namespace joint
+{
+
+/**
+ * @brief Stores bodies connected by a joint and the joint anchor points
+ */
+struct Anchors
+{
+    Anchors() = default;
+
+    /**
+     * @brief Constructs anchors from the world space points
+     * @param a first body data
+     * @param b second body data
+     * @param aAnchor world space anchor point of the first body
+     * @param bAnchor world space anchor point of the second body
+     */
+    Anchors(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 aAnchor, glm::vec3 bAnchor);
+
+    //!Handles of the connected bodies, assigned by the scene
+    scene::Handle aBody = scene::ZERO_HANDLE;
+    scene::Handle bBody = scene::ZERO_HANDLE;
+
+    //!Anchor points in the body spaces
+    glm::vec3 aAnchor = { 0, 0, 0 };
+    glm::vec3 bAnchor = { 0, 0, 0 };
+};
+
+/**
+ * @brief Joint that keeps the anchor points of the bodies together
+ */
+struct BallSocket : Anchors
+{
+    BallSocket() = default;
+
+    /**
+     * @brief Constructs ball-socket joint from the current body transforms
+     * @param a first body data
+     * @param b second body data
+     * @param anchor world space point shared by the bodies
+     */
+    BallSocket(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 anchor);
+};
+
+/**
+ * @brief Ball-socket joint that allows rotation only around the hinge axis
+ */
+struct Hinge : Anchors
+{
+    Hinge() = default;
+
+    /**
+     * @brief Constructs hinge joint from the current body transforms
+     * @param a first body data
+     * @param b second body data
+     * @param anchor world space point shared by the bodies
+     * @param axis world space hinge axis
+     */
+    Hinge(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 anchor, glm::vec3 axis);
+
+    //!Hinge axis in the body spaces
+    glm::vec3 aAxis = { 1, 0, 0 };
+    glm::vec3 bAxis = { 1, 0, 0 };
+};
+
+/**
+ * @brief Joint that keeps the anchor points of the bodies at the fixed distance
+ */
+struct Distance : Anchors
+{
+    Distance() = default;
+
+    /**
+     * @brief Constructs distance joint from the current body transforms
+     *
+     * The distance between the anchor points is kept as it is at the time of the construction.
+     *
+     * @param a first body data
+     * @param b second body data
+     * @param aAnchor world space anchor point of the first body
+     * @param bAnchor world space anchor point of the second body
+     */
+    Distance(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 aAnchor, glm::vec3 bAnchor);
+
+    //!Distance between the anchor points
+    float distance = 0.0f;
+};
+
+/**
+ * @brief Joint that removes any relative motion of the bodies
+ */
+struct Fixed : Anchors
+{
+    Fixed() = default;
+
+    /**
+     * @brief Constructs fixed joint from the current body transforms
+     * @param a first body data
+     * @param b second body data
+     * @param anchor world space point shared by the bodies
+     */
+    Fixed(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 anchor);
+
+    //!Orientation of the second body in the space of the first body
+    glm::quat relativeOrientation;
+};
+
+} // namespace joint
+} // namespace pegasus
+#endif // PEGASUS_JOINT_HPP
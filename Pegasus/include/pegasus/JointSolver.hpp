@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_JOINT_SOLVER_HPP
+#define PEGASUS_JOINT_SOLVER_HPP
+
+#include <pegasus/AssetManager.hpp>
+#include <pegasus/Contact.hpp>
+#include <pegasus/Joint.hpp>
+#include <pegasus/SolverBody.hpp>
+#include <Epona/FloatingPoint.hpp>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace pegasus
+{
+namespace collision
+{
+
+/**
+ * @brief Stores a single equality constraint of a joint
+ */
+struct JointRow
+{
+    //!Solver body indices
+    uint32_t aSolverBody = 0;
+    uint32_t bSolverBody = 0;
+
+    //!Jacobian of the constraint
+    Jacobian jacobian;
+
+    //!Jacobian premultiplied by the inverse mass matrix
+    Jacobian inverseMassJacobian;
+
+    //!Inverse of the constraint space inverse mass
+    float effectiveMass = 0.0f;
+
+    //!Velocity bias that resolves the position error
+    float bias = 0.0f;
+
+    //!Total lagrangian multiplier
+    float lagrangianMultiplier = 0.0f;
+};
+
+/**
+ * @brief Stores joint constraints of a single resolution step
+ */
+struct JointRows
+{
+    //!Constraint rows
+    std::vector<JointRow> rows;
+
+    //!Pairs of solver bodies connected by joints
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+};
+
+/**
+ * @brief Stores joint data transformed into the world space
+ */
+struct JointFrame
+{
+    uint32_t aSolverBody;
+    uint32_t bSolverBody;
+
+    //!Anchor points relative to the centers of mass of the bodies
+    glm::vec3 rA;
+    glm::vec3 rB;
+
+    //!Distance from the first anchor point to the second one
+    glm::vec3 error;
+
+    //!Body orientations
+    glm::quat aOrientation;
+    glm::quat bOrientation;
+};
+
+/**
+ * @brief Adds constraint row to the joint rows
+ * @param[in]     solverBodies solver bodies
+ * @param[in]     frame        joint frame
+ * @param[in]     jacobian     constraint Jacobian
+ * @param[in]     error        position error along the constraint
+ * @param[in]     duration     delta time of the frame
+ * @param[in,out] jointRows    joint rows
+ */
+inline void AddJointRow(
+    SolverBodies const& solverBodies, JointFrame const& frame, Jacobian const& jacobian, float error,
+    float duration, JointRows& jointRows
+)
+{
+    float constexpr beta = 0.2f;
+
+    SolverBody const& aBody = solverBodies.bodies[frame.aSolverBody];
+    SolverBody const& bBody = solverBodies.bodies[frame.bSolverBody];
+
+    MassMatrix const inverseMass{
+        aBody.inverseMass,
+        aBody.inverseInertia,
+        bBody.inverseMass,
+        bBody.inverseInertia,
+    };
+
+    JointRow row;
+    row.aSolverBody = frame.aSolverBody;
+    row.bSolverBody = frame.bSolverBody;
+    row.jacobian = jacobian;
+    row.inverseMassJacobian = inverseMass * jacobian;
+
+    float const inverseEffectiveMass = jacobian * row.inverseMassJacobian;
+    if (epona::fp::IsZero(inverseEffectiveMass))
+    {
+        return;
+    }
+
+    row.effectiveMass = 1.0f / inverseEffectiveMass;
+    row.bias = (beta / duration) * error;
+    jointRows.rows.push_back(row);
+}
+
+/**
+ * @brief Adds rows that keep the anchor points together
+ * @param[in]     solverBodies solver bodies
+ * @param[in]     frame        joint frame
+ * @param[in]     duration     delta time of the frame
+ * @param[in,out] jointRows    joint rows
+ */
+inline void AddPointRows(
+    SolverBodies const& solverBodies, JointFrame const& frame, float duration, JointRows& jointRows
+)
+{
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        glm::vec3 axis(0);
+        axis[i] = 1.0f;
+
+        Jacobian const jacobian{ -axis, glm::cross(-frame.rA, axis), axis, glm::cross(frame.rB, axis) };
+        AddJointRow(solverBodies, frame, jacobian, frame.error[i], duration, jointRows);
+    }
+}
+
+/**
+ * @brief Adds row that stops relative rotation around the given axis
+ * @param[in]     solverBodies solver bodies
+ * @param[in]     frame        joint frame
+ * @param[in]     axis         world space rotation axis
+ * @param[in]     error        rotation angle of the second body around the axis
+ * @param[in]     duration     delta time of the frame
+ * @param[in,out] jointRows    joint rows
+ */
+inline void AddAngularRow(
+    SolverBodies const& solverBodies, JointFrame const& frame, glm::vec3 axis, float error,
+    float duration, JointRows& jointRows
+)
+{
+    Jacobian const jacobian{ glm::vec3(0), -axis, glm::vec3(0), axis };
+    AddJointRow(solverBodies, frame, jacobian, error, duration, jointRows);
+}
+
+/**
+ * @brief Adds rows of the ball-socket joint
+ * @param[in]     solverBodies solver bodies
+ * @param[in]     frame        joint frame
+ * @param[in]     joint        joint data
+ * @param[in]     duration     delta time of the frame
+ * @param[in,out] jointRows    joint rows
+ */
+inline void AddJointRows(
+    SolverBodies const& solverBodies, JointFrame const& frame, joint::BallSocket const& joint,
+    float duration, JointRows& jointRows
+)
+{
+    static_cast<void>(joint);
+    AddPointRows(solverBodies, frame, duration, jointRows);
+}
+
+/**
+ * @brief Adds rows of the hinge joint
+ * @param[in]     solverBodies solver bodies
+ * @param[in]     frame        joint frame
+ * @param[in]     joint        joint data
+ * @param[in]     duration     delta time of the frame
+ * @param[in,out] jointRows    joint rows
+ */
+inline void AddJointRows(
+    SolverBodies const& solverBodies, JointFrame const& frame, joint::Hinge const& joint,
+    float duration, JointRows& jointRows
+)
+{
+    AddPointRows(solverBodies, frame, duration, jointRows);
+
+    glm::vec3 const aAxis = frame.aOrientation * joint.aAxis;
+    glm::vec3 const bAxis = frame.bOrientation * joint.bAxis;
+
+    //Two axes orthogonal to the hinge axis
+    glm::vec3 const reference = glm::abs(aAxis.x) < 0.5f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+    glm::vec3 const firstAxis = glm::normalize(glm::cross(aAxis, reference));
+    glm::vec3 const secondAxis = glm::cross(aAxis, firstAxis);
+
+    glm::vec3 const error = glm::cross(aAxis, bAxis);
+    AddAngularRow(solverBodies, frame, firstAxis, glm::dot(error, firstAxis), duration, jointRows);
+    AddAngularRow(solverBodies, frame, secondAxis, glm::dot(error, secondAxis), duration, jointRows);
+}
+
+/**
+ * @brief Adds row of the distance joint
+ * @param[in]     solverBodies solver bodies
+ * @param[in]     frame        joint frame
+ * @param[in]     joint        joint data
+ * @param[in]     duration     delta time of the frame
+ * @param[in,out] jointRows    joint rows
+ */
+inline void AddJointRows(
+    SolverBodies const& solverBodies, JointFrame const& frame, joint::Distance const& joint,
+    float duration, JointRows& jointRows
+)
+{
+    float const length = glm::length(frame.error);
+    glm::vec3 const axis = epona::fp::IsZero(length) ? glm::vec3(0, 1, 0) : frame.error / length;
+
+    Jacobian const jacobian{ -axis, glm::cross(-frame.rA, axis), axis, glm::cross(frame.rB, axis) };
+    AddJointRow(solverBodies, frame, jacobian, length - joint.distance, duration, jointRows);
+}
+
+/**
+ * @brief Adds rows of the fixed joint
+ * @param[in]     solverBodies solver bodies
+ * @param[in]     frame        joint frame
+ * @param[in]     joint        joint data
+ * @param[in]     duration     delta time of the frame
+ * @param[in,out] jointRows    joint rows
+ */
+inline void AddJointRows(
+    SolverBodies const& solverBodies, JointFrame const& frame, joint::Fixed const& joint,
+    float duration, JointRows& jointRows
+)
+{
+    AddPointRows(solverBodies, frame, duration, jointRows);
+
+    //Small rotation from the target orientation of the second body to the current one
+    glm::quat const rotation =
+        frame.bOrientation * glm::conjugate(frame.aOrientation * joint.relativeOrientation);
+    glm::vec3 const error = glm::vec3(rotation.x, rotation.y, rotation.z) * (rotation.w < 0.0f ? -2.0f : 2.0f);
+
+    for (uint8_t i = 0; i < 3; ++i)
+    {
+        glm::vec3 axis(0);
+        axis[i] = 1.0f;
+        AddAngularRow(solverBodies, frame, axis, error[i], duration, jointRows);
+    }
+}
+
+/**
+ * @brief Loads bodies of the joints and adds their rows
+ *
+ * Joints between two resting bodies are skipped, a resting body connected
+ * to a moving one is woken up.
+ *
+ * @tparam Joint joint type
+ * @param[in,out] assetManager asset manager
+ * @param[in,out] solverBodies solver bodies
+ * @param[in]     duration     delta time of the frame
+ * @param[in,out] jointRows    joint rows
+ */
+template < typename Joint >
+void LoadJoints(
+    scene::AssetManager& assetManager, SolverBodies& solverBodies, float duration, JointRows& jointRows
+)
+{
+    std::vector<scene::Asset<mechanics::Body>>& bodies = assetManager.GetBodies();
+    for (scene::Asset<Joint> const& asset : assetManager.GetJoints<Joint>())
+    {
+        if (asset.id == scene::ZERO_HANDLE)
+        {
+            continue;
+        }
+
+        Joint const& joint = asset.data;
+        mechanics::Body& aBody = assetManager.GetAsset(bodies, joint.aBody);
+        mechanics::Body& bBody = assetManager.GetAsset(bodies, joint.bBody);
+
+        bool const aMoving = !aBody.asleep && !aBody.material.HasInfiniteMass();
+        bool const bMoving = !bBody.asleep && !bBody.material.HasInfiniteMass();
+        if (!aMoving && !bMoving)
+        {
+            continue;
+        }
+
+        for (mechanics::Body* body : { &aBody, &bBody })
+        {
+            if (body->asleep)
+            {
+                body->asleep = false;
+                body->restDuration = 0.0f;
+            }
+        }
+
+        JointFrame frame;
+        frame.aSolverBody = MakeSolverBody(assetManager, solverBodies, joint.aBody);
+        frame.bSolverBody = MakeSolverBody(assetManager, solverBodies, joint.bBody);
+        frame.aOrientation = aBody.angularMotion.orientation;
+        frame.bOrientation = bBody.angularMotion.orientation;
+        frame.rA = frame.aOrientation * joint.aAnchor;
+        frame.rB = frame.bOrientation * joint.bAnchor;
+        frame.error = (bBody.linearMotion.position + frame.rB) - (aBody.linearMotion.position + frame.rA);
+
+        AddJointRows(solverBodies, frame, joint, duration, jointRows);
+        jointRows.links.emplace_back(frame.aSolverBody, frame.bSolverBody);
+    }
+}
+
+/**
+ * @brief Loads bodies and rows of all joints of the scene
+ * @param[in,out] assetManager asset manager
+ * @param[in,out] solverBodies solver bodies
+ * @param[in]     duration     delta time of the frame
+ * @param[out]    jointRows    joint rows
+ */
+inline void LoadJointRows(
+    scene::AssetManager& assetManager, SolverBodies& solverBodies, float duration, JointRows& jointRows
+)
+{
+    jointRows.rows.clear();
+    jointRows.links.clear();
+
+    LoadJoints<joint::BallSocket>(assetManager, solverBodies, duration, jointRows);
+    LoadJoints<joint::Hinge>(assetManager, solverBodies, duration, jointRows);
+    LoadJoints<joint::Distance>(assetManager, solverBodies, duration, jointRows);
+    LoadJoints<joint::Fixed>(assetManager, solverBodies, duration, jointRows);
+}
+
+/**
+ * @brief Solves joint rows sequentially and applies velocity change
+ * @param[in,out] solverBodies solver bodies
+ * @param[in,out] jointRows    joint rows
+ */
+inline void SolveJointRows(SolverBodies& solverBodies, JointRows& jointRows)
+{
+    for (JointRow& row : jointRows.rows)
+    {
+        SolverBody& aBody = solverBodies.bodies[row.aSolverBody];
+        SolverBody& bBody = solverBodies.bodies[row.bSolverBody];
+
+        Velocity const V{
+            aBody.linearVelocity,
+            aBody.angularVelocity,
+            bBody.linearVelocity,
+            bBody.angularVelocity,
+        };
+
+        float const lagrangianMultiplier = -(row.jacobian * V + row.bias) * row.effectiveMass;
+        row.lagrangianMultiplier += lagrangianMultiplier;
+
+        if (aBody.inverseMass != 0)
+        {
+            aBody.linearVelocity += row.inverseMassJacobian.nA * lagrangianMultiplier;
+            aBody.angularVelocity += row.inverseMassJacobian.nwA * lagrangianMultiplier;
+        }
+        if (bBody.inverseMass != 0)
+        {
+            bBody.linearVelocity += row.inverseMassJacobian.nB * lagrangianMultiplier;
+            bBody.angularVelocity += row.inverseMassJacobian.nwB * lagrangianMultiplier;
+        }
+    }
+}
+
+} // namespace collision
+} // namespace pegasus
+#endif // PEGASUS_JOINT_SOLVER_HPP
@@ -40,7 +40,8 @@ public:
     enum class Type : uint8_t
     {
         STATIC,
-        DYNAMIC
+        DYNAMIC,
+        KINEMATIC
     };
 
     /**
@@ -49,7 +50,7 @@ public:
     virtual ~Primitive();
 
     /**
-     * @brief Sets body data
+     * @brief Sets body data and wakes the body up
      * @param body physical data
      */
     void SetBody(mechanics::Body body) const;
@@ -107,6 +108,9 @@ protected:
             case Type::STATIC:
                 m_objectHandle = m_pScene->MakeObject<StaticBody, Shape>(m_bodyHandle, m_shapeHandle);
                 break;
+            case Type::KINEMATIC:
+                m_objectHandle = m_pScene->MakeObject<KinematicBody, Shape>(m_bodyHandle, m_shapeHandle);
+                break;
             default:
                 break;
         }
@@ -127,6 +131,9 @@ protected:
         case Type::STATIC:
             m_pScene->RemoveObject<StaticBody, Shape>(m_objectHandle);
             break;
+        case Type::KINEMATIC:
+            m_pScene->RemoveObject<KinematicBody, Shape>(m_objectHandle);
+            break;
         default:
             break;
         }
@@ -290,12 +297,17 @@ public:
     }
 
     /**
-     * @brief Sets force data
+     * @brief Sets force data and wakes up all bound bodies
      * @param force initialized force data
      */
     void SetForce(ForceType force)
     {
         m_pScene->GetForce<ForceType>(m_forceHandle) = force;
+
+        for (std::pair<Handle, Handle> const bind : m_bodyForceBinds)
+        {
+            m_pScene->WakeUp(bind.first);
+        }
     }
 
     /**
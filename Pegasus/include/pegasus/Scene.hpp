@@ -9,15 +9,30 @@
 #include <pegasus/Body.hpp>
 #include <pegasus/Asset.hpp>
 #include <pegasus/AssetManager.hpp>
+#include <pegasus/BodyBindings.hpp>
 #include <pegasus/Force.hpp>
+#include <pegasus/AttractorTree.hpp>
 #include <pegasus/CollisionDetector.hpp>
 #include <pegasus/CollisionResolver.hpp>
+#include <pegasus/ThreadPool.hpp>
+#include <pegasus/Integration.hpp>
+#include <limits>
+#include <utility>
 
 namespace pegasus
 {
 namespace scene
 {
 
+/**
+ * @brief Stores position and orientation of a body
+ */
+struct BodyTransform
+{
+    glm::vec3 position;
+    glm::quat orientation;
+};
+
 /**
  * @brief Physical world simulation class
  */
@@ -30,6 +45,48 @@ public:
      */
     void ComputeFrame(float duration);
 
+    /**
+     * @brief Advances physical simulation by the real time using frames of the fixed step duration
+     *
+     * Time is accumulated between the calls, at most maxFixedSteps frames are computed per call.
+     * Time beyond the limit is dropped, so slow frames slow the simulation down instead of
+     * making it fall further behind. Non-positive fixed step durations are clamped to a microsecond.
+     *
+     * @param realDuration real time passed since the previous call in seconds
+     * @return number of computed frames
+     */
+    uint32_t Step(float realDuration);
+
+    /**
+     * @brief Returns the fraction of the fixed step left in the accumulator after the last step
+     * @return interpolation factor between the previous and the current transforms
+     */
+    float GetInterpolationAlpha() const;
+
+    /**
+     * @brief Returns transform of the body before the last frame computed by Step
+     *
+     * Bodies made after that frame return their current transform.
+     *
+     * @param handle body handle
+     * @return previous transform
+     */
+    BodyTransform GetPreviousTransform(Handle handle);
+
+    /**
+     * @brief Returns current transform of the body
+     * @param handle body handle
+     * @return current transform
+     */
+    BodyTransform GetCurrentTransform(Handle handle);
+
+    /**
+     * @brief Returns transform of the body interpolated between the previous and the current ones
+     * @param handle body handle
+     * @return interpolated transform
+     */
+    BodyTransform GetInterpolatedTransform(Handle handle);
+
     /**
      * @brief Makes new body instance and returns its handle
      * @return new body handle
@@ -45,10 +102,31 @@ public:
 
     /**
      * @brief Removes instance of the body assigned to the given handle
+     *
+     * Bodies touching the removed one are woken up, so they do not stay suspended in the air.
+     *
      * @param handle body handle
      */
     void RemoveBody(Handle handle);
 
+    /**
+     * @brief Wakes up the body assigned to the given handle
+     *
+     * The rest of the body's island is woken up during the next frame
+     * once the body touches it.
+     *
+     * @param handle body handle
+     */
+    void WakeUp(Handle handle);
+
+    /**
+     * @brief Applies an impulse to the body at the given point and wakes it up
+     * @param handle body handle
+     * @param impulse impulse vector
+     * @param point world space point of application
+     */
+    void ApplyImpulse(Handle handle, glm::vec3 impulse, glm::vec3 point);
+
     /**
      * @brief Makes new shape instance and returns its handle
      * @tparam Shape collision geometry shape type
@@ -101,6 +179,9 @@ public:
 
     /**
      * @brief Removes instance of the rigid body assigned to the given handle
+     *
+     * Bodies touching the rigid body are woken up.
+     *
      * @tparam Object body type
      * @tparam Shape collision geometry shape type
      * @param handle rigid body handle
@@ -108,11 +189,38 @@ public:
     template < typename Object, typename Shape >
     void RemoveObject(Handle handle)
     {
+        WakeUpTouching(m_assetManager.GetAsset(m_assetManager.GetObjects<Object, Shape>(), handle).body);
         m_assetManager.RemoveAsset(m_assetManager.GetObjects<Object, Shape>(), handle);
     }
 
+    /**
+     * @brief Registers the user force type
+     *
+     * Any type with CalculateForce(mechanics::Body const&) const, or with the batched
+     * CalculateForces(mechanics::Body const* const*, glm::vec3*, glm::vec3*, size_t) const, can be used
+     * as a force. Binds of the user types are applied after the built-in ones, in the registration order.
+     * Types that are not registered explicitly are registered when they are first used.
+     *
+     * Batched types get the awake bodies bound to each force instance at once and return their forces
+     * and torques. They are calculated once per step, so multi-stage integrators keep them constant
+     * over the stages.
+     *
+     * @tparam Force type of the force
+     * @return index of the force type
+     */
+    template < typename Force >
+    uint32_t RegisterForce()
+    {
+        return m_assetManager.RegisterForce<Force>();
+    }
+
     /**
      * @brief Makes new instance of the force
+     *
+     * Instances of force::GlobalField and force::MutualAttraction apply to every dynamic body
+     * of their groups and need no binds. Sleeping bodies of their groups are woken up once
+     * such a field is made, changed or removed. User force types are registered on the first use.
+     *
      * @tparam Force type of the force
      * @return force handle
      */
@@ -157,6 +265,7 @@ public:
     {
         Handle const id = m_assetManager.MakeAsset(m_assetManager.GetForceBinds<Force>());
         m_assetManager.GetAsset(m_assetManager.GetForceBinds<Force>(), id) = { body, force };
+        WakeUp(body);
         return id;
     }
 
@@ -171,6 +280,281 @@ public:
         m_assetManager.RemoveAsset(m_assetManager.GetForceBinds<Force>(), handle);
     }
 
+    /**
+     * @brief Makes joint between the bodies and returns its handle
+     *
+     * Joint anchors are expected to be set from the current body transforms.
+     *
+     * @tparam Joint type of the joint
+     * @param aBody handle of the first body
+     * @param bBody handle of the second body
+     * @param joint joint data
+     * @return joint handle
+     */
+    template < typename Joint >
+    Handle MakeJoint(Handle aBody, Handle bBody, Joint joint)
+    {
+        joint.aBody = aBody;
+        joint.bBody = bBody;
+
+        Handle const id = m_assetManager.MakeAsset(m_assetManager.GetJoints<Joint>());
+        m_assetManager.GetAsset(m_assetManager.GetJoints<Joint>(), id) = joint;
+        WakeUp(aBody);
+        WakeUp(bBody);
+        return id;
+    }
+
+    /**
+     * @brief Returns an instance of the joint assigned to the given handle
+     * @tparam Joint type of the joint
+     * @param handle joint handle
+     * @return joint instance
+     */
+    template < typename Joint >
+    Joint& GetJoint(Handle handle)
+    {
+        return m_assetManager.GetAsset(m_assetManager.GetJoints<Joint>(), handle);
+    }
+
+    /**
+     * @brief Removes joint assigned to the given handle
+     * @tparam Joint type of the joint
+     * @param handle joint handle
+     */
+    template < typename Joint >
+    void RemoveJoint(Handle handle)
+    {
+        Joint const& joint = GetJoint<Joint>(handle);
+        WakeUp(joint.aBody);
+        WakeUp(joint.bBody);
+        m_assetManager.RemoveAsset(m_assetManager.GetJoints<Joint>(), handle);
+    }
+
+    /**
+     * @brief Makes new articulation attached to the base body and returns its handle
+     * @param base handle of the body the root links are attached to
+     * @return articulation handle
+     */
+    Handle MakeArticulation(Handle base);
+
+    /**
+     * @brief Adds a link connected to its parent with a revolute joint
+     *
+     * The joint is set from the current body transforms, the link body is integrated
+     * by the articulation from now on.
+     *
+     * @param articulation articulation handle
+     * @param parent index of the parent link or mechanics::ARTICULATION_BASE
+     * @param body handle of the link body
+     * @param anchor world space joint position
+     * @param axis world space joint axis
+     * @return index of the new link
+     */
+    uint32_t AddRevoluteLink(Handle articulation, uint32_t parent, Handle body, glm::vec3 anchor, glm::vec3 axis);
+
+    /**
+     * @brief Returns an instance of the articulation assigned to the given handle
+     * @param handle articulation handle
+     * @return articulation instance
+     */
+    mechanics::Articulation& GetArticulation(Handle handle);
+
+    /**
+     * @brief Removes articulation assigned to the given handle, its link bodies become free bodies
+     * @param handle articulation handle
+     */
+    void RemoveArticulation(Handle handle);
+
+    /**
+     * @brief Sets number of threads used to simulate the scene
+     *
+     * The calling thread is counted as well, so 1 means that everything runs inline.
+     *
+     * @param threadCount total number of threads
+     */
+    void SetThreadCount(uint32_t threadCount);
+
+    /**
+     * @brief Returns number of threads used to simulate the scene
+     * @return total number of threads
+     */
+    uint32_t GetThreadCount() const;
+
+    /**
+     * @brief Sets the order in which contact constraints are solved
+     * @param mode solver mode
+     */
+    void SetSolverMode(collision::SolverMode mode);
+
+    /**
+     * @brief Returns the order in which contact constraints are solved
+     * @return solver mode
+     */
+    collision::SolverMode GetSolverMode() const;
+
+    /**
+     * @brief Sets the fraction of the contact impulses applied by each iteration of the Jacobi solver mode
+     *
+     * Lower values converge slower but keep bodies with many contacts from overshooting.
+     *
+     * @param relaxation relaxation factor in (0, 1]
+     */
+    void SetSolverRelaxation(float relaxation);
+
+    /**
+     * @brief Returns the fraction of the contact impulses applied by each iteration of the Jacobi solver mode
+     * @return relaxation factor
+     */
+    float GetSolverRelaxation() const;
+
+    /**
+     * @brief Sets the method used to resolve contact penetration
+     * @param positionCorrection position correction method
+     */
+    void SetPositionCorrection(collision::PositionCorrection positionCorrection);
+
+    /**
+     * @brief Returns the method used to resolve contact penetration
+     * @return position correction method
+     */
+    collision::PositionCorrection GetPositionCorrection() const;
+
+    /**
+     * @brief Sets the number of passes over the contact constraints
+     * @param velocityIterations number of velocity passes
+     * @param positionIterations number of position passes used by the split impulse
+     */
+    void SetSolverIterations(uint32_t velocityIterations, uint32_t positionIterations);
+
+    /**
+     * @brief Returns the number of passes over the contact velocity constraints
+     * @return number of velocity passes
+     */
+    uint32_t GetVelocityIterations() const;
+
+    /**
+     * @brief Returns the number of passes over the contact position constraints
+     * @return number of position passes
+     */
+    uint32_t GetPositionIterations() const;
+
+    /**
+     * @brief Enables solving pairs of contacts between the same bodies as a single block
+     *
+     * Used by the sequential solver mode only.
+     *
+     * @param enabled block solver state
+     */
+    void SetBlockSolverEnabled(bool enabled);
+
+    /**
+     * @brief Returns whether pairs of contacts between the same bodies are solved as a single block
+     * @return block solver state
+     */
+    bool IsBlockSolverEnabled() const;
+
+    /**
+     * @brief Sets the residual below which the velocity iterations stop early
+     *
+     * The residual is the sum of the absolute lagrangian multiplier changes made by an iteration.
+     *
+     * @param tolerance residual tolerance, 0 disables the early out
+     */
+    void SetSolverTolerance(float tolerance);
+
+    /**
+     * @brief Returns the residual below which the velocity iterations stop early
+     * @return residual tolerance
+     */
+    float GetSolverTolerance() const;
+
+    /**
+     * @brief Enables picking velocity iterations of each island on its own
+     *
+     * Islands get iterations from their contact graph distance to a static body and
+     * the residual of their previous step. Used by the sequential solver mode only,
+     * joints are still solved on every iteration.
+     *
+     * @param enabled adaptive iterations flag
+     */
+    void SetAdaptiveIterationsEnabled(bool enabled);
+
+    /**
+     * @brief Checks if velocity iterations are picked for each island on its own
+     * @return @c true if the adaptive iterations are enabled
+     */
+    bool IsAdaptiveIterationsEnabled() const;
+
+    /**
+     * @brief Sets the maximum number of contact solves per step of the adaptive iterations
+     *
+     * When the islands ask for more, their iterations are scaled down proportionally,
+     * keeping at least one iteration each.
+     *
+     * @param budget number of contact solves, 0 means unlimited
+     */
+    void SetSolverIterationBudget(uint32_t budget);
+
+    /**
+     * @brief Returns the maximum number of contact solves per step of the adaptive iterations
+     * @return number of contact solves
+     */
+    uint32_t GetSolverIterationBudget() const;
+
+    /**
+     * @brief Returns convergence data of the last contact resolution step
+     *
+     * With sub-stepping enabled the data describes the last sub-step.
+     *
+     * @return solver statistics
+     */
+    collision::SolverStatistics const& GetSolverStatistics() const;
+
+    /**
+     * @brief Sets the instruction set used to solve colored contact batches and to integrate bodies
+     *
+     * Instruction sets not supported by the CPU are replaced with the widest supported one.
+     *
+     * @param instructionSet instruction set
+     */
+    void SetSolverInstructionSet(collision::SimdInstructionSet instructionSet);
+
+    /**
+     * @brief Returns the instruction set used to solve colored contact batches and to integrate bodies
+     * @return instruction set
+     */
+    collision::SimdInstructionSet GetSolverInstructionSet() const;
+
+    /**
+     * @brief Sets the scheme used to integrate free bodies
+     *
+     * Multi-stage schemes evaluate the force binds of a body several times per step.
+     *
+     * @param integrator integrator scheme
+     */
+    void SetIntegrator(integration::Integrator integrator);
+
+    /**
+     * @brief Returns the scheme used to integrate free bodies
+     * @return integrator scheme
+     */
+    integration::Integrator GetIntegrator() const;
+
+    /**
+     * @brief Enables or disables implicit gyroscopic torque of free bodies
+     *
+     * Keeps fast spinning elongated bodies stable without sub-stepping, disabled by default.
+     *
+     * @param enabled true to apply gyroscopic torque
+     */
+    void SetGyroscopicTorqueEnabled(bool enabled);
+
+    /**
+     * @brief Returns true if implicit gyroscopic torque is applied to free bodies
+     * @return gyroscopic torque state
+     */
+    bool IsGyroscopicTorqueEnabled() const;
+
     /**
      * @brief Returns reference to the current asset manager
      */
@@ -178,89 +562,221 @@ public:
 
     float forceDuration = 1.0f;
 
+    //!Number of solver and integration sub-steps per frame, contacts are detected once when greater than one
+    uint32_t solverSubsteps = 1;
+
+    //!Duration of the frames computed by Step, must be positive
+    float fixedStepDuration = 1.0f / 60.0f;
+
+    //!Maximum number of frames computed by a single Step call
+    uint32_t maxFixedSteps = 8;
+
+    //!Allows resting islands to be excluded from the simulation
+    bool sleepingEnabled = true;
+
+    //!Linear speed below which a body is considered resting
+    float sleepLinearVelocity = 0.8f;
+
+    //!Angular speed below which a body is considered resting
+    float sleepAngularVelocity = 1.0f;
+
+    //!Time all bodies of an island have to rest before the island falls asleep
+    float sleepDuration = 2.0f;
+
 private:
     AssetManager m_assetManager;
     std::vector<collision::Contact> m_previousContacts;
     std::vector<collision::Contact> m_persistentContacts;
     std::vector<collision::Contact> m_currentContacts;
+    collision::SolverData m_solver;
+    ThreadPool m_threadPool;
+    integration::Integrator m_integrator = integration::Integrator::EXPLICIT_EULER;
+    bool m_gyroscopicTorque = false;
+    std::vector<uint8_t> m_articulatedBodies;
+    BodyBindings m_shapeBindings;
+
+    //!Flags of the bodies that have force binds
+    std::vector<uint8_t> m_boundBodies;
+
+    uint64_t m_bindingsRevision = std::numeric_limits<uint64_t>::max();
+    std::vector<force::GlobalField> m_globalFields;
+    std::vector<force::MutualAttraction> m_attractions;
+    force::AttractorTree m_attractorTree;
+    std::vector<glm::vec3> m_sourceFields;
+    std::vector<glm::vec3> m_attractionFields;
+    std::vector<glm::vec3> m_batchedForces;
+    std::vector<glm::vec3> m_batchedTorques;
+    float m_accumulatedDuration = 0.0f;
+    std::vector<BodyTransform> m_previousTransforms;
+
+    //!Body pairs that touched when one of them fell asleep
+    std::vector<std::pair<Handle, Handle>> m_sleepingContacts;
 
     /**
-     * @brief Calculates force applied to the bound bodies
-     * @tparam Force type of the force
+     * @brief Sorts binds of the registered force types by their bodies
+     * @param bodyCount number of bodies
      */
-    template < typename Force >
-    void ApplyForce(float duration)
-    {
-        for (Asset<ForceBind>& asset : m_assetManager.GetForceBinds<Force>())
-        {
-            if (asset.id != ZERO_HANDLE)
-            {
-                auto& force = GetForce<Force>(asset.data.force);
-                mechanics::Body& body = GetBody(asset.data.body);
-                body.linearMotion.force += force.CalculateForce(body) * duration;
-            }
-        }
-    }
+    void BindForces(uint32_t bodyCount);
 
     /**
-     * @brief Synchronizes collision geometry and point mass positions
+     * @brief Adds collision geometry of the objects to the shape bindings
      * @tparam Object body type
      * @tparam Shape collision geometry shape type
      */
     template < typename Object, typename Shape >
-    void UpdateShapes()
+    void BindShapes()
     {
         for (Asset<RigidBody>& asset : m_assetManager.GetObjects<Object, Shape>())
         {
             if (asset.id != ZERO_HANDLE)
             {
-                mechanics::Body& body = GetBody(asset.data.body);
-                auto& shape = GetShape<Shape>(asset.data.shape);
-                shape.centerOfMass = body.linearMotion.position;
-                shape.orientation = body.angularMotion.orientation;
+                AddBodyBinding(m_shapeBindings, asset.data.body, { &Scene::UpdateBoundShape<Shape>, asset.data.shape });
             }
         }
     }
 
     /**
-     * @brief Applies all registered forces to the bodies
+     * @brief Synchronizes collision geometry and point mass positions
+     * @tparam Shape collision geometry shape type
+     * @param[in,out] assets current assets
+     * @param[in]     shape  shape handle
+     * @param[in]     body   body data
      */
-    void ApplyForces(float duration);
+    template < typename Shape >
+    static void UpdateBoundShape(AssetManager& assets, Handle shape, mechanics::Body& body, float)
+    {
+        Shape& data = assets.GetAsset(assets.GetShapes<Shape>(), shape);
+        data.centerOfMass = body.linearMotion.position;
+        data.orientation = body.angularMotion.orientation;
+    }
 
     /**
-     * @brief Updates physical properties of the bodies within given duration
+     * @brief Groups force binds and dynamic collision geometry by their bodies
+     *
+     * Bindings are sorted again only after the asset layout changes, otherwise
+     * the bindings of the previous step are reused.
+     */
+    void BindBodies();
+
+    /**
+     * @brief Runs the solver and integration sub-steps using the contacts detected once
+     * @param duration delta time of the frame
+     */
+    void ComputeSubsteps(float duration);
+
+    /**
+     * @brief Applies forces, integrates the bodies and synchronizes their collision geometry
+     *
+     * Free bodies are split into chunks that run on the thread pool, each body is loaded
+     * once for all three stages.
+     *
      * @param duration delta time of the frame
      */
     void Integrate(float duration);
-};
 
-template <>
-inline void Scene::ApplyForce<force::Drag>(float duration)
-{
-    for (Asset<ForceBind>& asset : m_assetManager.GetForceBinds<force::Drag>())
-    {
-        if (asset.id != ZERO_HANDLE)
-        {
-            auto& force = GetForce<force::Drag>(asset.data.force);
-            mechanics::Body& body = GetBody(asset.data.body);
-            body.linearMotion.force += force.CalculateForce(body) * duration;
+    /**
+     * @brief Applies forces, integrates and synchronizes awake free bodies of the asset range
+     *
+     * Bodies are processed in tiles, so the structure of arrays buffer stays in the cache.
+     * Bodies with an infinite mass are only moved by their velocities.
+     *
+     * @param begin    index of the first body asset
+     * @param end      index past the last body asset, at most integration::BODY_CHUNK_SIZE after the first one
+     * @param duration delta time of the frame
+     */
+    void IntegrateBodies(uint32_t begin, uint32_t end, float duration);
 
-            glm::vec3 const velocity = body.linearMotion.velocity;
-            body.linearMotion.velocity = body.angularMotion.velocity;
-            body.angularMotion.torque += force.CalculateForce(body) * duration;
-            body.linearMotion.velocity = velocity;
+    /**
+     * @brief Applies forces to the bodies of the range, replacing their previous forces
+     * @param targets bodies of the range
+     */
+    void ApplyBodyForces(ForceTargets const& targets);
 
-            {
-                if (epona::fp::IsZero(body.angularMotion.torque.x))
-                    body.angularMotion.torque.x = 0;
-                if (epona::fp::IsZero(body.angularMotion.torque.y))
-                    body.angularMotion.torque.y = 0;
-                if (epona::fp::IsZero(body.angularMotion.torque.z))
-                    body.angularMotion.torque.z = 0;
-            }
-        }
-    }
-}
+    /**
+     * @brief Calculates fields of the mutual attractions at the bodies before they are integrated
+     *
+     * Fields depend on the positions of all attracting bodies, so they are calculated
+     * once per step instead of for each integrator stage. Sleeping bodies and bodies
+     * with an infinite mass are skipped.
+     */
+    void CalculateAttractionFields();
+
+    /**
+     * @brief Calculates forces and torques of the binds of the batched force types before the bodies are integrated
+     *
+     * Batched forces are calculated once per step from the state the step starts at,
+     * so the stages of the multi-stage integrators use them as constant forces.
+     */
+    void CalculateBatchedForces();
+
+    /**
+     * @brief Checks if the body attracts others
+     * @param attraction attraction data
+     * @param body       body data
+     * @return @c true if the body is the source of the attraction
+     */
+    static bool IsAttractionSource(force::MutualAttraction const& attraction, mechanics::Body const& body);
+
+    /**
+     * @brief Builds octree over the bodies that are sources of the attraction
+     * @param attraction attraction data
+     */
+    void BuildAttractorTree(force::MutualAttraction const& attraction);
+
+    /**
+     * @brief Applies forces to the bodies of the range at the stages of the scene integrator
+     * @param[in,out] targets        bodies of the range
+     * @param[out]    positionForces forces that move the bodies, indexed as the range
+     * @param[in]     duration       delta time of the frame
+     * @param[out]    stages         scratch state of the bodies
+     */
+    void ApplyStageForces(
+        ForceTargets const& targets, glm::vec3* positionForces, float duration, integration::StageMotions& stages
+    );
+
+    /**
+     * @brief Applies forces and integrates articulations in the joint space, marks their link bodies
+     * @param duration delta time of the frame
+     */
+    void IntegrateArticulations(float duration);
+
+    /**
+     * @brief Updates rest timers and puts resting islands to sleep or wakes them up
+     *
+     * Uses islands of the last contact resolution. An island that touches an awake body
+     * is woken up, an island whose bodies all rested for the sleep duration falls asleep.
+     * Bodies without contacts fall asleep by the same rest rule when no forces act on them.
+     *
+     * @param duration delta time of the frame
+     */
+    void UpdateSleeping(float duration);
+
+    /**
+     * @brief Checks if bound forces, global fields or mutual attractions act on the body
+     * @param index body index
+     * @param body  body data
+     * @return @c true if the body is affected by any force
+     */
+    bool HasForces(uint32_t index, mechanics::Body const& body) const;
+
+    /**
+     * @brief Wakes up the bodies that touched the given one during the last frame or when they fell asleep
+     * @param handle body handle
+     */
+    void WakeUpTouching(Handle handle);
+
+    /**
+     * @brief Puts the body to sleep and stops it
+     * @param body body data
+     */
+    static void Sleep(mechanics::Body& body);
+
+    /**
+     * @brief Wakes the body up and resets its rest timer
+     * @param body body data
+     */
+    static void WakeUp(mechanics::Body& body);
+};
 
 } // namespace scene
 } // namespace pegasus
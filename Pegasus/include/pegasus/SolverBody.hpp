@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_SOLVER_BODY_HPP
+#define PEGASUS_SOLVER_BODY_HPP
+
+#include <pegasus/AssetManager.hpp>
+#include <pegasus/Contact.hpp>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace pegasus
+{
+namespace collision
+{
+
+//!Index of a body that is not loaded into the solver
+uint32_t const INVALID_SOLVER_BODY = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Stores the part of the body data used by the contact solver
+ */
+struct SolverBody
+{
+    glm::vec3 linearVelocity = { 0, 0, 0 };
+    glm::vec3 angularVelocity = { 0, 0, 0 };
+    float inverseMass = 0.0f;
+    mechanics::SymmetricMatrix3 inverseInertia;
+
+    //!Velocities used only to resolve penetration, they move the body without changing its momentum
+    glm::vec3 pseudoLinearVelocity = { 0, 0, 0 };
+    glm::vec3 pseudoAngularVelocity = { 0, 0, 0 };
+
+    //!Transform of the body at the time it was loaded
+    glm::vec3 position = { 0, 0, 0 };
+    glm::quat orientation;
+};
+
+/**
+ * @brief Stores densely packed solver bodies of a single resolution step
+ *
+ * Bodies referenced by contacts are copied here once per step, the solver
+ * reads and writes only this array and the results are written back
+ * to the scene bodies once at the end of the step.
+ */
+struct SolverBodies
+{
+    //!Solver body data
+    std::vector<SolverBody> bodies;
+
+    //!Scene body handle of each solver body
+    std::vector<scene::Handle> handles;
+
+    //!Solver body index of each scene body, indexed by handle - 1
+    std::vector<uint32_t> indices;
+};
+
+/**
+ * @brief Returns solver body index of the given scene body, loads the body if needed
+ * @param[in,out] assetManager asset manager
+ * @param[in,out] solverBodies solver body storage
+ * @param[in] handle scene body handle
+ * @return solver body index
+ */
+inline uint32_t MakeSolverBody(
+    scene::AssetManager& assetManager, SolverBodies& solverBodies, scene::Handle handle
+)
+{
+    std::vector<scene::Asset<mechanics::Body>>& bodies = assetManager.GetBodies();
+    if (solverBodies.indices.size() < bodies.size())
+    {
+        solverBodies.indices.resize(bodies.size(), INVALID_SOLVER_BODY);
+    }
+
+    uint32_t& index = solverBodies.indices[handle - 1];
+    if (index == INVALID_SOLVER_BODY)
+    {
+        mechanics::Body const& body = assetManager.GetAsset(bodies, handle);
+
+        index = static_cast<uint32_t>(solverBodies.bodies.size());
+        solverBodies.bodies.push_back(SolverBody{
+            body.linearMotion.velocity,
+            body.angularMotion.velocity,
+            body.material.GetInverseMass(),
+            body.inverseInertia,
+            glm::vec3(0),
+            glm::vec3(0),
+            body.linearMotion.position,
+            body.angularMotion.orientation,
+        });
+        solverBodies.handles.push_back(handle);
+    }
+
+    return index;
+}
+
+/**
+ * @brief Loads bodies referenced by the contacts into the solver body storage
+ *
+ * Assigns solver body indices to the contacts and caches contact points
+ * relative to the centers of mass of the bodies.
+ *
+ * @param[in,out] assetManager asset manager
+ * @param[in,out] contacts contacts to be solved
+ * @param[out] solverBodies solver body storage
+ */
+inline void LoadSolverBodies(
+    scene::AssetManager& assetManager, std::vector<Contact>& contacts, SolverBodies& solverBodies
+)
+{
+    for (scene::Handle const handle : solverBodies.handles)
+    {
+        solverBodies.indices[handle - 1] = INVALID_SOLVER_BODY;
+    }
+    solverBodies.bodies.clear();
+    solverBodies.handles.clear();
+
+    for (Contact& contact : contacts)
+    {
+        contact.aSolverBody = MakeSolverBody(assetManager, solverBodies, contact.aBodyHandle);
+        contact.bSolverBody = MakeSolverBody(assetManager, solverBodies, contact.bBodyHandle);
+
+        contact.aRelativePosition = contact.manifold.points.aWorldSpace
+            - assetManager.GetAsset(assetManager.GetBodies(), contact.aBodyHandle).linearMotion.position;
+        contact.bRelativePosition = contact.manifold.points.bWorldSpace
+            - assetManager.GetAsset(assetManager.GetBodies(), contact.bBodyHandle).linearMotion.position;
+    }
+}
+
+/**
+ * @brief Reloads velocities and world space inverse inertia of the solver bodies from the scene bodies
+ * @param[in]     assetManager asset manager
+ * @param[in,out] solverBodies solver body storage
+ */
+inline void ReloadSolverBodies(scene::AssetManager& assetManager, SolverBodies& solverBodies)
+{
+    for (size_t i = 0; i < solverBodies.bodies.size(); ++i)
+    {
+        SolverBody& solverBody = solverBodies.bodies[i];
+        mechanics::Body const& body = assetManager.GetAsset(assetManager.GetBodies(), solverBodies.handles[i]);
+        solverBody.linearVelocity = body.linearMotion.velocity;
+        solverBody.angularVelocity = body.angularMotion.velocity;
+        solverBody.inverseInertia = body.inverseInertia;
+        solverBody.pseudoLinearVelocity = glm::vec3(0);
+        solverBody.pseudoAngularVelocity = glm::vec3(0);
+    }
+}
+
+/**
+ * @brief Moves the scene bodies by the pseudo velocities of their solver bodies
+ * @param[in,out] assetManager asset manager
+ * @param[in]     solverBodies solver body storage
+ * @param[in]     duration     delta time of the frame
+ */
+inline void ApplyPseudoVelocities(scene::AssetManager& assetManager, SolverBodies const& solverBodies, float duration)
+{
+    for (size_t i = 0; i < solverBodies.bodies.size(); ++i)
+    {
+        SolverBody const& solverBody = solverBodies.bodies[i];
+        if (solverBody.inverseMass == 0)
+        {
+            continue;
+        }
+
+        mechanics::Body& body = assetManager.GetAsset(assetManager.GetBodies(), solverBodies.handles[i]);
+        body.linearMotion.position += solverBody.pseudoLinearVelocity * duration;
+
+        glm::quat const velocityQuad{
+            0, solverBody.pseudoAngularVelocity.x, solverBody.pseudoAngularVelocity.y, solverBody.pseudoAngularVelocity.z
+        };
+        glm::quat& orientation = body.angularMotion.orientation;
+        orientation = glm::normalize(orientation + duration * velocityQuad * 0.5f * orientation);
+        mechanics::UpdateInverseInertia(body);
+    }
+}
+
+/**
+ * @brief Writes solver body velocities back to the scene bodies
+ * @param[in,out] assetManager asset manager
+ * @param[in] solverBodies solver body storage
+ */
+inline void StoreSolverBodies(scene::AssetManager& assetManager, SolverBodies const& solverBodies)
+{
+    for (size_t i = 0; i < solverBodies.bodies.size(); ++i)
+    {
+        SolverBody const& solverBody = solverBodies.bodies[i];
+        if (solverBody.inverseMass == 0)
+        {
+            continue;
+        }
+
+        mechanics::Body& body = assetManager.GetAsset(assetManager.GetBodies(), solverBodies.handles[i]);
+        body.linearMotion.velocity = solverBody.linearVelocity;
+        body.angularMotion.velocity = solverBody.angularVelocity;
+
+        assert(!std::isinf(body.angularMotion.velocity.x)
+            && !std::isinf(body.angularMotion.velocity.y)
+            && !std::isinf(body.angularMotion.velocity.z));
+    }
+}
+
+} // namespace collision
+} // namespace pegasus
+#endif // PEGASUS_SOLVER_BODY_HPP
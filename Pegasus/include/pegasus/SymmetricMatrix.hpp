@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_SYMMETRIC_MATRIX_HPP
+#define PEGASUS_SYMMETRIC_MATRIX_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace pegasus
+{
+namespace mechanics
+{
+
+/**
+ * @brief Stores symmetric 3x3 matrix as its upper triangle
+ */
+struct SymmetricMatrix3
+{
+    //!Constructs zero matrix
+    SymmetricMatrix3() = default;
+
+    //!Constructs matrix from the upper triangle of the given matrix
+    explicit SymmetricMatrix3(glm::mat3 const& m)
+        : xx(m[0][0]), xy(m[1][0]), xz(m[2][0]), yy(m[1][1]), yz(m[2][1]), zz(m[2][2])
+    {
+    }
+
+    glm::vec3 operator*(glm::vec3 v) const
+    {
+        return {
+            xx * v.x + xy * v.y + xz * v.z,
+            xy * v.x + yy * v.y + yz * v.z,
+            xz * v.x + yz * v.y + zz * v.z,
+        };
+    }
+
+    float xx = 0.0f;
+    float xy = 0.0f;
+    float xz = 0.0f;
+    float yy = 0.0f;
+    float yz = 0.0f;
+    float zz = 0.0f;
+};
+
+/**
+ * @brief Rotates body space inertia tensor into the world space
+ *
+ * Calculates R * I * R^T where R is the rotation matrix of the orientation.
+ *
+ * @param orientation body orientation
+ * @param inertia     body space inertia tensor
+ * @return world space inertia tensor
+ */
+inline SymmetricMatrix3 RotateInertia(glm::quat const& orientation, glm::mat3 const& inertia)
+{
+    glm::mat3 const rotation = glm::mat3_cast(orientation);
+    return SymmetricMatrix3(rotation * inertia * glm::transpose(rotation));
+}
+
+} // namespace mechanics
+} // namespace pegasus
+#endif // PEGASUS_SYMMETRIC_MATRIX_HPP
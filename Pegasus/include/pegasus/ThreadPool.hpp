@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_THREAD_POOL_HPP
+#define PEGASUS_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pegasus
+{
+
+/**
+ * @brief Fixed size pool of worker threads running parallel loops
+ *
+ * The calling thread always takes part in the loop execution, so a pool
+ * with the thread count of 1 has no workers and runs everything inline.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Constructs thread pool
+     * @param threadCount total number of threads including the calling one
+     */
+    explicit ThreadPool(uint32_t threadCount = 1);
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    /**
+     * @brief Stops and joins worker threads
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Restarts the pool with the given number of threads
+     * @param threadCount total number of threads including the calling one
+     */
+    void SetThreadCount(uint32_t threadCount);
+
+    /**
+     * @brief Returns total number of threads including the calling one
+     * @return number of threads
+     */
+    uint32_t GetThreadCount() const;
+
+    /**
+     * @brief Runs @p task for every index in [0, count) and waits for completion
+     *
+     * Indices are distributed between the threads dynamically, no order is guaranteed.
+     *
+     * @param count number of indices
+     * @param task task to be called with each index
+     */
+    void ParallelFor(size_t count, std::function<void(size_t)> const& task);
+
+private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_jobCondition;
+    std::condition_variable m_doneCondition;
+
+    std::function<void(size_t)> const* m_pTask = nullptr;
+    size_t m_taskCount = 0;
+    std::atomic<size_t> m_nextTask;
+    uint64_t m_generation = 0;
+    uint32_t m_activeWorkers = 0;
+    bool m_stop = false;
+
+    /**
+     * @brief Runs tasks of the current job until none is left
+     */
+    void RunTasks();
+
+    /**
+     * @brief Worker thread main loop
+     * @param generation generation of the last job started before the worker
+     */
+    void WorkerLoop(uint64_t generation);
+
+    /**
+     * @brief Stops and joins all worker threads
+     */
+    void Stop();
+};
+
+} // namespace pegasus
+
+#endif // PEGASUS_THREAD_POOL_HPP
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_WIDE_CONTACT_SOLVER_HPP
+#define PEGASUS_WIDE_CONTACT_SOLVER_HPP
+
+#include <pegasus/Contact.hpp>
+#include <pegasus/SolverBody.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace pegasus
+{
+namespace collision
+{
+
+/**
+ * @brief Defines the vector instruction set used by the contact solver
+ */
+enum class SimdInstructionSet : uint8_t
+{
+    //!Contacts are solved one at a time
+    NONE,
+
+    //!Four contacts are solved at a time
+    SSE,
+
+    //!Eight contacts are solved at a time
+    AVX2
+};
+
+/**
+ * @brief Stores parameters of a single contact solver pass
+ */
+struct ContactSolverSettings
+{
+    //!Delta time of the frame
+    float duration = 0.0f;
+
+    //!Factor applied to the stored lagrangian multipliers before solving
+    float warmStartFactor = 0.0f;
+
+    //!Factor applied to the velocity change of the contact
+    float impulseFactor = 1.0f;
+
+    //!Factor of the penetration fed into the contact velocity, zero disables Baumgarte stabilization
+    float baumgarteFactor = 0.1f;
+};
+
+/**
+ * @brief Returns the widest instruction set supported by the CPU and the library build
+ *
+ * The CPU is queried once, subsequent calls return the cached result.
+ *
+ * @return instruction set
+ */
+SimdInstructionSet DetectSimdInstructionSet();
+
+/**
+ * @brief Solves contacts that do not share bodies with a finite mass
+ *
+ * Contacts are processed in groups of the instruction set width, velocities of
+ * the group bodies are gathered into lanes, solved at once and scattered back.
+ * The remaining contacts are solved one at a time.
+ *
+ * @param[in,out] solverBodies   solver bodies
+ * @param[in,out] contacts       contacts
+ * @param[in]     indices        indices of the contacts to be solved
+ * @param[in]     count          number of indices
+ * @param[in]     settings       solver pass parameters
+ * @param[in]     instructionSet instruction set, must be supported by the CPU
+ */
+void SolveContactBatch(
+    SolverBodies& solverBodies, std::vector<Contact>& contacts,
+    uint32_t const* indices, uint32_t count,
+    ContactSolverSettings const& settings, SimdInstructionSet instructionSet
+);
+
+} // namespace collision
+} // namespace pegasus
+#endif // PEGASUS_WIDE_CONTACT_SOLVER_HPP
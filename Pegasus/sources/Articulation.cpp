@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#include <pegasus/Articulation.hpp>
+
+#include <algorithm>
+
+namespace pegasus
+{
+namespace mechanics
+{
+namespace
+{
+
+/**
+ * @brief Stores spatial motion vector referenced at the articulation base
+ */
+struct SpatialMotion
+{
+    glm::vec3 angular = { 0, 0, 0 };
+    glm::vec3 linear = { 0, 0, 0 };
+};
+
+/**
+ * @brief Stores spatial force vector referenced at the articulation base
+ */
+struct SpatialForce
+{
+    glm::vec3 angular = { 0, 0, 0 };
+    glm::vec3 linear = { 0, 0, 0 };
+};
+
+/**
+ * @brief Stores spatial inertia as a block matrix that maps motion vectors to force vectors
+ */
+struct SpatialInertia
+{
+    glm::mat3 angularAngular = glm::mat3(0);
+    glm::mat3 angularLinear = glm::mat3(0);
+    glm::mat3 linearAngular = glm::mat3(0);
+    glm::mat3 linearLinear = glm::mat3(0);
+};
+
+SpatialMotion operator+(SpatialMotion const& a, SpatialMotion const& b)
+{
+    return { a.angular + b.angular, a.linear + b.linear };
+}
+
+SpatialMotion operator*(SpatialMotion const& a, float s)
+{
+    return { a.angular * s, a.linear * s };
+}
+
+SpatialForce operator+(SpatialForce const& a, SpatialForce const& b)
+{
+    return { a.angular + b.angular, a.linear + b.linear };
+}
+
+SpatialForce operator-(SpatialForce const& a, SpatialForce const& b)
+{
+    return { a.angular - b.angular, a.linear - b.linear };
+}
+
+SpatialForce operator*(SpatialForce const& a, float s)
+{
+    return { a.angular * s, a.linear * s };
+}
+
+SpatialForce operator*(SpatialInertia const& inertia, SpatialMotion const& motion)
+{
+    return {
+        inertia.angularAngular * motion.angular + inertia.angularLinear * motion.linear,
+        inertia.linearAngular * motion.angular + inertia.linearLinear * motion.linear,
+    };
+}
+
+SpatialInertia& operator+=(SpatialInertia& a, SpatialInertia const& b)
+{
+    a.angularAngular += b.angularAngular;
+    a.angularLinear += b.angularLinear;
+    a.linearAngular += b.linearAngular;
+    a.linearLinear += b.linearLinear;
+    return a;
+}
+
+float Dot(SpatialMotion const& motion, SpatialForce const& force)
+{
+    return glm::dot(motion.angular, force.angular) + glm::dot(motion.linear, force.linear);
+}
+
+/**
+ * @brief Calculates spatial cross product of the motion vectors
+ */
+SpatialMotion CrossMotion(SpatialMotion const& velocity, SpatialMotion const& motion)
+{
+    return {
+        glm::cross(velocity.angular, motion.angular),
+        glm::cross(velocity.angular, motion.linear) + glm::cross(velocity.linear, motion.angular),
+    };
+}
+
+/**
+ * @brief Calculates spatial cross product of the motion and the force vectors
+ */
+SpatialForce CrossForce(SpatialMotion const& velocity, SpatialForce const& force)
+{
+    return {
+        glm::cross(velocity.angular, force.angular) + glm::cross(velocity.linear, force.linear),
+        glm::cross(velocity.angular, force.linear),
+    };
+}
+
+/**
+ * @brief Returns matrix of the cross product with the given vector
+ */
+glm::mat3 Skew(glm::vec3 v)
+{
+    return glm::mat3(0, v.z, -v.y, -v.z, 0, v.x, v.y, -v.x, 0);
+}
+
+/**
+ * @brief Calculates spatial inertia of the body referenced at the articulation base
+ * @param mass          mass of the body
+ * @param inertia       world space moment of inertia about the center of mass
+ * @param centerOfMass  center of mass relative to the articulation base
+ * @return spatial inertia
+ */
+SpatialInertia MakeSpatialInertia(float mass, glm::mat3 const& inertia, glm::vec3 centerOfMass)
+{
+    glm::mat3 const skew = Skew(centerOfMass);
+    return { inertia - skew * skew * mass, skew * mass, skew * -mass, glm::mat3(mass) };
+}
+
+/**
+ * @brief Stores world space data of a link
+ */
+struct LinkFrame
+{
+    glm::quat orientation;
+    glm::vec3 position;
+    glm::vec3 lever;
+    SpatialMotion subspace;
+    SpatialInertia inertia;
+    glm::mat3 momentOfInertia;
+    float mass;
+};
+
+/**
+ * @brief Calculates world space frames of the links from the joint angles
+ */
+void CalculateLinkFrames(
+    Articulation const& articulation, std::vector<scene::Asset<Body>> const& bodies, std::vector<LinkFrame>& frames
+)
+{
+    Body const& base = bodies[articulation.base - 1].data;
+
+    frames.resize(articulation.links.size());
+    for (size_t i = 0; i < articulation.links.size(); ++i)
+    {
+        ArticulationLink const& link = articulation.links[i];
+        Body const& body = bodies[link.body - 1].data;
+        bool const isRoot = link.parent == ARTICULATION_BASE;
+        glm::quat const& parentOrientation = isRoot ? base.angularMotion.orientation : frames[link.parent].orientation;
+        glm::vec3 const& parentPosition = isRoot ? base.linearMotion.position : frames[link.parent].position;
+
+        LinkFrame& frame = frames[i];
+        frame.orientation = glm::normalize(
+            parentOrientation * link.restOrientation * glm::angleAxis(link.angle, link.axis)
+        );
+        glm::vec3 const joint = parentPosition + parentOrientation * link.parentOffset;
+        frame.position = joint + frame.orientation * link.childOffset;
+
+        glm::vec3 const axis = frame.orientation * link.axis;
+        frame.lever = frame.position - base.linearMotion.position;
+        frame.subspace = { axis, glm::cross(joint - base.linearMotion.position, axis) };
+
+        glm::mat3 const rotation = glm::mat3_cast(frame.orientation);
+        frame.mass = body.material.GetMass();
+        frame.momentOfInertia = rotation * body.material.GetMomentOfInertia() * glm::transpose(rotation);
+        frame.inertia = MakeSpatialInertia(frame.mass, frame.momentOfInertia, frame.lever);
+    }
+}
+
+/**
+ * @brief Calculates joint accelerations with the articulated body algorithm
+ * @param[in]  articulation articulation data
+ * @param[in]  frames       link frames
+ * @param[in]  velocities   spatial velocities of the links
+ * @param[in]  biasForces   velocity product forces minus the external forces of the links
+ * @param[in]  torques      torques applied along the joint axes
+ * @param[out] accelerations joint accelerations
+ */
+void CalculateJointAccelerations(
+    Articulation const& articulation, std::vector<LinkFrame> const& frames,
+    std::vector<SpatialMotion> const& velocities, std::vector<SpatialForce> const& biasForces,
+    std::vector<float> const& torques, std::vector<float>& accelerations
+)
+{
+    size_t const count = articulation.links.size();
+    std::vector<SpatialInertia> articulatedInertias(count);
+    std::vector<SpatialForce> articulatedForces(count);
+    std::vector<SpatialMotion> velocityProducts(count);
+    std::vector<SpatialForce> inertiaSubspaces(count);
+    std::vector<float> subspaceInertias(count);
+    std::vector<float> forceResiduals(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        articulatedInertias[i] = frames[i].inertia;
+        articulatedForces[i] = biasForces[i];
+        velocityProducts[i] = CrossMotion(velocities[i], frames[i].subspace * articulation.links[i].velocity);
+    }
+
+    //Accumulate articulated inertias from the leaves to the base
+    for (size_t i = count; i-- > 0;)
+    {
+        SpatialMotion const& subspace = frames[i].subspace;
+        inertiaSubspaces[i] = articulatedInertias[i] * subspace;
+        subspaceInertias[i] = Dot(subspace, inertiaSubspaces[i]);
+        forceResiduals[i] = torques[i] - Dot(subspace, articulatedForces[i]);
+
+        uint32_t const parent = articulation.links[i].parent;
+        if (parent == ARTICULATION_BASE)
+        {
+            continue;
+        }
+
+        SpatialForce const& u = inertiaSubspaces[i];
+        float const inverseD = 1.0f / subspaceInertias[i];
+        SpatialInertia inertia = articulatedInertias[i];
+        inertia.angularAngular = inertia.angularAngular - glm::outerProduct(u.angular, u.angular) * inverseD;
+        inertia.angularLinear = inertia.angularLinear - glm::outerProduct(u.angular, u.linear) * inverseD;
+        inertia.linearAngular = inertia.linearAngular - glm::outerProduct(u.linear, u.angular) * inverseD;
+        inertia.linearLinear = inertia.linearLinear - glm::outerProduct(u.linear, u.linear) * inverseD;
+
+        articulatedInertias[parent] += inertia;
+        articulatedForces[parent] = articulatedForces[parent] + articulatedForces[i]
+            + inertia * velocityProducts[i] + u * (forceResiduals[i] * inverseD);
+    }
+
+    //Propagate accelerations from the base to the leaves, the base does not accelerate
+    std::vector<SpatialMotion> linkAccelerations(count);
+    accelerations.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t const parent = articulation.links[i].parent;
+        SpatialMotion const acceleration =
+            (parent == ARTICULATION_BASE ? SpatialMotion() : linkAccelerations[parent]) + velocityProducts[i];
+
+        accelerations[i] = (forceResiduals[i] - Dot(acceleration, inertiaSubspaces[i])) / subspaceInertias[i];
+        linkAccelerations[i] = acceleration + frames[i].subspace * accelerations[i];
+    }
+}
+
+/**
+ * @brief Calculates spatial velocities of the links from the joint velocities
+ */
+void CalculateLinkVelocities(
+    Articulation const& articulation, std::vector<LinkFrame> const& frames, std::vector<SpatialMotion>& velocities
+)
+{
+    velocities.resize(articulation.links.size());
+    for (size_t i = 0; i < articulation.links.size(); ++i)
+    {
+        ArticulationLink const& link = articulation.links[i];
+        SpatialMotion const parentVelocity =
+            link.parent == ARTICULATION_BASE ? SpatialMotion() : velocities[link.parent];
+        velocities[i] = parentVelocity + frames[i].subspace * link.velocity;
+    }
+}
+
+/**
+ * @brief Converts changes of the link body motion into the joint changes
+ *
+ * Each body change is weighted by the body mass, so the result is the joint space change
+ * that matches body changes best in the least squares sense.
+ *
+ * @param[in]  articulation   articulation data
+ * @param[in]  frames         link frames
+ * @param[in]  linearChanges  linear changes of the link bodies
+ * @param[in]  angularChanges angular changes of the link bodies
+ * @param[out] jointChanges   joint coordinate changes
+ */
+void ProjectBodyChanges(
+    Articulation const& articulation, std::vector<LinkFrame> const& frames,
+    std::vector<glm::vec3> const& linearChanges, std::vector<glm::vec3> const& angularChanges,
+    std::vector<float>& jointChanges
+)
+{
+    size_t const count = articulation.links.size();
+    std::vector<SpatialMotion> const zeroVelocities(count);
+    std::vector<float> const zeroTorques(count, 0.0f);
+    std::vector<SpatialForce> impulses(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 const impulse = linearChanges[i] * frames[i].mass;
+        glm::vec3 const angularImpulse = frames[i].momentOfInertia * angularChanges[i];
+        impulses[i] = SpatialForce{ angularImpulse + glm::cross(frames[i].lever, impulse), impulse } * -1.0f;
+    }
+
+    CalculateJointAccelerations(articulation, frames, zeroVelocities, impulses, zeroTorques, jointChanges);
+}
+
+} // namespace
+
+ArticulationLink MakeRevoluteLink(
+    Body const& parent, uint32_t parentIndex, scene::Handle handle, Body const& body, glm::vec3 anchor, glm::vec3 axis
+)
+{
+    glm::quat const inverseParentOrientation = glm::conjugate(parent.angularMotion.orientation);
+    glm::quat const inverseOrientation = glm::conjugate(body.angularMotion.orientation);
+
+    ArticulationLink link;
+    link.body = handle;
+    link.parent = parentIndex;
+    link.parentOffset = inverseParentOrientation * (anchor - parent.linearMotion.position);
+    link.childOffset = inverseOrientation * (body.linearMotion.position - anchor);
+    link.restOrientation = inverseParentOrientation * body.angularMotion.orientation;
+    link.axis = inverseOrientation * glm::normalize(axis);
+    link.linearVelocity = body.linearMotion.velocity;
+    link.angularVelocity = body.angularMotion.velocity;
+
+    return link;
+}
+
+void IntegrateArticulation(Articulation& articulation, std::vector<scene::Asset<Body>>& bodies, float duration)
+{
+    size_t const count = articulation.links.size();
+    std::vector<LinkFrame> frames;
+    CalculateLinkFrames(articulation, bodies, frames);
+
+    std::vector<SpatialForce> forces(count);
+    std::vector<glm::vec3> linearChanges(count);
+    std::vector<glm::vec3> angularChanges(count);
+    std::vector<float> jointChanges;
+    std::vector<float> accelerations;
+
+    //Convert body displacements made by the position solver into joint displacements
+    for (size_t i = 0; i < count; ++i)
+    {
+        Body const& body = bodies[articulation.links[i].body - 1].data;
+        glm::quat const rotation = body.angularMotion.orientation * glm::conjugate(frames[i].orientation);
+        linearChanges[i] = body.linearMotion.position - frames[i].position;
+        angularChanges[i] = glm::vec3(rotation.x, rotation.y, rotation.z) * (rotation.w < 0.0f ? -2.0f : 2.0f);
+    }
+    ProjectBodyChanges(articulation, frames, linearChanges, angularChanges, jointChanges);
+    for (size_t i = 0; i < count; ++i)
+    {
+        articulation.links[i].angle += jointChanges[i];
+    }
+    CalculateLinkFrames(articulation, bodies, frames);
+
+    //Convert body velocity changes made since the last integration into joint velocity changes
+    for (size_t i = 0; i < count; ++i)
+    {
+        ArticulationLink const& link = articulation.links[i];
+        Body const& body = bodies[link.body - 1].data;
+        linearChanges[i] = body.linearMotion.velocity - link.linearVelocity;
+        angularChanges[i] = body.angularMotion.velocity - link.angularVelocity;
+    }
+    ProjectBodyChanges(articulation, frames, linearChanges, angularChanges, jointChanges);
+    for (size_t i = 0; i < count; ++i)
+    {
+        articulation.links[i].velocity += jointChanges[i];
+    }
+
+    //Forward dynamics with the accumulated body forces, the forces are held constant over the substeps
+    std::vector<glm::vec3> linearForces(count);
+    std::vector<glm::vec3> angularForces(count);
+    std::vector<float> torques(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        ArticulationLink const& link = articulation.links[i];
+        Body& body = bodies[link.body - 1].data;
+        linearForces[i] = body.linearMotion.force + body.linearMotion.acceleration * frames[i].mass;
+        angularForces[i] = body.angularMotion.torque + frames[i].momentOfInertia * body.angularMotion.acceleration;
+        torques[i] = link.torque;
+
+        body.linearMotion.force = glm::vec3(0);
+        body.angularMotion.torque = glm::vec3(0);
+    }
+
+    std::vector<SpatialMotion> velocities;
+    uint32_t const substeps = std::max(articulation.substeps, 1u);
+    float const substepDuration = duration / static_cast<float>(substeps);
+    float const damping = 1.0f / (1.0f + articulation.damping * substepDuration);
+    for (uint32_t substep = 0; substep < substeps; ++substep)
+    {
+        if (substep != 0)
+        {
+            CalculateLinkFrames(articulation, bodies, frames);
+        }
+        CalculateLinkVelocities(articulation, frames, velocities);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            SpatialForce const externalForce{
+                angularForces[i] + glm::cross(frames[i].lever, linearForces[i]), linearForces[i]
+            };
+            forces[i] = CrossForce(velocities[i], frames[i].inertia * velocities[i]) - externalForce;
+        }
+        CalculateJointAccelerations(articulation, frames, velocities, forces, torques, accelerations);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            ArticulationLink& link = articulation.links[i];
+            link.velocity = (link.velocity + accelerations[i] * substepDuration) * damping;
+            link.angle += link.velocity * substepDuration;
+        }
+    }
+
+    //Place link bodies
+    CalculateLinkFrames(articulation, bodies, frames);
+    CalculateLinkVelocities(articulation, frames, velocities);
+    for (size_t i = 0; i < count; ++i)
+    {
+        ArticulationLink& link = articulation.links[i];
+        Body& body = bodies[link.body - 1].data;
+
+        link.angularVelocity = velocities[i].angular;
+        link.linearVelocity = velocities[i].linear + glm::cross(velocities[i].angular, frames[i].lever);
+
+        body.linearMotion.position = frames[i].position;
+        body.linearMotion.velocity = link.linearVelocity;
+        body.angularMotion.orientation = frames[i].orientation;
+        body.angularMotion.velocity = link.angularVelocity;
+        UpdateInverseInertia(body);
+    }
+}
+
+} // namespace mechanics
+} // namespace pegasus
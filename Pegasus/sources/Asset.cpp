@@ -21,7 +21,9 @@ RigidBody::RigidBody(Scene& scene, Handle body, Handle shape)
 StaticBody::StaticBody(Scene& scene, Handle body, Handle shape)
     : RigidBody(scene, body, shape)
 {
-    scene.GetBody(body).material.SetInfiniteMass();
+    mechanics::Body& data = scene.GetBody(body);
+    data.material.SetInfiniteMass();
+    mechanics::UpdateInverseInertia(data);
 }
 
 DynamicBody::DynamicBody(Scene& scene, Handle body, Handle shape)
@@ -29,5 +31,13 @@ DynamicBody::DynamicBody(Scene& scene, Handle body, Handle shape)
 {
 }
 
+KinematicBody::KinematicBody(Scene& scene, Handle body, Handle shape)
+    : RigidBody(scene, body, shape)
+{
+    mechanics::Body& data = scene.GetBody(body);
+    data.material.SetInfiniteMass();
+    mechanics::UpdateInverseInertia(data);
+}
+
 } // namespace scene
 } // namespace pegasus
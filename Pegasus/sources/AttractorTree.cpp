@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#include <pegasus/AttractorTree.hpp>
+#include "SimdPack.hpp"
+#include <algorithm>
+
+namespace
+{
+
+#ifdef PEGASUS_SIMD_X86_64
+using FieldPack = pegasus::simd::SsePack;
+#else
+using FieldPack = pegasus::simd::ScalarPack;
+#endif
+
+//!Maximum number of attractors in the leaf node
+uint32_t const LEAF_SIZE = 8;
+
+//!Maximum number of attractors in the group sharing one traversal
+uint32_t const GROUP_SIZE = 32;
+
+//!Maximum node depth, coincident attractors share the leaf once it is reached
+uint32_t const MAX_DEPTH = 20;
+
+//!Maximum number of nodes waiting on the traversal stack
+uint32_t const STACK_SIZE = 8 * (MAX_DEPTH + 1);
+
+/**
+ * @brief Calculates field of the sources at the given position
+ * @param position    point the field is calculated at
+ * @param sources     source rows of x, y, z and strength, padded to the pack width
+ * @param stride      distance between the source rows
+ * @param softeningSq squared softening distance
+ * @return field vector
+ */
+glm::vec3 CalculateSourcesField(glm::vec3 const& position, float const* sources, uint32_t stride, float softeningSq)
+{
+    using pegasus::simd::Vec3Pack;
+
+    Vec3Pack<FieldPack> const point{
+        FieldPack::Set(position.x), FieldPack::Set(position.y), FieldPack::Set(position.z)
+    };
+    FieldPack const softening = FieldPack::Set(softeningSq);
+    FieldPack const zero = FieldPack::Set(0.0f);
+    Vec3Pack<FieldPack> field{ zero, zero, zero };
+
+    for (uint32_t i = 0; i < stride; i += FieldPack::WIDTH)
+    {
+        Vec3Pack<FieldPack> const direction = Vec3Pack<FieldPack>{
+            FieldPack::Load(sources + i), FieldPack::Load(sources + stride + i), FieldPack::Load(sources + 2 * stride + i)
+        } - point;
+        FieldPack const distanceSq = Dot(direction, direction) + softening;
+        FieldPack const factor = Select(
+            CompareGreater(distanceSq, zero),
+            FieldPack::Load(sources + 3 * stride + i) / (distanceSq * Sqrt(distanceSq)),
+            zero
+        );
+        field = field + direction * factor;
+    }
+
+    alignas(32) float lanes[3][FieldPack::WIDTH];
+    field.x.Store(lanes[0]);
+    field.y.Store(lanes[1]);
+    field.z.Store(lanes[2]);
+
+    glm::vec3 result(0);
+    for (uint32_t i = 0; i < FieldPack::WIDTH; ++i)
+    {
+        result += glm::vec3(lanes[0][i], lanes[1][i], lanes[2][i]);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Adds field of the point source to the accumulated field
+ * @param[in,out] field       accumulated field
+ * @param[in]     direction   vector from the point to the source
+ * @param[in]     strength    source strength
+ * @param[in]     softeningSq squared softening distance
+ */
+void AddField(glm::vec3& field, glm::vec3 const& direction, float strength, float softeningSq)
+{
+    float const distanceSq = glm::dot(direction, direction) + softeningSq;
+    if (distanceSq > 0.0f)
+    {
+        field += direction * (strength / (distanceSq * glm::sqrt(distanceSq)));
+    }
+}
+
+} // namespace ::
+
+namespace pegasus
+{
+namespace force
+{
+
+void AttractorTree::Clear()
+{
+    m_attractors.clear();
+    m_nodes.clear();
+    m_groups.clear();
+}
+
+void AttractorTree::Add(Attractor const& attractor)
+{
+    m_attractors.push_back(attractor);
+}
+
+void AttractorTree::Build()
+{
+    m_nodes.clear();
+    m_groups.clear();
+    if (m_attractors.empty())
+    {
+        return;
+    }
+
+    glm::vec3 lower = m_attractors.front().position;
+    glm::vec3 upper = lower;
+    for (Attractor const& attractor : m_attractors)
+    {
+        lower = glm::min(lower, attractor.position);
+        upper = glm::max(upper, attractor.position);
+    }
+
+    glm::vec3 const extent = upper - lower;
+    Node root;
+    root.center = (lower + upper) * 0.5f;
+    root.halfSize = glm::max(extent.x, glm::max(extent.y, extent.z)) * 0.5f + 1e-3f;
+    root.firstChild = 0;
+    root.childCount = 0;
+    root.firstAttractor = 0;
+    root.attractorCount = static_cast<uint32_t>(m_attractors.size());
+
+    m_scratch.resize(m_attractors.size());
+    m_nodes.push_back(root);
+    BuildNode(0, 0, false);
+}
+
+glm::vec3 AttractorTree::CalculateField(
+    glm::vec3 position, uint32_t exclude, float openingAngle, float softening
+) const
+{
+    glm::vec3 field(0);
+    if (m_nodes.empty())
+    {
+        return field;
+    }
+
+    float const openingAngleSq = openingAngle * openingAngle;
+    float const softeningSq = softening * softening;
+
+    uint32_t stack[STACK_SIZE];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize != 0)
+    {
+        Node const& node = m_nodes[stack[--stackSize]];
+        glm::vec3 const direction = node.centerOfMass - position;
+        glm::vec3 const offset = glm::abs(position - node.center);
+        bool const inside = offset.x <= node.halfSize && offset.y <= node.halfSize && offset.z <= node.halfSize;
+
+        //The node containing the point is always opened, so it never attracts the point to itself
+        float const size = 2.0f * node.halfSize;
+        if (!inside && size * size < openingAngleSq * glm::dot(direction, direction))
+        {
+            AddField(field, direction, node.strength, softeningSq);
+        }
+        else if (node.childCount == 0)
+        {
+            for (uint32_t i = node.firstAttractor; i < node.firstAttractor + node.attractorCount; ++i)
+            {
+                Attractor const& attractor = m_attractors[i];
+                if (attractor.index != exclude)
+                {
+                    AddField(field, attractor.position - position, attractor.strength, softeningSq);
+                }
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < node.childCount; ++i)
+            {
+                stack[stackSize++] = node.firstChild + i;
+            }
+        }
+    }
+
+    return field;
+}
+
+uint32_t AttractorTree::GetGroupCount() const
+{
+    return static_cast<uint32_t>(m_groups.size());
+}
+
+void AttractorTree::AddGroupFields(
+    uint32_t begin, uint32_t end, float openingAngle, float softening, std::vector<glm::vec3>& fields
+) const
+{
+    float const openingAngleSq = openingAngle * openingAngle;
+    float const softeningSq = softening * softening;
+
+    std::vector<glm::vec4> accepted;
+    std::vector<float> sources;
+
+    uint32_t stack[STACK_SIZE];
+    for (uint32_t groupIndex = begin; groupIndex < end; ++groupIndex)
+    {
+        Node const& group = m_nodes[m_groups[groupIndex]];
+        Attractor const* groupAttractors = m_attractors.data() + group.firstAttractor;
+
+        glm::vec3 lower = groupAttractors[0].position;
+        glm::vec3 upper = lower;
+        for (uint32_t i = 1; i < group.attractorCount; ++i)
+        {
+            lower = glm::min(lower, groupAttractors[i].position);
+            upper = glm::max(upper, groupAttractors[i].position);
+        }
+
+        accepted.clear();
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize != 0)
+        {
+            Node const& node = m_nodes[stack[--stackSize]];
+
+            //The node is accepted only if it is far enough from every point of the group bounds
+            glm::vec3 const gap = glm::max(glm::max(lower - node.centerOfMass, node.centerOfMass - upper), glm::vec3(0));
+            float const size = 2.0f * node.halfSize;
+            if (size * size < openingAngleSq * glm::dot(gap, gap))
+            {
+                accepted.emplace_back(node.centerOfMass, node.strength);
+            }
+            else if (node.childCount == 0)
+            {
+                for (uint32_t i = node.firstAttractor; i < node.firstAttractor + node.attractorCount; ++i)
+                {
+                    accepted.emplace_back(m_attractors[i].position, m_attractors[i].strength);
+                }
+            }
+            else
+            {
+                for (uint32_t i = 0; i < node.childCount; ++i)
+                {
+                    stack[stackSize++] = node.firstChild + i;
+                }
+            }
+        }
+
+        //Sources are stored as rows padded with zero strength, so they are loaded in whole packs
+        uint32_t const width = FieldPack::WIDTH;
+        uint32_t const stride = (static_cast<uint32_t>(accepted.size()) + width - 1) / width * width;
+        sources.assign(4 * stride, 0.0f);
+        for (uint32_t i = 0; i < accepted.size(); ++i)
+        {
+            sources[i] = accepted[i].x;
+            sources[stride + i] = accepted[i].y;
+            sources[2 * stride + i] = accepted[i].z;
+            sources[3 * stride + i] = accepted[i].w;
+        }
+
+        //Attractor meets itself at zero distance, where its own field is zero
+        for (uint32_t i = 0; i < group.attractorCount; ++i)
+        {
+            fields[groupAttractors[i].index] += ::CalculateSourcesField(
+                groupAttractors[i].position, sources.data(), stride, softeningSq
+            );
+        }
+    }
+}
+
+void AttractorTree::BuildNode(uint32_t node, uint32_t depth, bool grouped)
+{
+    Node const current = m_nodes[node];
+    bool const leaf = current.attractorCount <= LEAF_SIZE || depth == MAX_DEPTH;
+    if (!grouped && (current.attractorCount <= GROUP_SIZE || leaf))
+    {
+        m_groups.push_back(node);
+        grouped = true;
+    }
+
+    uint32_t const begin = current.firstAttractor;
+    uint32_t const end = begin + current.attractorCount;
+
+    glm::vec3 weightedPosition(0);
+    glm::vec3 position(0);
+    float strength = 0.0f;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        weightedPosition += m_attractors[i].position * m_attractors[i].strength;
+        position += m_attractors[i].position;
+        strength += m_attractors[i].strength;
+    }
+    m_nodes[node].strength = strength;
+    m_nodes[node].centerOfMass = (strength > 0.0f)
+        ? weightedPosition / strength
+        : position / static_cast<float>(current.attractorCount);
+
+    if (leaf)
+    {
+        return;
+    }
+
+    auto const octant = [&current](glm::vec3 const& point) {
+        return (point.x >= current.center.x ? 1u : 0u)
+            | (point.y >= current.center.y ? 2u : 0u)
+            | (point.z >= current.center.z ? 4u : 0u);
+    };
+
+    uint32_t offsets[9] = {};
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        ++offsets[octant(m_attractors[i].position) + 1];
+    }
+    for (uint32_t i = 1; i < 9; ++i)
+    {
+        offsets[i] += offsets[i - 1];
+    }
+
+    uint32_t cursors[8];
+    std::copy(offsets, offsets + 8, cursors);
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        m_scratch[begin + cursors[octant(m_attractors[i].position)]++] = m_attractors[i];
+    }
+    std::copy(m_scratch.begin() + begin, m_scratch.begin() + end, m_attractors.begin() + begin);
+
+    uint32_t const firstChild = static_cast<uint32_t>(m_nodes.size());
+    float const halfSize = current.halfSize * 0.5f;
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        if (offsets[i] == offsets[i + 1])
+        {
+            continue;
+        }
+
+        Node child;
+        child.center = current.center + glm::vec3(
+            (i & 1u) ? halfSize : -halfSize, (i & 2u) ? halfSize : -halfSize, (i & 4u) ? halfSize : -halfSize
+        );
+        child.halfSize = halfSize;
+        child.firstChild = 0;
+        child.childCount = 0;
+        child.firstAttractor = begin + offsets[i];
+        child.attractorCount = offsets[i + 1] - offsets[i];
+        m_nodes.push_back(child);
+    }
+
+    uint32_t const childCount = static_cast<uint32_t>(m_nodes.size()) - firstChild;
+    m_nodes[node].firstChild = firstChild;
+    m_nodes[node].childCount = childCount;
+    for (uint32_t i = 0; i < childCount; ++i)
+    {
+        BuildNode(firstChild + i, depth + 1, grouped);
+    }
+}
+
+} // namespace force
+} // namespace pegasus
@@ -32,6 +32,10 @@ Body::Body()
     : material()
     , linearMotion()
     , angularMotion()
+    , inverseInertia(RotateInertia(angularMotion.orientation, material.GetInverseMomentOfInertia()))
+    , asleep(false)
+    , restDuration(0)
+    , groups(1)
 {
 }
 
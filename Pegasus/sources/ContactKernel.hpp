@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_CONTACT_KERNEL_HPP
+#define PEGASUS_CONTACT_KERNEL_HPP
+
+#include "SimdPack.hpp"
+#include <cstdint>
+
+/*
+ * The kernel is compiled with different instruction sets in different translation
+ * units, so it must stay free of non-template functions and of calls into code
+ * that could be shared with the rest of the library.
+ */
+
+namespace pegasus
+{
+namespace collision
+{
+namespace kernel
+{
+
+/**
+ * @brief Row indices of the contact lanes buffer
+ *
+ * The buffer stores one row of lane width floats for each value.
+ */
+enum ContactLane : uint32_t
+{
+    NORMAL_X, NORMAL_Y, NORMAL_Z,
+    FIRST_TANGENT_X, FIRST_TANGENT_Y, FIRST_TANGENT_Z,
+    SECOND_TANGENT_X, SECOND_TANGENT_Y, SECOND_TANGENT_Z,
+    A_RELATIVE_POSITION_X, A_RELATIVE_POSITION_Y, A_RELATIVE_POSITION_Z,
+    B_RELATIVE_POSITION_X, B_RELATIVE_POSITION_Y, B_RELATIVE_POSITION_Z,
+    PENETRATION,
+    RESTITUTION_SPEED,
+    FRICTION,
+    LAGRANGIAN_MULTIPLIER,
+    TANGENT_LAGRANGIAN_MULTIPLIER_1,
+    TANGENT_LAGRANGIAN_MULTIPLIER_2,
+    A_LINEAR_VELOCITY_X, A_LINEAR_VELOCITY_Y, A_LINEAR_VELOCITY_Z,
+    A_ANGULAR_VELOCITY_X, A_ANGULAR_VELOCITY_Y, A_ANGULAR_VELOCITY_Z,
+    B_LINEAR_VELOCITY_X, B_LINEAR_VELOCITY_Y, B_LINEAR_VELOCITY_Z,
+    B_ANGULAR_VELOCITY_X, B_ANGULAR_VELOCITY_Y, B_ANGULAR_VELOCITY_Z,
+    A_INVERSE_MASS,
+    B_INVERSE_MASS,
+    A_INVERSE_INERTIA,
+    B_INVERSE_INERTIA = A_INVERSE_INERTIA + 6,
+    CONTACT_LANE_COUNT = B_INVERSE_INERTIA + 6
+};
+
+//!Maximum number of contacts solved at once
+uint32_t const MAX_CONTACT_LANE_WIDTH = 8;
+
+/**
+ * @brief Stores parameters shared by all lanes
+ */
+struct ContactLaneParameters
+{
+    float duration;
+    float impulseFactor;
+    float baumgarteFactor;
+    float threshold;
+};
+
+using simd::Vec3Pack;
+using simd::SymmetricMat3Pack;
+
+template < typename Pack >
+Pack LoadLane(float const* lanes, uint32_t row)
+{
+    return Pack::Load(lanes + row * Pack::WIDTH);
+}
+
+template < typename Pack >
+Vec3Pack<Pack> LoadLane3(float const* lanes, uint32_t row)
+{
+    return { LoadLane<Pack>(lanes, row), LoadLane<Pack>(lanes, row + 1), LoadLane<Pack>(lanes, row + 2) };
+}
+
+template < typename Pack >
+SymmetricMat3Pack<Pack> LoadLane6(float const* lanes, uint32_t row)
+{
+    return {
+        LoadLane<Pack>(lanes, row), LoadLane<Pack>(lanes, row + 1), LoadLane<Pack>(lanes, row + 2),
+        LoadLane<Pack>(lanes, row + 3), LoadLane<Pack>(lanes, row + 4), LoadLane<Pack>(lanes, row + 5),
+    };
+}
+
+template < typename Pack >
+void StoreLane3(float* lanes, uint32_t row, Vec3Pack<Pack> const& v)
+{
+    v.x.Store(lanes + row * Pack::WIDTH);
+    v.y.Store(lanes + (row + 1) * Pack::WIDTH);
+    v.z.Store(lanes + (row + 2) * Pack::WIDTH);
+}
+
+/**
+ * @brief Solves friction constraint along the tangent for all lanes
+ *
+ * @tparam Pack lane pack type
+ * @param[in]     t                          tangent
+ * @param[in]     rA                         contact points relative to the bodies A
+ * @param[in]     rB                         contact points relative to the bodies B
+ * @param[in]     V                          initial velocities
+ * @param[in]     inverseMassA               inverse masses of the bodies A
+ * @param[in]     inverseMassB               inverse masses of the bodies B
+ * @param[in]     inverseInertiaA            inverse inertia tensors of the bodies A
+ * @param[in]     inverseInertiaB            inverse inertia tensors of the bodies B
+ * @param[in]     frictionBound              maximum magnitude of the total multipliers
+ * @param[in,out] totalLagrangianMultiplier  total multipliers of the constraint
+ * @param[in,out] deltaVelocity              velocity changes of the bodies
+ */
+template < typename Pack >
+void SolveFrictionLanes(
+    Vec3Pack<Pack> const& t, Vec3Pack<Pack> const& rA, Vec3Pack<Pack> const& rB, Vec3Pack<Pack> const (&V)[4],
+    Pack const& inverseMassA, Pack const& inverseMassB,
+    SymmetricMat3Pack<Pack> const& inverseInertiaA, SymmetricMat3Pack<Pack> const& inverseInertiaB,
+    Pack const& frictionBound, Pack& totalLagrangianMultiplier, Vec3Pack<Pack> (&deltaVelocity)[4]
+)
+{
+    Pack const zero = Pack::Set(0.0f);
+    Vec3Pack<Pack> const twA = Cross(t, rA);
+    Vec3Pack<Pack> const twB = Cross(rB, t);
+    Vec3Pack<Pack> const inertiaTwA = inverseInertiaA * twA;
+    Vec3Pack<Pack> const inertiaTwB = inverseInertiaB * twB;
+
+    Pack const tangentLength2 = Dot(t, t);
+    Pack const divisor = inverseMassA * tangentLength2 + Dot(twA, inertiaTwA)
+        + inverseMassB * tangentLength2 + Dot(twB, inertiaTwB);
+    Pack const jv = Dot(t, V[2] - V[0]) + Dot(twA, V[1]) + Dot(twB, V[3]);
+
+    Pack lagrangianMultiplier = (zero - jv) / divisor;
+    lagrangianMultiplier = Select(IsNan(lagrangianMultiplier), zero, lagrangianMultiplier);
+    lagrangianMultiplier = Min(lagrangianMultiplier, Pack::Set(100.0f));
+
+    Pack const total = Max(Min(totalLagrangianMultiplier + lagrangianMultiplier, frictionBound), zero - frictionBound);
+    Pack const delta = total - totalLagrangianMultiplier;
+    totalLagrangianMultiplier = total;
+
+    deltaVelocity[0] = deltaVelocity[0] - t * (inverseMassA * delta);
+    deltaVelocity[1] = deltaVelocity[1] + inertiaTwA * delta;
+    deltaVelocity[2] = deltaVelocity[2] + t * (inverseMassB * delta);
+    deltaVelocity[3] = deltaVelocity[3] + inertiaTwB * delta;
+}
+
+/**
+ * @brief Solves contact and friction constraints of all lanes and applies velocity changes
+ *
+ * Mirrors SolveConstraints followed by ApplyDeltaVelocity for each lane.
+ * Tangents, total multipliers and body velocities are written back to the lanes buffer.
+ *
+ * @tparam Pack lane pack type
+ * @param[in,out] lanes      lanes buffer of CONTACT_LANE_COUNT rows
+ * @param[in]     parameters shared parameters
+ */
+template < typename Pack >
+void SolveContactLanes(float* lanes, ContactLaneParameters const& parameters)
+{
+    Pack const zero = Pack::Set(0.0f);
+    Pack const threshold = Pack::Set(parameters.threshold);
+
+    Vec3Pack<Pack> const n = LoadLane3<Pack>(lanes, NORMAL_X);
+    Vec3Pack<Pack> t1 = LoadLane3<Pack>(lanes, FIRST_TANGENT_X);
+    Vec3Pack<Pack> t2 = LoadLane3<Pack>(lanes, SECOND_TANGENT_X);
+    Vec3Pack<Pack> const rA = LoadLane3<Pack>(lanes, A_RELATIVE_POSITION_X);
+    Vec3Pack<Pack> const rB = LoadLane3<Pack>(lanes, B_RELATIVE_POSITION_X);
+    Vec3Pack<Pack> const V[4] = {
+        LoadLane3<Pack>(lanes, A_LINEAR_VELOCITY_X),
+        LoadLane3<Pack>(lanes, A_ANGULAR_VELOCITY_X),
+        LoadLane3<Pack>(lanes, B_LINEAR_VELOCITY_X),
+        LoadLane3<Pack>(lanes, B_ANGULAR_VELOCITY_X),
+    };
+    Pack const inverseMassA = LoadLane<Pack>(lanes, A_INVERSE_MASS);
+    Pack const inverseMassB = LoadLane<Pack>(lanes, B_INVERSE_MASS);
+    SymmetricMat3Pack<Pack> const inverseInertiaA = LoadLane6<Pack>(lanes, A_INVERSE_INERTIA);
+    SymmetricMat3Pack<Pack> const inverseInertiaB = LoadLane6<Pack>(lanes, B_INVERSE_INERTIA);
+
+    //Rotate friction tangents along the angular velocity of the body A
+    Pack const isRotating = CompareGreaterEqual(Dot(V[1], V[1]), threshold);
+    Vec3Pack<Pack> const velocityCrossNormal = Cross(V[1], n);
+    Pack const velocityCrossNormalLength2 = Dot(velocityCrossNormal, velocityCrossNormal);
+    t1 = Select(And(isRotating, CompareGreaterEqual(velocityCrossNormalLength2, threshold)),
+        velocityCrossNormal * (Pack::Set(1.0f) / Sqrt(velocityCrossNormalLength2)), t1);
+    Vec3Pack<Pack> const tangentCrossNormal = Cross(t1, n);
+    Pack const tangentCrossNormalLength2 = Dot(tangentCrossNormal, tangentCrossNormal);
+    t2 = Select(And(isRotating, CompareGreaterEqual(tangentCrossNormalLength2, threshold)),
+        tangentCrossNormal * (Pack::Set(1.0f) / Sqrt(tangentCrossNormalLength2)), t2);
+
+    //Contact constraint
+    Vec3Pack<Pack> const nwA = Cross(n, rA);
+    Vec3Pack<Pack> const nwB = Cross(rB, n);
+    Vec3Pack<Pack> const inertiaNwA = inverseInertiaA * nwA;
+    Vec3Pack<Pack> const inertiaNwB = inverseInertiaB * nwB;
+
+    Pack const restitution = LoadLane<Pack>(lanes, RESTITUTION_SPEED);
+    Pack const penetration = LoadLane<Pack>(lanes, PENETRATION);
+    Pack const baumgarteStabilizationTerm = Select(CompareGreaterEqual(penetration, zero),
+        Pack::Set(-parameters.baumgarteFactor / parameters.duration) * Max(penetration + Pack::Set(0.0125f), zero) - restitution,
+        (zero - penetration) / Pack::Set(parameters.duration));
+
+    Pack const normalLength2 = Dot(n, n);
+    Pack const divisor = inverseMassA * normalLength2 + Dot(nwA, inertiaNwA)
+        + inverseMassB * normalLength2 + Dot(nwB, inertiaNwB) + threshold;
+    Pack const jv = Dot(n, V[2] - V[0]) + Dot(nwA, V[1]) + Dot(nwB, V[3]);
+
+    Pack const previousTotal = LoadLane<Pack>(lanes, LAGRANGIAN_MULTIPLIER);
+    Pack const total = Max(zero, previousTotal + (zero - (jv + baumgarteStabilizationTerm)) / divisor);
+    Pack const delta = total - previousTotal;
+
+    Vec3Pack<Pack> deltaVelocity[4] = {
+        n * (zero - inverseMassA * delta),
+        inertiaNwA * delta,
+        n * (inverseMassB * delta),
+        inertiaNwB * delta,
+    };
+
+    //Friction constraints
+    Pack const frictionBound = total * LoadLane<Pack>(lanes, FRICTION);
+    Pack tangentTotal1 = LoadLane<Pack>(lanes, TANGENT_LAGRANGIAN_MULTIPLIER_1);
+    Pack tangentTotal2 = LoadLane<Pack>(lanes, TANGENT_LAGRANGIAN_MULTIPLIER_2);
+    SolveFrictionLanes(t1, rA, rB, V, inverseMassA, inverseMassB, inverseInertiaA, inverseInertiaB,
+        frictionBound, tangentTotal1, deltaVelocity);
+    SolveFrictionLanes(t2, rA, rB, V, inverseMassA, inverseMassB, inverseInertiaA, inverseInertiaB,
+        frictionBound, tangentTotal2, deltaVelocity);
+
+    //Write results back
+    Pack const impulseFactor = Pack::Set(parameters.impulseFactor);
+    StoreLane3(lanes, FIRST_TANGENT_X, t1);
+    StoreLane3(lanes, SECOND_TANGENT_X, t2);
+    total.Store(lanes + LAGRANGIAN_MULTIPLIER * Pack::WIDTH);
+    tangentTotal1.Store(lanes + TANGENT_LAGRANGIAN_MULTIPLIER_1 * Pack::WIDTH);
+    tangentTotal2.Store(lanes + TANGENT_LAGRANGIAN_MULTIPLIER_2 * Pack::WIDTH);
+    StoreLane3(lanes, A_LINEAR_VELOCITY_X, V[0] + deltaVelocity[0] * impulseFactor);
+    StoreLane3(lanes, A_ANGULAR_VELOCITY_X, V[1] + deltaVelocity[1] * impulseFactor);
+    StoreLane3(lanes, B_LINEAR_VELOCITY_X, V[2] + deltaVelocity[2] * impulseFactor);
+    StoreLane3(lanes, B_ANGULAR_VELOCITY_X, V[3] + deltaVelocity[3] * impulseFactor);
+}
+
+/**
+ * @brief Returns true if the library contains the AVX2 kernel
+ */
+bool HasAvx2ContactKernel();
+
+/**
+ * @brief Solves eight contact lanes using AVX2 instructions
+ * @param[in,out] lanes      lanes buffer of CONTACT_LANE_COUNT rows of width 8
+ * @param[in]     parameters shared parameters
+ */
+void SolveContactLanesAvx2(float* lanes, ContactLaneParameters const& parameters);
+
+} // namespace kernel
+} // namespace collision
+} // namespace pegasus
+#endif // PEGASUS_CONTACT_KERNEL_HPP
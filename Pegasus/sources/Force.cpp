@@ -145,5 +145,17 @@ glm::vec3 Buoyancy::CalculateForce(mechanics::Body const& body) const
 
     return force;
 }
+
+glm::vec3 GlobalField::CalculateForce(mechanics::Body const& body) const
+{
+    glm::vec3 const velocity = body.linearMotion.velocity - flowVelocity;
+    return acceleration * body.material.GetMass() - velocity * (linearDrag + quadraticDrag * glm::length(velocity));
+}
+
+glm::vec3 GlobalField::CalculateTorque(mechanics::Body const& body) const
+{
+    glm::vec3 const& velocity = body.angularMotion.velocity;
+    return -velocity * (linearDrag + quadraticDrag * glm::length(velocity));
+}
 } // namespace force
 } // namespace pegasus
@@ -4,222 +4,293 @@
 * (http://opensource.org/licenses/MIT)
 */
 #include <pegasus/Integration.hpp>
+#include "IntegrationKernel.hpp"
 #include <Epona/FloatingPoint.hpp>
-#include <glm/gtx/quaternion.hpp>
+#include <cassert>
+#include <cmath>
+
+static_assert(pegasus::integration::BODY_MOTION_LANE_COUNT == pegasus::integration::kernel::MOTION_LANE_COUNT,
+    "Public body motion row count must follow the kernel rows");
+static_assert(pegasus::integration::BODY_MOTIONS_TILE_SIZE % pegasus::integration::kernel::MAX_MOTION_LANE_WIDTH == 0,
+    "Tile sized buffers must be padded to the widest instruction set");
 
 namespace
 {
 
-/**
-* @brief Calculates position of the body
-* @param position current position
-* @param velocity current velocity
-* @param duration delta time
-* @return new position
-*/
-inline glm::vec3 IntegrateLinearPosition(glm::vec3 position, glm::vec3 velocity, float duration)
-{
-    return position + velocity * duration;
-}
+//!Upper bound of the linear and angular speeds
+float const MAX_SPEED = 100.0f;
 
 /**
-* @brief Calculates acceleration of the body
-* @param acceleration currant acceleration
-* @param force total force acting on the body
-* @param inverseMass one divided by mass
-* @return new acceleration
-*/
-inline glm::vec3 IntegrateLinearAcceleration(glm::vec3 acceleration, glm::vec3 force, float inverseMass)
+ * @brief Copies motion state of the body into its buffer column
+ * @param[out] lanes         first value of the body column
+ * @param[in]  stride        distance between the buffer rows
+ * @param[in]  body          body data
+ * @param[in]  positionForce force that moves the body
+ */
+void LoadMotionLanes(
+    float* lanes, uint32_t stride, pegasus::mechanics::Body const& body, glm::vec3 const& positionForce
+)
 {
-    return acceleration + force * inverseMass;
-}
+    using namespace pegasus::integration::kernel;
 
-/**
-* @brief Calculates velocity of the body
-* @param velocity current velocity
-* @param acceleration current acceleration
-* @param duration delta time
-* @return new velocity
-*/
-inline glm::vec3 IntegrateLinearVelocity(glm::vec3 velocity, glm::vec3 acceleration, float duration)
-{
-    return velocity + acceleration * duration;
+    auto const set = [lanes, stride](uint32_t row, float value) {
+        lanes[row * stride] = value;
+    };
+    auto const set3 = [&set](uint32_t row, glm::vec3 const& value) {
+        set(row, value.x);
+        set(row + 1, value.y);
+        set(row + 2, value.z);
+    };
+    auto const set6 = [&set](uint32_t row, pegasus::mechanics::SymmetricMatrix3 const& value) {
+        set(row, value.xx);
+        set(row + 1, value.xy);
+        set(row + 2, value.xz);
+        set(row + 3, value.yy);
+        set(row + 4, value.yz);
+        set(row + 5, value.zz);
+    };
+
+    set3(POSITION_X, body.linearMotion.position);
+    set3(LINEAR_VELOCITY_X, body.linearMotion.velocity);
+    set3(LINEAR_ACCELERATION_X, body.linearMotion.acceleration);
+    set3(FORCE_X, body.linearMotion.force);
+    set3(POSITION_FORCE_X, positionForce);
+    set(ORIENTATION_X, body.angularMotion.orientation.x);
+    set(ORIENTATION_Y, body.angularMotion.orientation.y);
+    set(ORIENTATION_Z, body.angularMotion.orientation.z);
+    set(ORIENTATION_W, body.angularMotion.orientation.w);
+    set3(ANGULAR_VELOCITY_X, body.angularMotion.velocity);
+    set3(ANGULAR_ACCELERATION_X, body.angularMotion.acceleration);
+    set3(TORQUE_X, body.angularMotion.torque);
+    set(INVERSE_MASS, body.material.GetInverseMass());
+    set(DAMPING_FACTOR, body.material.damping);
+    set6(BODY_INVERSE_INERTIA, pegasus::mechanics::SymmetricMatrix3(body.material.GetInverseMomentOfInertia()));
+    set6(INVERSE_INERTIA, body.inverseInertia);
 }
 
 /**
-* @brief Calculates damping velocity decrease
-* @param velocity current velocity
-* @param damping damping factor
-* @param duration delta time
-* @param minApplySpeed minimum speed required to apply damping
-* @return new velocity
-*/
-inline glm::vec3 IntegrateLinearDamping(glm::vec3 velocity, float damping, float duration, float minApplySpeed = 1.f)
+ * @brief Copies integrated motion state from the body buffer column
+ * @param[in]     lanes  first value of the body column
+ * @param[in]     stride distance between the buffer rows
+ * @param[in,out] body   body data
+ */
+void StoreMotionLanes(float const* lanes, uint32_t stride, pegasus::mechanics::Body& body)
 {
-    return (glm::length2(velocity) > minApplySpeed) ? (velocity * glm::pow(damping, duration)) : velocity;
+    using namespace pegasus::integration::kernel;
+
+    auto const get = [lanes, stride](uint32_t row) {
+        return lanes[row * stride];
+    };
+    auto const get3 = [&get](uint32_t row) {
+        return glm::vec3(get(row), get(row + 1), get(row + 2));
+    };
+
+    body.linearMotion.position = get3(POSITION_X);
+    body.linearMotion.velocity = get3(LINEAR_VELOCITY_X);
+    body.linearMotion.force = glm::vec3(0);
+    body.angularMotion.orientation = glm::quat(
+        get(ORIENTATION_W), get(ORIENTATION_X), get(ORIENTATION_Y), get(ORIENTATION_Z)
+    );
+    body.angularMotion.velocity = get3(ANGULAR_VELOCITY_X);
+    body.angularMotion.torque = glm::vec3(0);
+
+    pegasus::mechanics::SymmetricMatrix3& inverseInertia = body.inverseInertia;
+    inverseInertia.xx = get(INVERSE_INERTIA);
+    inverseInertia.xy = get(INVERSE_INERTIA + 1);
+    inverseInertia.xz = get(INVERSE_INERTIA + 2);
+    inverseInertia.yy = get(INVERSE_INERTIA + 3);
+    inverseInertia.yz = get(INVERSE_INERTIA + 4);
+    inverseInertia.zz = get(INVERSE_INERTIA + 5);
+
+    assert(!std::isinf(body.linearMotion.position.x)
+        && !std::isinf(body.linearMotion.position.y)
+        && !std::isinf(body.linearMotion.position.z));
+    assert(!std::isinf(body.angularMotion.orientation.x)
+        && !std::isinf(body.angularMotion.orientation.y)
+        && !std::isinf(body.angularMotion.orientation.z)
+        && !std::isinf(body.angularMotion.orientation.w));
 }
 
 /**
-* @brief Updates body position
-* @param[in,out] material body material data
-* @param[in,out] linearMotion body linear motion data
-* @param[in] duration delta time
-* @param[in] maxSpeed upper speed bound
-*/
-void IntegrateBody(
-        pegasus::mechanics::Material& material,
-        pegasus::mechanics::Body::LinearMotion& linearMotion,
-        float duration,
-        float maxSpeed = 100
-    )
+ * @brief Replaces damping coefficients with the factors applied over the duration
+ *
+ * Bodies usually share a few materials, so the last factor is reused while the coefficient repeats.
+ *
+ * @param[in,out] damping  damping row of the buffer
+ * @param[in]     count    number of bodies
+ * @param[in]     duration delta time
+ */
+void CalculateDampingFactors(float* damping, uint32_t count, float duration)
 {
+    float coefficient = 1.0f;
+    float factor = 1.0f;
+    for (uint32_t i = 0; i < count; ++i)
     {
-        float const speed = glm::length(linearMotion.velocity);
-        if (epona::fp::IsGreater(speed, maxSpeed))
+        if (damping[i] != coefficient)
         {
-            float const minSpeed = glm::min(speed, maxSpeed);
-            glm::vec3 const direction = glm::normalize(linearMotion.velocity);
-            linearMotion.velocity = direction * minSpeed;
+            coefficient = damping[i];
+            factor = glm::pow(coefficient, duration);
         }
+        damping[i] = factor;
     }
+}
+
+/**
+ * @brief Integrates motion of the bodies stored in the buffer with the step policy
+ * @tparam Step step policy type
+ * @param[in,out] lanes          body motions buffer
+ * @param[in]     stride         distance between the buffer rows
+ * @param[in]     count          number of bodies
+ * @param[in]     parameters     shared parameters
+ * @param[in]     instructionSet instruction set, must be supported by the CPU
+ */
+template < typename Step >
+void IntegrateBodies(
+    float* lanes, uint32_t stride, uint32_t count,
+    pegasus::integration::kernel::MotionLaneParameters const& parameters,
+    pegasus::collision::SimdInstructionSet instructionSet
+)
+{
+    using namespace pegasus::integration::kernel;
+    using pegasus::collision::SimdInstructionSet;
 
-    glm::vec3 const resultingAcceleration = ::IntegrateLinearAcceleration(
-        linearMotion.acceleration, linearMotion.force, material.GetInverseMass());
-    linearMotion.position = ::IntegrateLinearPosition(linearMotion.position, linearMotion.velocity, duration);
-    linearMotion.velocity = ::IntegrateLinearDamping(
-        ::IntegrateLinearVelocity(linearMotion.velocity, resultingAcceleration, duration),
-        material.damping, duration);
-    linearMotion.force = glm::vec3(0);
+    uint32_t integrated = 0;
 
+#ifdef PEGASUS_SIMD_X86_64
+    if (instructionSet == SimdInstructionSet::AVX2)
+    {
+        integrated += IntegrateMotionLanesAvx2<Step>(lanes, stride, count, parameters);
+    }
+    if (instructionSet != SimdInstructionSet::NONE)
     {
-        if (epona::fp::IsZero(linearMotion.velocity.x))
-            linearMotion.velocity.x = 0;
-        if (epona::fp::IsZero(linearMotion.velocity.y))
-            linearMotion.velocity.y = 0;
-        if (epona::fp::IsZero(linearMotion.velocity.z))
-            linearMotion.velocity.z = 0;
+        integrated += IntegrateMotionLanes<pegasus::simd::SsePack, Step>(
+            lanes + integrated, stride, count - integrated, parameters
+        );
     }
+#else
+    (void)instructionSet;
+#endif
 
-    assert(!std::isinf(linearMotion.position.x)
-        && !std::isinf(linearMotion.position.y)
-        && !std::isinf(linearMotion.position.z));
-    assert(!std::isinf(linearMotion.velocity.x)
-        && !std::isinf(linearMotion.velocity.y)
-        && !std::isinf(linearMotion.velocity.z));
+    IntegrateMotionLanes<pegasus::simd::ScalarPack, Step>(lanes + integrated, stride, count - integrated, parameters);
 }
 
 /**
- * @brief Calculates angular acceleration of the body
- * @param acceleration angular acceleration
- * @param torque torque applied
- * @param inverseMomentOfInertia inverse moment of inertia
- * @return angular acceleration
+ * @brief Integrates motion of the bodies stored in the buffer
+ * @param[in,out] lanes          body motions buffer
+ * @param[in]     stride         distance between the buffer rows
+ * @param[in]     count          number of bodies
+ * @param[in]     duration       delta time
+ * @param[in]     integrator       integrator scheme
+ * @param[in]     gyroscopicTorque true to apply gyroscopic torque implicitly
+ * @param[in]     instructionSet   instruction set, must be supported by the CPU
  */
-inline glm::vec3 IntegrateAngularAcceleration(glm::vec3 acceleration, glm::vec3 torque, glm::mat3 inverseMomentOfInertia)
+void IntegrateBodies(
+    float* lanes, uint32_t stride, uint32_t count, float duration, pegasus::integration::Integrator integrator,
+    bool gyroscopicTorque, pegasus::collision::SimdInstructionSet instructionSet
+)
 {
-    return acceleration + inverseMomentOfInertia * torque;
+    using namespace pegasus::integration::kernel;
+    using pegasus::integration::Integrator;
+
+    CalculateDampingFactors(lanes + DAMPING_FACTOR * stride, count, duration);
+
+    MotionLaneParameters const parameters{
+        duration, MAX_SPEED, epona::fp::g_floatingPointThreshold, gyroscopicTorque
+    };
+    switch (integrator)
+    {
+        case Integrator::EXPLICIT_EULER:
+            IntegrateBodies<ExplicitEulerStep>(lanes, stride, count, parameters, instructionSet);
+            break;
+        case Integrator::SEMI_IMPLICIT_EULER:
+            IntegrateBodies<SemiImplicitEulerStep>(lanes, stride, count, parameters, instructionSet);
+            break;
+        case Integrator::VELOCITY_VERLET:
+        case Integrator::RUNGE_KUTTA_4:
+            IntegrateBodies<SecondOrderStep>(lanes, stride, count, parameters, instructionSet);
+            break;
+    }
 }
 
-/**
- * @brief Calculates angular displacement of the body
- * @param orientation body orientation quatrenion
- * @param velocity angular velocity
- * @param duration delta time
- * @return angular displacement
- */
-inline glm::quat IntegrateAngularDisplacement(glm::quat orientation, glm::vec3 velocity, float duration)
+} // namespace ::
+
+namespace pegasus
+{
+namespace integration
 {
-    glm::quat const velocityQuad{ 0, velocity.x, velocity.y, velocity.z };
-    glm::quat const displacement{ glm::normalize(orientation + duration * velocityQuad * 0.5f * orientation) };
 
-    return displacement;
+void ResizeBodyMotions(BodyMotions& motions, uint32_t count)
+{
+    uint32_t const width = kernel::MAX_MOTION_LANE_WIDTH;
+    motions.count = count;
+    motions.stride = (count + width - 1) / width * width;
+    motions.lanes.resize(kernel::MOTION_LANE_COUNT * motions.stride);
 }
 
-/**
- * @brief Calculates angular velocity of the body
- * @param velocity angular velocity
- * @param resultingAcceleration total acceleration change
- * @param duration delta time
- * @return angular velocity
- */
-inline glm::vec3 IntegrateAngularVelocity(glm::vec3 velocity, glm::vec3 resultingAcceleration, float duration)
+void LoadBodyMotion(BodyMotions& motions, uint32_t index, mechanics::Body const& body)
 {
-    return velocity + resultingAcceleration * duration;
+    ::LoadMotionLanes(motions.lanes.data() + index, motions.stride, body, body.linearMotion.force);
 }
 
-/**
- * @brief Calculates angular damping velocity decrease
- * @param velocity angular velocity
- * @param damping damping factor
- * @param duration delta time
- * @param minApplySpeed minimum speed required to apply damping
- * @return angular velocity
- */
-inline glm::vec3 IntegrateAngularDamping(glm::vec3 velocity, float damping, float duration, float minApplySpeed = 1.f)
+void LoadBodyMotion(BodyMotions& motions, uint32_t index, mechanics::Body const& body, glm::vec3 const& positionForce)
 {
-    return (glm::length2(velocity) > minApplySpeed) ? (velocity * glm::pow(damping, duration)) : velocity;
+    ::LoadMotionLanes(motions.lanes.data() + index, motions.stride, body, positionForce);
 }
 
-/**
- * @brief Updates body displacement
- * @param[in, out] material body material data
- * @param[in, out] angularMotion body angular motion data
- * @param[in] duration delta time
- * @param[in] maxSpeed upper speed bound
- */
-void IntegrateBody(
-        pegasus::mechanics::Material& material,
-        pegasus::mechanics::Body::AngularMotion& angularMotion,
-        float duration,
-        float maxSpeed = 100
-    )
+void LoadBodyMotion(
+    float* lanes, uint32_t stride, uint32_t index, mechanics::Body const& body, glm::vec3 const& positionForce
+)
 {
-    {
-        float const speed = glm::length(angularMotion.velocity);
-        if (epona::fp::IsGreater(speed, maxSpeed))
-        {
-            float const minSpeed = glm::min(speed, maxSpeed);
-            glm::vec3 const direction = glm::normalize(angularMotion.velocity);
-            angularMotion.velocity = direction * minSpeed;
-        }
-    }
+    ::LoadMotionLanes(lanes + index, stride, body, positionForce);
+}
 
-    glm::vec3 const resultingAcceleration = ::IntegrateAngularAcceleration(
-        angularMotion.acceleration, angularMotion.torque, material.GetInverseMomentOfInertia());
-    angularMotion.orientation = ::IntegrateAngularDisplacement(angularMotion.orientation, angularMotion.velocity, duration);
-    angularMotion.velocity = ::IntegrateAngularDamping(
-        ::IntegrateAngularVelocity(angularMotion.velocity, resultingAcceleration, duration),
-        material.damping, duration);
-    angularMotion.torque = glm::vec3(0, 0, 0);
+void StoreBodyMotion(BodyMotions const& motions, uint32_t index, mechanics::Body& body)
+{
+    ::StoreMotionLanes(motions.lanes.data() + index, motions.stride, body);
+}
 
-    {
-        if (epona::fp::IsZero(angularMotion.velocity.x))
-            angularMotion.velocity.x = 0;
-        if (epona::fp::IsZero(angularMotion.velocity.y))
-            angularMotion.velocity.y = 0;
-        if (epona::fp::IsZero(angularMotion.velocity.z))
-            angularMotion.velocity.z = 0;
-    }
+void StoreBodyMotion(float const* lanes, uint32_t stride, uint32_t index, mechanics::Body& body)
+{
+    ::StoreMotionLanes(lanes + index, stride, body);
+}
 
-    assert(!std::isinf(angularMotion.orientation.x)
-        && !std::isinf(angularMotion.orientation.y)
-        && !std::isinf(angularMotion.orientation.z)
-        && !std::isinf(angularMotion.orientation.w));
-    assert(!std::isinf(angularMotion.velocity.x)
-        && !std::isinf(angularMotion.velocity.y)
-        && !std::isinf(angularMotion.velocity.z));
+void Integrate(
+    BodyMotions& motions, float duration, Integrator integrator, bool gyroscopicTorque,
+    collision::SimdInstructionSet instructionSet
+)
+{
+    ::IntegrateBodies(
+        motions.lanes.data(), motions.stride, motions.count, duration, integrator, gyroscopicTorque, instructionSet
+    );
 }
-} // namespace ::
 
-namespace pegasus
+void Integrate(
+    float* lanes, uint32_t stride, uint32_t count, float duration, Integrator integrator, bool gyroscopicTorque,
+    collision::SimdInstructionSet instructionSet
+)
 {
-namespace integration
+    assert(stride % kernel::MAX_MOTION_LANE_WIDTH == 0);
+    ::IntegrateBodies(lanes, stride, count, duration, integrator, gyroscopicTorque, instructionSet);
+}
+
+void IntegrateKinematic(mechanics::Body& body, float duration)
 {
+    body.linearMotion.position += body.linearMotion.velocity * duration;
+
+    glm::vec3 const& velocity = body.angularMotion.velocity;
+    glm::quat& orientation = body.angularMotion.orientation;
+    orientation = glm::normalize(orientation + duration * glm::quat(0, velocity.x, velocity.y, velocity.z) * 0.5f * orientation);
+    mechanics::UpdateInverseInertia(body);
+}
 
 void Integrate(mechanics::Body& body, float duration)
 {
-    ::IntegrateBody(body.material, body.linearMotion, duration);
-    ::IntegrateBody(body.material, body.angularMotion, duration);
+    float lanes[kernel::MOTION_LANE_COUNT];
+    ::LoadMotionLanes(lanes, 1, body, body.linearMotion.force);
+    ::IntegrateBodies(
+        lanes, 1, 1, duration, Integrator::EXPLICIT_EULER, false, collision::SimdInstructionSet::NONE
+    );
+    ::StoreMotionLanes(lanes, 1, body);
 }
 
 } // namespace integration
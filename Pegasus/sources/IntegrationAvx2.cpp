@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#include "IntegrationKernel.hpp"
+
+#if defined(PEGASUS_SIMD_X86_64) && defined(__AVX2__)
+
+namespace pegasus
+{
+namespace integration
+{
+namespace kernel
+{
+
+bool HasAvx2IntegrationKernel()
+{
+    return true;
+}
+
+template < typename Step >
+uint32_t IntegrateMotionLanesAvx2(float* lanes, uint32_t stride, uint32_t count, MotionLaneParameters const& parameters)
+{
+    return IntegrateMotionLanes<simd::Avx2Pack, Step>(lanes, stride, count, parameters);
+}
+
+template uint32_t IntegrateMotionLanesAvx2<ExplicitEulerStep>(float*, uint32_t, uint32_t, MotionLaneParameters const&);
+template uint32_t IntegrateMotionLanesAvx2<SemiImplicitEulerStep>(float*, uint32_t, uint32_t, MotionLaneParameters const&);
+template uint32_t IntegrateMotionLanesAvx2<SecondOrderStep>(float*, uint32_t, uint32_t, MotionLaneParameters const&);
+
+} // namespace kernel
+} // namespace integration
+} // namespace pegasus
+
+#else
+
+namespace pegasus
+{
+namespace integration
+{
+namespace kernel
+{
+
+bool HasAvx2IntegrationKernel()
+{
+    return false;
+}
+
+template < typename Step >
+uint32_t IntegrateMotionLanesAvx2(float*, uint32_t, uint32_t, MotionLaneParameters const&)
+{
+    return 0;
+}
+
+template uint32_t IntegrateMotionLanesAvx2<ExplicitEulerStep>(float*, uint32_t, uint32_t, MotionLaneParameters const&);
+template uint32_t IntegrateMotionLanesAvx2<SemiImplicitEulerStep>(float*, uint32_t, uint32_t, MotionLaneParameters const&);
+template uint32_t IntegrateMotionLanesAvx2<SecondOrderStep>(float*, uint32_t, uint32_t, MotionLaneParameters const&);
+
+} // namespace kernel
+} // namespace integration
+} // namespace pegasus
+
+#endif
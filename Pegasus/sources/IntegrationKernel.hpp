@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_INTEGRATION_KERNEL_HPP
+#define PEGASUS_INTEGRATION_KERNEL_HPP
+
+#include "SimdPack.hpp"
+#include <cstdint>
+
+/*
+ * The kernel is compiled with different instruction sets in different translation
+ * units, so it must stay free of non-template functions and of calls into code
+ * that could be shared with the rest of the library.
+ */
+
+namespace pegasus
+{
+namespace integration
+{
+namespace kernel
+{
+
+/**
+ * @brief Row indices of the body motions buffer
+ *
+ * The buffer stores one row of stride floats for each value.
+ */
+enum MotionLane : uint32_t
+{
+    POSITION_X, POSITION_Y, POSITION_Z,
+    LINEAR_VELOCITY_X, LINEAR_VELOCITY_Y, LINEAR_VELOCITY_Z,
+    LINEAR_ACCELERATION_X, LINEAR_ACCELERATION_Y, LINEAR_ACCELERATION_Z,
+    FORCE_X, FORCE_Y, FORCE_Z,
+    POSITION_FORCE_X, POSITION_FORCE_Y, POSITION_FORCE_Z,
+    ORIENTATION_X, ORIENTATION_Y, ORIENTATION_Z, ORIENTATION_W,
+    ANGULAR_VELOCITY_X, ANGULAR_VELOCITY_Y, ANGULAR_VELOCITY_Z,
+    ANGULAR_ACCELERATION_X, ANGULAR_ACCELERATION_Y, ANGULAR_ACCELERATION_Z,
+    TORQUE_X, TORQUE_Y, TORQUE_Z,
+    INVERSE_MASS,
+    DAMPING_FACTOR,
+    BODY_INVERSE_INERTIA,
+    INVERSE_INERTIA = BODY_INVERSE_INERTIA + 6,
+    MOTION_LANE_COUNT = INVERSE_INERTIA + 6
+};
+
+//!Maximum number of bodies integrated at once
+uint32_t const MAX_MOTION_LANE_WIDTH = 8;
+
+/**
+ * @brief Stores parameters shared by all lanes
+ */
+struct MotionLaneParameters
+{
+    float duration;
+    float maxSpeed;
+    float threshold;
+    bool gyroscopicTorque;
+};
+
+/**
+ * @brief Limits the length of the velocities
+ * @tparam Pack lane pack type
+ * @param velocity   velocities
+ * @param maxSpeed   upper speed bound
+ * @param threshold  floating point threshold
+ * @return clamped velocities
+ */
+template < typename Pack >
+simd::Vec3Pack<Pack> ClampSpeed(simd::Vec3Pack<Pack> const& velocity, Pack const& maxSpeed, Pack const& threshold)
+{
+    Pack const speed = Sqrt(Dot(velocity, velocity));
+    Pack const isFast = CompareGreater(speed - maxSpeed, threshold);
+    return Select(isFast, velocity * (maxSpeed / Max(speed, threshold)), velocity);
+}
+
+/**
+ * @brief Applies damping to the velocities faster than one and snaps small components to zero
+ * @tparam Pack lane pack type
+ * @param velocity      velocities
+ * @param dampingFactor damping factors raised to the power of the delta time
+ * @param threshold     floating point threshold
+ * @return damped velocities
+ */
+template < typename Pack >
+simd::Vec3Pack<Pack> DampVelocity(simd::Vec3Pack<Pack> const& velocity, Pack const& dampingFactor, Pack const& threshold)
+{
+    Pack const zero = Pack::Set(0.0f);
+    simd::Vec3Pack<Pack> const damped = Select(
+        CompareGreater(Dot(velocity, velocity), Pack::Set(1.0f)), velocity * dampingFactor, velocity
+    );
+
+    auto const snap = [&zero, &threshold](Pack const& value) {
+        return Select(CompareGreaterEqual(Max(value, zero - value), threshold), value, zero);
+    };
+    return { snap(damped.x), snap(damped.y), snap(damped.z) };
+}
+
+/**
+ * @brief Applies gyroscopic torque to the angular velocities with one implicit Newton step
+ *
+ * Solves (I + h * ([w] * I - [I * w])) * dw = -h * w x (I * w) with the world space inertia,
+ * which keeps fast spinning elongated bodies stable at large steps. Lanes with singular
+ * inverse inertia keep their velocities.
+ *
+ * @tparam Pack lane pack type
+ * @param velocity       angular velocities
+ * @param inverseInertia world space inverse inertia
+ * @param duration       delta time
+ * @return corrected angular velocities
+ */
+template < typename Pack >
+simd::Vec3Pack<Pack> ApplyGyroscopicTorque(
+    simd::Vec3Pack<Pack> const& velocity, simd::SymmetricMat3Pack<Pack> const& inverseInertia, Pack const& duration
+)
+{
+    using simd::Vec3Pack;
+
+    Pack const zero = Pack::Set(0.0f);
+    Pack const one = Pack::Set(1.0f);
+    simd::SymmetricMat3Pack<Pack> const& m = inverseInertia;
+
+    //Inertia is the adjugate of the inverse over its determinant
+    Pack const adjugateXX = m.yy * m.zz - m.yz * m.yz;
+    Pack const adjugateXY = m.xz * m.yz - m.xy * m.zz;
+    Pack const adjugateXZ = m.xy * m.yz - m.xz * m.yy;
+    Pack const inverseDeterminant = m.xx * adjugateXX + m.xy * adjugateXY + m.xz * adjugateXZ;
+    Pack const isInvertible = CompareGreater(inverseDeterminant, zero);
+    Pack const scale = one / Select(isInvertible, inverseDeterminant, one);
+
+    Vec3Pack<Pack> const column0{ adjugateXX * scale, adjugateXY * scale, adjugateXZ * scale };
+    Vec3Pack<Pack> const column1{
+        column0.y, (m.xx * m.zz - m.xz * m.xz) * scale, (m.xy * m.xz - m.xx * m.yz) * scale
+    };
+    Vec3Pack<Pack> const column2{ column0.z, column1.z, (m.xx * m.yy - m.xy * m.xy) * scale };
+
+    Vec3Pack<Pack> const momentum = column0 * velocity.x + column1 * velocity.y + column2 * velocity.z;
+    Vec3Pack<Pack> const residual = Cross(velocity, momentum) * duration;
+
+    //Columns of the Jacobian, [I * w] * e is subtracted from each
+    Vec3Pack<Pack> const jacobian0 = column0
+        + (Cross(velocity, column0) - Vec3Pack<Pack>{ zero, momentum.z, zero - momentum.y }) * duration;
+    Vec3Pack<Pack> const jacobian1 = column1
+        + (Cross(velocity, column1) - Vec3Pack<Pack>{ zero - momentum.z, zero, momentum.x }) * duration;
+    Vec3Pack<Pack> const jacobian2 = column2
+        + (Cross(velocity, column2) - Vec3Pack<Pack>{ momentum.y, zero - momentum.x, zero }) * duration;
+
+    //Cramer's rule with the columns
+    Vec3Pack<Pack> const cross12 = Cross(jacobian1, jacobian2);
+    Pack const determinant = Dot(jacobian0, cross12);
+    Pack const isSolvable = And(isInvertible, CompareGreater(Max(determinant, zero - determinant), zero));
+    Pack const inverseDeterminantJ = one / Select(isSolvable, determinant, one);
+    Vec3Pack<Pack> const delta{
+        Dot(residual, cross12) * inverseDeterminantJ,
+        Dot(residual, Cross(jacobian2, jacobian0)) * inverseDeterminantJ,
+        Dot(residual, Cross(jacobian0, jacobian1)) * inverseDeterminantJ
+    };
+
+    return Select(isSolvable, velocity - delta, velocity);
+}
+
+/**
+ * @brief Moves bodies with the velocity they had before the step
+ */
+struct ExplicitEulerStep
+{
+    /**
+     * @brief Calculates new positions
+     * @tparam Pack lane pack type
+     * @param position             positions
+     * @param velocity             velocities before the step
+     * @param newVelocity          velocities after the step
+     * @param positionAcceleration accelerations that move the bodies
+     * @param duration             delta time
+     * @return new positions
+     */
+    template < typename Pack >
+    static simd::Vec3Pack<Pack> Move(
+        simd::Vec3Pack<Pack> const& position, simd::Vec3Pack<Pack> const& velocity,
+        simd::Vec3Pack<Pack> const&, simd::Vec3Pack<Pack> const&, Pack const& duration
+    )
+    {
+        return position + velocity * duration;
+    }
+
+    /**
+     * @brief Selects angular velocities that rotate the bodies
+     * @tparam Pack lane pack type
+     * @param velocity    velocities before the step
+     * @param newVelocity velocities after the step
+     * @return rotating velocities
+     */
+    template < typename Pack >
+    static simd::Vec3Pack<Pack> Spin(simd::Vec3Pack<Pack> const& velocity, simd::Vec3Pack<Pack> const&)
+    {
+        return velocity;
+    }
+};
+
+/**
+ * @brief Moves bodies with the velocity updated by the step
+ */
+struct SemiImplicitEulerStep
+{
+    //!@copydoc ExplicitEulerStep::Move
+    template < typename Pack >
+    static simd::Vec3Pack<Pack> Move(
+        simd::Vec3Pack<Pack> const& position, simd::Vec3Pack<Pack> const&,
+        simd::Vec3Pack<Pack> const& newVelocity, simd::Vec3Pack<Pack> const&, Pack const& duration
+    )
+    {
+        return position + newVelocity * duration;
+    }
+
+    //!@copydoc ExplicitEulerStep::Spin
+    template < typename Pack >
+    static simd::Vec3Pack<Pack> Spin(simd::Vec3Pack<Pack> const&, simd::Vec3Pack<Pack> const& newVelocity)
+    {
+        return newVelocity;
+    }
+};
+
+/**
+ * @brief Moves bodies along the parabola of the position acceleration, used by the multi-stage integrators
+ */
+struct SecondOrderStep
+{
+    //!@copydoc ExplicitEulerStep::Move
+    template < typename Pack >
+    static simd::Vec3Pack<Pack> Move(
+        simd::Vec3Pack<Pack> const& position, simd::Vec3Pack<Pack> const& velocity,
+        simd::Vec3Pack<Pack> const&, simd::Vec3Pack<Pack> const& positionAcceleration, Pack const& duration
+    )
+    {
+        return position + (velocity + positionAcceleration * (duration * Pack::Set(0.5f))) * duration;
+    }
+
+    //!@copydoc ExplicitEulerStep::Spin
+    template < typename Pack >
+    static simd::Vec3Pack<Pack> Spin(simd::Vec3Pack<Pack> const& velocity, simd::Vec3Pack<Pack> const& newVelocity)
+    {
+        return (velocity + newVelocity) * Pack::Set(0.5f);
+    }
+};
+
+/**
+ * @brief Integrates motion of the bodies in groups of the pack width
+ *
+ * Linear and angular velocities are clamped and updated with the accelerations, forces
+ * and damping, the step policy selects the velocities that move and rotate the bodies.
+ * Gyroscopic torque is applied to the clamped angular velocities when enabled.
+ * World space inverse inertia is rotated into the new orientation.
+ *
+ * @tparam Pack lane pack type
+ * @tparam Step step policy type
+ * @param[in,out] lanes      body motions buffer
+ * @param[in]     stride     distance between the buffer rows
+ * @param[in]     count      number of bodies
+ * @param[in]     parameters shared parameters
+ * @return number of integrated bodies, a multiple of the pack width
+ */
+template < typename Pack, typename Step >
+uint32_t IntegrateMotionLanes(float* lanes, uint32_t stride, uint32_t count, MotionLaneParameters const& parameters)
+{
+    using simd::Vec3Pack;
+    using simd::SymmetricMat3Pack;
+
+    Pack const zero = Pack::Set(0.0f);
+    Pack const one = Pack::Set(1.0f);
+    Pack const duration = Pack::Set(parameters.duration);
+    Pack const halfDuration = Pack::Set(parameters.duration * 0.5f);
+    Pack const maxSpeed = Pack::Set(parameters.maxSpeed);
+    Pack const threshold = Pack::Set(parameters.threshold);
+    bool const gyroscopicTorque = parameters.gyroscopicTorque;
+
+    uint32_t integrated = 0;
+    for (; integrated + Pack::WIDTH <= count; integrated += Pack::WIDTH)
+    {
+        float* const lane = lanes + integrated;
+        auto const load = [lane, stride](uint32_t row) {
+            return Pack::LoadUnaligned(lane + row * stride);
+        };
+        auto const load3 = [&load](uint32_t row) {
+            return Vec3Pack<Pack>{ load(row), load(row + 1), load(row + 2) };
+        };
+        auto const load6 = [&load](uint32_t row) {
+            return SymmetricMat3Pack<Pack>{
+                load(row), load(row + 1), load(row + 2), load(row + 3), load(row + 4), load(row + 5)
+            };
+        };
+        auto const store = [lane, stride](uint32_t row, Pack const& value) {
+            value.StoreUnaligned(lane + row * stride);
+        };
+        auto const store3 = [&store](uint32_t row, Vec3Pack<Pack> const& value) {
+            store(row, value.x);
+            store(row + 1, value.y);
+            store(row + 2, value.z);
+        };
+
+        Pack const dampingFactor = load(DAMPING_FACTOR);
+
+        //Linear motion
+        Pack const inverseMass = load(INVERSE_MASS);
+        Vec3Pack<Pack> const linearVelocity = ClampSpeed(load3(LINEAR_VELOCITY_X), maxSpeed, threshold);
+        Vec3Pack<Pack> const linearAcceleration = load3(LINEAR_ACCELERATION_X) + load3(FORCE_X) * inverseMass;
+        Vec3Pack<Pack> const newLinearVelocity = DampVelocity(
+            linearVelocity + linearAcceleration * duration, dampingFactor, threshold
+        );
+        store3(POSITION_X, Step::Move(
+            load3(POSITION_X), linearVelocity, newLinearVelocity,
+            load3(LINEAR_ACCELERATION_X) + load3(POSITION_FORCE_X) * inverseMass, duration
+        ));
+        store3(LINEAR_VELOCITY_X, newLinearVelocity);
+
+        //Angular motion
+        SymmetricMat3Pack<Pack> const inverseInertia = load6(INVERSE_INERTIA);
+        Vec3Pack<Pack> angularVelocity = ClampSpeed(load3(ANGULAR_VELOCITY_X), maxSpeed, threshold);
+        if (gyroscopicTorque)
+        {
+            angularVelocity = ApplyGyroscopicTorque(angularVelocity, inverseInertia, duration);
+        }
+        Vec3Pack<Pack> const angularAcceleration = load3(ANGULAR_ACCELERATION_X) + inverseInertia * load3(TORQUE_X);
+        Vec3Pack<Pack> const newAngularVelocity = DampVelocity(
+            angularVelocity + angularAcceleration * duration, dampingFactor, threshold
+        );
+        store3(ANGULAR_VELOCITY_X, newAngularVelocity);
+
+        //q + 0.5 * duration * (0, w) * q
+        Vec3Pack<Pack> const spinVelocity = Step::Spin(angularVelocity, newAngularVelocity);
+        Vec3Pack<Pack> orientation = load3(ORIENTATION_X);
+        Pack orientationW = load(ORIENTATION_W);
+        Vec3Pack<Pack> const spin = (spinVelocity * orientationW + Cross(spinVelocity, orientation)) * halfDuration;
+        Pack const spinW = (zero - Dot(spinVelocity, orientation)) * halfDuration;
+        orientation = orientation + spin;
+        orientationW = orientationW + spinW;
+
+        Pack const length = Sqrt(Dot(orientation, orientation) + orientationW * orientationW);
+        Pack const isValid = CompareGreater(length, zero);
+        Pack const inverseLength = one / Select(isValid, length, one);
+        orientation = Select(isValid, orientation * inverseLength, Vec3Pack<Pack>{ zero, zero, zero });
+        orientationW = Select(isValid, orientationW * inverseLength, one);
+        store3(ORIENTATION_X, orientation);
+        store(ORIENTATION_W, orientationW);
+
+        //R * I * R^T, with the rows of the rotation matrix
+        Pack const two = Pack::Set(2.0f);
+        Pack const xx = orientation.x * orientation.x;
+        Pack const yy = orientation.y * orientation.y;
+        Pack const zz = orientation.z * orientation.z;
+        Pack const xy = orientation.x * orientation.y;
+        Pack const xz = orientation.x * orientation.z;
+        Pack const yz = orientation.y * orientation.z;
+        Pack const wx = orientationW * orientation.x;
+        Pack const wy = orientationW * orientation.y;
+        Pack const wz = orientationW * orientation.z;
+        Vec3Pack<Pack> const r0{ one - two * (yy + zz), two * (xy - wz), two * (xz + wy) };
+        Vec3Pack<Pack> const r1{ two * (xy + wz), one - two * (xx + zz), two * (yz - wx) };
+        Vec3Pack<Pack> const r2{ two * (xz - wy), two * (yz + wx), one - two * (xx + yy) };
+
+        SymmetricMat3Pack<Pack> const bodyInverseInertia = load6(BODY_INVERSE_INERTIA);
+        Vec3Pack<Pack> const u0 = bodyInverseInertia * r0;
+        Vec3Pack<Pack> const u1 = bodyInverseInertia * r1;
+        Vec3Pack<Pack> const u2 = bodyInverseInertia * r2;
+        store(INVERSE_INERTIA, Dot(r0, u0));
+        store(INVERSE_INERTIA + 1, Dot(r0, u1));
+        store(INVERSE_INERTIA + 2, Dot(r0, u2));
+        store(INVERSE_INERTIA + 3, Dot(r1, u1));
+        store(INVERSE_INERTIA + 4, Dot(r1, u2));
+        store(INVERSE_INERTIA + 5, Dot(r2, u2));
+    }
+
+    return integrated;
+}
+
+/**
+ * @brief Returns true if the library contains the AVX2 kernel
+ */
+bool HasAvx2IntegrationKernel();
+
+/**
+ * @brief Integrates motion of the bodies in groups of eight using AVX2 instructions
+ *
+ * Instantiated for all step policies in the AVX2 translation unit.
+ *
+ * @tparam Step step policy type
+ * @param[in,out] lanes      body motions buffer
+ * @param[in]     stride     distance between the buffer rows
+ * @param[in]     count      number of bodies
+ * @param[in]     parameters shared parameters
+ * @return number of integrated bodies, a multiple of eight
+ */
+template < typename Step >
+uint32_t IntegrateMotionLanesAvx2(float* lanes, uint32_t stride, uint32_t count, MotionLaneParameters const& parameters);
+
+} // namespace kernel
+} // namespace integration
+} // namespace pegasus
+#endif // PEGASUS_INTEGRATION_KERNEL_HPP
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#include <pegasus/Joint.hpp>
+
+namespace pegasus
+{
+namespace joint
+{
+namespace
+{
+
+/**
+ * @brief Transforms the world space point into the body space
+ * @param body body data
+ * @param point world space point
+ * @return body space point
+ */
+glm::vec3 ToBodySpace(mechanics::Body const& body, glm::vec3 point)
+{
+    return glm::conjugate(body.angularMotion.orientation) * (point - body.linearMotion.position);
+}
+
+} // namespace
+
+Anchors::Anchors(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 aAnchor, glm::vec3 bAnchor)
+    : aAnchor(ToBodySpace(a, aAnchor))
+    , bAnchor(ToBodySpace(b, bAnchor))
+{
+}
+
+BallSocket::BallSocket(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 anchor)
+    : Anchors(a, b, anchor, anchor)
+{
+}
+
+Hinge::Hinge(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 anchor, glm::vec3 axis)
+    : Anchors(a, b, anchor, anchor)
+    , aAxis(glm::conjugate(a.angularMotion.orientation) * glm::normalize(axis))
+    , bAxis(glm::conjugate(b.angularMotion.orientation) * glm::normalize(axis))
+{
+}
+
+Distance::Distance(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 aAnchor, glm::vec3 bAnchor)
+    : Anchors(a, b, aAnchor, bAnchor)
+    , distance(glm::distance(aAnchor, bAnchor))
+{
+}
+
+Fixed::Fixed(mechanics::Body const& a, mechanics::Body const& b, glm::vec3 anchor)
+    : Anchors(a, b, anchor, anchor)
+    , relativeOrientation(glm::conjugate(a.angularMotion.orientation) * b.angularMotion.orientation)
+{
+}
+
+} // namespace joint
+} // namespace pegasus
@@ -17,7 +17,10 @@ Primitive::~Primitive()
 
 void Primitive::SetBody(mechanics::Body body) const
 {
-    m_pScene->GetBody(m_bodyHandle) = body;
+    mechanics::Body& data = m_pScene->GetBody(m_bodyHandle);
+    data = body;
+    mechanics::UpdateInverseInertia(data);
+    m_pScene->WakeUp(m_bodyHandle);
 }
 
 mechanics::Body Primitive::GetBody() const
@@ -45,7 +48,9 @@ Primitive::Primitive(Scene& scene, Type type, mechanics::Body body)
     , m_type(type)
 {
     m_bodyHandle = m_pScene->MakeBody();
-    m_pScene->GetBody(m_bodyHandle) = body;
+    mechanics::Body& data = m_pScene->GetBody(m_bodyHandle);
+    data = body;
+    mechanics::UpdateInverseInertia(data);
 }
 
 Plane::Plane(Scene& scene, Type type, mechanics::Body body, arion::Plane plane)
@@ -7,6 +7,84 @@
 #include <pegasus/Debug.hpp>
 #include <pegasus/Force.hpp>
 #include <pegasus/Integration.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+
+/**
+ * @brief Checks if the global fields act on the bodies in the same way
+ * @param lhs first field
+ * @param rhs second field
+ * @return @c true if the fields are equal
+ */
+bool IsSameField(pegasus::force::GlobalField const& lhs, pegasus::force::GlobalField const& rhs)
+{
+    return lhs.acceleration == rhs.acceleration && lhs.flowVelocity == rhs.flowVelocity
+        && lhs.linearDrag == rhs.linearDrag && lhs.quadraticDrag == rhs.quadraticDrag
+        && lhs.groupMask == rhs.groupMask;
+}
+
+/**
+ * @brief Checks if the mutual attractions act on the bodies in the same way
+ * @param lhs first attraction
+ * @param rhs second attraction
+ * @return @c true if the attractions are equal
+ */
+bool IsSameField(pegasus::force::MutualAttraction const& lhs, pegasus::force::MutualAttraction const& rhs)
+{
+    return lhs.gravitationalConstant == rhs.gravitationalConstant && lhs.openingAngle == rhs.openingAngle
+        && lhs.softening == rhs.softening && lhs.groupMask == rhs.groupMask && lhs.sourceMask == rhs.sourceMask;
+}
+
+/**
+ * @brief Copies active field assets into the field list
+ * @tparam Field field type
+ * @param[in]     assets field assets
+ * @param[in,out] fields fields of the previous step, replaced with the active fields
+ * @return groups of the bodies affected by the fields that were made, changed or removed
+ */
+template < typename Field >
+uint32_t UpdateFields(std::vector<pegasus::scene::Asset<Field>> const& assets, std::vector<Field>& fields)
+{
+    uint32_t changedGroups = 0;
+    size_t count = 0;
+    for (pegasus::scene::Asset<Field> const& asset : assets)
+    {
+        if (asset.id == pegasus::scene::ZERO_HANDLE)
+        {
+            continue;
+        }
+
+        if (count == fields.size())
+        {
+            changedGroups |= asset.data.groupMask;
+            fields.push_back(asset.data);
+        }
+        else if (!IsSameField(fields[count], asset.data))
+        {
+            changedGroups |= fields[count].groupMask | asset.data.groupMask;
+            fields[count] = asset.data;
+        }
+        ++count;
+    }
+
+    for (size_t i = count; i < fields.size(); ++i)
+    {
+        changedGroups |= fields[i].groupMask;
+    }
+    fields.resize(count);
+
+    return changedGroups;
+}
+
+//!Shortest duration of the frames computed by Scene::Step
+float const MIN_FIXED_STEP_DURATION = 1e-6f;
+
+} // namespace ::
 
 namespace pegasus
 {
@@ -15,16 +93,58 @@ namespace scene
 
 void Scene::ComputeFrame(float duration)
 {
-    collision::ResolvePersistantContacts(m_assetManager, m_persistentContacts, duration);
+    if (solverSubsteps > 1)
+    {
+        ComputeSubsteps(duration);
+
+        if (sleepingEnabled)
+        {
+            UpdateSleeping(duration);
+        }
+        return;
+    }
 
-    ApplyForces(forceDuration);
+    collision::ResolvePersistantContacts(
+        m_assetManager, m_solver, m_threadPool, m_persistentContacts, duration
+    );
 
     Integrate(duration);
 
     m_currentContacts = collision::DetectContacts(m_assetManager);
     Debug::CollisionDetectionCall(m_currentContacts);
 
-    collision::ResolveContacts(m_assetManager, m_persistentContacts, m_currentContacts, m_previousContacts, duration);
+    collision::ResolveContacts(
+        m_assetManager, m_solver, m_threadPool,
+        m_persistentContacts, m_currentContacts, m_previousContacts, duration
+    );
+    m_previousContacts = std::move(m_currentContacts);
+
+    if (sleepingEnabled)
+    {
+        UpdateSleeping(duration);
+    }
+}
+
+void Scene::ComputeSubsteps(float duration)
+{
+    m_currentContacts = collision::DetectContacts(m_assetManager);
+    Debug::CollisionDetectionCall(m_currentContacts);
+
+    //Sub-steps resolve every contact on their own, so there is nothing to warm start from
+    m_persistentContacts.clear();
+
+    collision::LoadSolverBodies(m_assetManager, m_currentContacts, m_solver.bodies);
+
+    float const substepDuration = duration / solverSubsteps;
+    for (uint32_t i = 0; i < solverSubsteps; ++i)
+    {
+        Integrate(substepDuration);
+
+        collision::ResolveSubstepContacts(
+            m_assetManager, m_solver, m_threadPool, m_currentContacts, substepDuration
+        );
+    }
+
     m_previousContacts = std::move(m_currentContacts);
 }
 
@@ -33,6 +153,72 @@ Handle Scene::MakeBody()
     return m_assetManager.MakeAsset(m_assetManager.GetBodies());
 }
 
+uint32_t Scene::Step(float realDuration)
+{
+    assert(fixedStepDuration > 0.0f);
+    float const stepDuration = glm::max(fixedStepDuration, MIN_FIXED_STEP_DURATION);
+    m_accumulatedDuration += realDuration;
+
+    uint32_t const steps = glm::min(static_cast<uint32_t>(m_accumulatedDuration / stepDuration), maxFixedSteps);
+    for (uint32_t i = 0; i < steps; ++i)
+    {
+        if (i + 1 == steps)
+        {
+            std::vector<Asset<mechanics::Body>>& bodies = m_assetManager.GetBodies();
+            m_previousTransforms.resize(bodies.size());
+            for (size_t j = 0; j < bodies.size(); ++j)
+            {
+                mechanics::Body const& body = bodies[j].data;
+                m_previousTransforms[j] = { body.linearMotion.position, body.angularMotion.orientation };
+            }
+        }
+
+        ComputeFrame(stepDuration);
+    }
+
+    m_accumulatedDuration -= steps * stepDuration;
+    if (steps == maxFixedSteps && m_accumulatedDuration >= stepDuration)
+    {
+        m_accumulatedDuration = std::fmod(m_accumulatedDuration, stepDuration);
+    }
+
+    return steps;
+}
+
+float Scene::GetInterpolationAlpha() const
+{
+    assert(fixedStepDuration > 0.0f);
+    return m_accumulatedDuration / glm::max(fixedStepDuration, MIN_FIXED_STEP_DURATION);
+}
+
+BodyTransform Scene::GetPreviousTransform(Handle handle)
+{
+    if (handle > m_previousTransforms.size())
+    {
+        return GetCurrentTransform(handle);
+    }
+
+    return m_previousTransforms[handle - 1];
+}
+
+BodyTransform Scene::GetCurrentTransform(Handle handle)
+{
+    mechanics::Body const& body = GetBody(handle);
+    return { body.linearMotion.position, body.angularMotion.orientation };
+}
+
+BodyTransform Scene::GetInterpolatedTransform(Handle handle)
+{
+    BodyTransform const previous = GetPreviousTransform(handle);
+    BodyTransform const current = GetCurrentTransform(handle);
+    float const alpha = GetInterpolationAlpha();
+
+    return {
+        glm::mix(previous.position, current.position, alpha),
+        glm::slerp(previous.orientation, current.orientation, alpha)
+    };
+}
+
 mechanics::Body& Scene::GetBody(Handle handle)
 {
     return m_assetManager.GetAsset(m_assetManager.GetBodies(), handle);
@@ -40,45 +226,689 @@ mechanics::Body& Scene::GetBody(Handle handle)
 
 void Scene::RemoveBody(Handle handle)
 {
+    WakeUpTouching(handle);
+
+    //A body reusing the handle must not inherit the residual of the removed one
+    std::vector<float>& residuals = m_solver.islandIterations.bodyResiduals;
+    if (handle <= residuals.size())
+    {
+        residuals[handle - 1] = 0.0f;
+    }
+
     m_assetManager.RemoveAsset(m_assetManager.GetBodies(), handle);
 }
 
+Handle Scene::MakeArticulation(Handle base)
+{
+    Handle const id = m_assetManager.MakeAsset(m_assetManager.GetArticulations());
+    GetArticulation(id).base = base;
+    return id;
+}
+
+uint32_t Scene::AddRevoluteLink(Handle articulation, uint32_t parent, Handle body, glm::vec3 anchor, glm::vec3 axis)
+{
+    mechanics::Articulation& data = GetArticulation(articulation);
+    Handle const parentBody = (parent == mechanics::ARTICULATION_BASE) ? data.base : data.links[parent].body;
+
+    data.links.push_back(mechanics::MakeRevoluteLink(
+        GetBody(parentBody), parent, body, GetBody(body), anchor, axis
+    ));
+    WakeUp(body);
+    return static_cast<uint32_t>(data.links.size() - 1);
+}
+
+mechanics::Articulation& Scene::GetArticulation(Handle handle)
+{
+    return m_assetManager.GetAsset(m_assetManager.GetArticulations(), handle);
+}
+
+void Scene::RemoveArticulation(Handle handle)
+{
+    for (mechanics::ArticulationLink const& link : GetArticulation(handle).links)
+    {
+        WakeUp(link.body);
+    }
+    m_assetManager.RemoveAsset(m_assetManager.GetArticulations(), handle);
+}
+
+void Scene::WakeUp(Handle handle)
+{
+    WakeUp(GetBody(handle));
+}
+
+void Scene::ApplyImpulse(Handle handle, glm::vec3 impulse, glm::vec3 point)
+{
+    mechanics::Body& body = GetBody(handle);
+    WakeUp(body);
+
+    body.linearMotion.velocity += impulse * body.material.GetInverseMass();
+    body.angularMotion.velocity += body.inverseInertia * glm::cross(point - body.linearMotion.position, impulse);
+}
+
+void Scene::SetThreadCount(uint32_t threadCount)
+{
+    m_threadPool.SetThreadCount(threadCount);
+}
+
+uint32_t Scene::GetThreadCount() const
+{
+    return m_threadPool.GetThreadCount();
+}
+
+void Scene::SetSolverMode(collision::SolverMode mode)
+{
+    m_solver.mode = mode;
+}
+
+collision::SolverMode Scene::GetSolverMode() const
+{
+    return m_solver.mode;
+}
+
+void Scene::SetSolverRelaxation(float relaxation)
+{
+    m_solver.relaxation = relaxation;
+}
+
+float Scene::GetSolverRelaxation() const
+{
+    return m_solver.relaxation;
+}
+
+void Scene::SetPositionCorrection(collision::PositionCorrection positionCorrection)
+{
+    m_solver.positionCorrection = positionCorrection;
+}
+
+collision::PositionCorrection Scene::GetPositionCorrection() const
+{
+    return m_solver.positionCorrection;
+}
+
+void Scene::SetSolverIterations(uint32_t velocityIterations, uint32_t positionIterations)
+{
+    m_solver.velocityIterations = velocityIterations;
+    m_solver.positionIterations = positionIterations;
+}
+
+uint32_t Scene::GetVelocityIterations() const
+{
+    return m_solver.velocityIterations;
+}
+
+uint32_t Scene::GetPositionIterations() const
+{
+    return m_solver.positionIterations;
+}
+
+void Scene::SetBlockSolverEnabled(bool enabled)
+{
+    m_solver.blockSolverEnabled = enabled;
+}
+
+bool Scene::IsBlockSolverEnabled() const
+{
+    return m_solver.blockSolverEnabled;
+}
+
+void Scene::SetSolverTolerance(float tolerance)
+{
+    m_solver.tolerance = tolerance;
+}
+
+float Scene::GetSolverTolerance() const
+{
+    return m_solver.tolerance;
+}
+
+void Scene::SetAdaptiveIterationsEnabled(bool enabled)
+{
+    m_solver.adaptiveIterations = enabled;
+}
+
+bool Scene::IsAdaptiveIterationsEnabled() const
+{
+    return m_solver.adaptiveIterations;
+}
+
+void Scene::SetSolverIterationBudget(uint32_t budget)
+{
+    m_solver.iterationBudget = budget;
+}
+
+uint32_t Scene::GetSolverIterationBudget() const
+{
+    return m_solver.iterationBudget;
+}
+
+collision::SolverStatistics const& Scene::GetSolverStatistics() const
+{
+    return m_solver.statistics;
+}
+
+void Scene::SetSolverInstructionSet(collision::SimdInstructionSet instructionSet)
+{
+    m_solver.instructionSet = std::min(instructionSet, collision::DetectSimdInstructionSet());
+}
+
+collision::SimdInstructionSet Scene::GetSolverInstructionSet() const
+{
+    return m_solver.instructionSet;
+}
+
+void Scene::SetIntegrator(integration::Integrator integrator)
+{
+    m_integrator = integrator;
+}
+
+integration::Integrator Scene::GetIntegrator() const
+{
+    return m_integrator;
+}
+
+void Scene::SetGyroscopicTorqueEnabled(bool enabled)
+{
+    m_gyroscopicTorque = enabled;
+}
+
+bool Scene::IsGyroscopicTorqueEnabled() const
+{
+    return m_gyroscopicTorque;
+}
+
 AssetManager& Scene::GetAssets()
 {
     return m_assetManager;
 }
 
-void Scene::ApplyForces(float duration)
+void Scene::BindBodies()
 {
-    //Clear previously applied forces
-    for (Asset<mechanics::Body>& asset : m_assetManager.GetBodies())
+    if (m_bindingsRevision != m_assetManager.GetRevision())
     {
-        asset.data.linearMotion.force = glm::vec3(0);
-        asset.data.angularMotion.torque = glm::vec3(0);
+        m_bindingsRevision = m_assetManager.GetRevision();
+        uint32_t const bodyCount = static_cast<uint32_t>(m_assetManager.GetBodies().size());
+
+        BindForces(bodyCount);
+
+        ClearBodyBindings(m_shapeBindings);
+        BindShapes<DynamicBody, arion::Plane>();
+        BindShapes<DynamicBody, arion::Sphere>();
+        BindShapes<DynamicBody, arion::Box>();
+        BindShapes<KinematicBody, arion::Plane>();
+        BindShapes<KinematicBody, arion::Sphere>();
+        BindShapes<KinematicBody, arion::Box>();
+        SortBodyBindings(m_shapeBindings, bodyCount);
     }
 
-    //Reapply forces
-    ApplyForce<force::StaticField>(duration);
-    ApplyForce<force::SquareDistanceSource>(duration);
-    ApplyForce<force::Drag>(duration);
-    ApplyForce<force::Spring>(duration);
-    ApplyForce<force::Bungee>(duration);
-    ApplyForce<force::Buoyancy>(duration);
+    //Sleeping bodies would ignore new or changed fields, so the bodies they act on are woken up
+    uint32_t const changedGroups = ::UpdateFields(m_assetManager.GetForces<force::GlobalField>(), m_globalFields)
+        | ::UpdateFields(m_assetManager.GetForces<force::MutualAttraction>(), m_attractions);
+    if (changedGroups != 0)
+    {
+        for (Asset<mechanics::Body>& asset : m_assetManager.GetBodies())
+        {
+            if (asset.id != ZERO_HANDLE && asset.data.asleep && (asset.data.groups & changedGroups))
+            {
+                WakeUp(asset.data);
+            }
+        }
+    }
+}
+
+void Scene::BindForces(uint32_t bodyCount)
+{
+    m_boundBodies.assign(bodyCount, 0);
+
+    ForceRegistry& registry = m_assetManager.GetForceRegistry();
+    for (uint32_t type = 0; type < registry.GetTypeCount(); ++type)
+    {
+        ForceStorageBase& storage = registry.GetStorage(type);
+        storage.SortBinds();
+        for (BoundForce const& bind : storage.bound)
+        {
+            m_boundBodies[bind.body] = 1;
+        }
+    }
 }
 
 void Scene::Integrate(float duration)
 {
+    BindBodies();
+    CalculateAttractionFields();
+    CalculateBatchedForces();
+    IntegrateArticulations(duration);
+
+    //Chunks cover fixed asset ranges, so bodies never move between threads and the result does not depend on them
+    uint32_t const bodyCount = static_cast<uint32_t>(m_assetManager.GetBodies().size());
+    uint32_t const chunkCount = (bodyCount + integration::BODY_CHUNK_SIZE - 1) / integration::BODY_CHUNK_SIZE;
+    m_threadPool.ParallelFor(chunkCount, [this, bodyCount, duration](size_t chunk) {
+        uint32_t const begin = static_cast<uint32_t>(chunk) * integration::BODY_CHUNK_SIZE;
+        IntegrateBodies(begin, glm::min(begin + integration::BODY_CHUNK_SIZE, bodyCount), duration);
+    });
+}
+
+void Scene::IntegrateBodies(uint32_t begin, uint32_t end, float duration)
+{
+    std::vector<Asset<mechanics::Body>>& bodies = m_assetManager.GetBodies();
+
+    //Buffers are sized for a whole chunk, so integration does not allocate
+    uint32_t const stride = integration::BODY_MOTIONS_TILE_SIZE;
+    float lanes[integration::BODY_MOTION_LANE_COUNT * stride];
+    uint32_t tile[integration::BODY_MOTIONS_TILE_SIZE];
+    mechanics::Body* targets[integration::BODY_CHUNK_SIZE] = {};
+    glm::vec3 positionForces[integration::BODY_CHUNK_SIZE];
+    integration::StageMotions stages;
+
+    for (uint32_t index = begin; index < end;)
+    {
+        uint32_t const tileBegin = index;
+        uint32_t tileSize = 0;
+        for (; index < end && tileSize < integration::BODY_MOTIONS_TILE_SIZE; ++index)
+        {
+            mechanics::Body& body = bodies[index].data;
+            if (bodies[index].id == ZERO_HANDLE || body.asleep || m_articulatedBodies[index])
+            {
+                continue;
+            }
+
+            //Static and kinematic bodies only follow their velocities
+            if (body.material.HasInfiniteMass())
+            {
+                integration::IntegrateKinematic(body, duration);
+                ApplyBodyBindings(m_shapeBindings, index, m_assetManager, body, duration);
+                continue;
+            }
+
+            targets[index - begin] = &body;
+            tile[tileSize++] = index;
+        }
+
+        if (tileSize == 0)
+        {
+            continue;
+        }
+
+        ApplyStageForces(
+            { tileBegin, index - tileBegin, targets + (tileBegin - begin) }, positionForces + (tileBegin - begin),
+            duration, stages
+        );
+
+        for (uint32_t i = 0; i < tileSize; ++i)
+        {
+            integration::LoadBodyMotion(lanes, stride, i, bodies[tile[i]].data, positionForces[tile[i] - begin]);
+        }
+
+        integration::Integrate(
+            lanes, stride, tileSize, duration, m_integrator, m_gyroscopicTorque, m_solver.instructionSet
+        );
+
+        for (uint32_t i = 0; i < tileSize; ++i)
+        {
+            mechanics::Body& body = bodies[tile[i]].data;
+            integration::StoreBodyMotion(lanes, stride, i, body);
+            ApplyBodyBindings(m_shapeBindings, tile[i], m_assetManager, body, duration);
+        }
+    }
+}
+
+void Scene::ApplyBodyForces(ForceTargets const& targets)
+{
+    for (uint32_t i = 0; i < targets.count; ++i)
+    {
+        if (targets.bodies[i] != nullptr)
+        {
+            targets.bodies[i]->linearMotion.force = glm::vec3(0);
+            targets.bodies[i]->angularMotion.torque = glm::vec3(0);
+        }
+    }
+
+    //Each force type walks its own binds of the range, so the forces of one type are applied by a single loop
+    ForceRegistry& registry = m_assetManager.GetForceRegistry();
+    for (uint32_t type = 0; type < registry.GetTypeCount(); ++type)
+    {
+        ForceStorageBase const& storage = registry.GetStorage(type);
+        if (!storage.batched && !storage.bound.empty())
+        {
+            storage.ApplyForces(targets, forceDuration);
+        }
+    }
+
+    for (uint32_t i = 0; i < targets.count; ++i)
+    {
+        mechanics::Body* body = targets.bodies[i];
+        if (body == nullptr)
+        {
+            continue;
+        }
+
+        uint32_t const index = targets.begin + i;
+        for (force::GlobalField const& field : m_globalFields)
+        {
+            if (field.groupMask & body->groups)
+            {
+                body->linearMotion.force += field.CalculateForce(*body) * forceDuration;
+                body->angularMotion.torque += field.CalculateTorque(*body) * forceDuration;
+            }
+        }
+
+        if (!m_attractions.empty())
+        {
+            body->linearMotion.force += m_attractionFields[index] * body->material.GetMass() * forceDuration;
+        }
+
+        if (!m_batchedForces.empty())
+        {
+            body->linearMotion.force += m_batchedForces[index] * forceDuration;
+            body->angularMotion.torque += m_batchedTorques[index] * forceDuration;
+        }
+    }
+}
+
+void Scene::CalculateBatchedForces()
+{
+    m_batchedForces.clear();
+    m_batchedTorques.clear();
+
+    std::vector<Asset<mechanics::Body>> const& bodies = m_assetManager.GetBodies();
+    ForceRegistry& registry = m_assetManager.GetForceRegistry();
+    for (uint32_t type = 0; type < registry.GetTypeCount(); ++type)
+    {
+        ForceStorageBase& storage = registry.GetStorage(type);
+        if (storage.batched && !storage.bound.empty())
+        {
+            m_batchedForces.resize(bodies.size(), glm::vec3(0));
+            m_batchedTorques.resize(bodies.size(), glm::vec3(0));
+            storage.AddBatchedForces(bodies, m_batchedForces, m_batchedTorques);
+        }
+    }
+}
+
+void Scene::CalculateAttractionFields()
+{
+    if (m_attractions.empty())
+    {
+        return;
+    }
+
+    std::vector<Asset<mechanics::Body>> const& bodies = m_assetManager.GetBodies();
+    uint32_t const bodyCount = static_cast<uint32_t>(bodies.size());
+    m_attractionFields.assign(bodyCount, glm::vec3(0));
+
+    for (force::MutualAttraction const& attraction : m_attractions)
+    {
+        BuildAttractorTree(attraction);
+
+        //Groups own disjoint sets of bodies, so the tasks never write the same field
+        m_sourceFields.assign(bodyCount, glm::vec3(0));
+        uint32_t const chunkSize = force::ATTRACTOR_GROUP_CHUNK_SIZE;
+        uint32_t const groupCount = m_attractorTree.GetGroupCount();
+        uint32_t const chunkCount = (groupCount + chunkSize - 1) / chunkSize;
+        m_threadPool.ParallelFor(chunkCount, [this, &attraction, chunkSize, groupCount](size_t chunk) {
+            uint32_t const begin = static_cast<uint32_t>(chunk) * chunkSize;
+            m_attractorTree.AddGroupFields(
+                begin, glm::min(begin + chunkSize, groupCount),
+                attraction.openingAngle, attraction.softening, m_sourceFields
+            );
+        });
+
+        //Bodies that are not integrated need no field, the others walk the tree on their own
+        uint32_t const bodyChunkCount = (bodyCount + integration::BODY_CHUNK_SIZE - 1) / integration::BODY_CHUNK_SIZE;
+        m_threadPool.ParallelFor(bodyChunkCount, [this, &bodies, &attraction, bodyCount](size_t chunk) {
+            uint32_t const begin = static_cast<uint32_t>(chunk) * integration::BODY_CHUNK_SIZE;
+            uint32_t const end = glm::min(begin + integration::BODY_CHUNK_SIZE, bodyCount);
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                mechanics::Body const& body = bodies[i].data;
+                if (bodies[i].id == ZERO_HANDLE || body.asleep || body.material.HasInfiniteMass()
+                    || !(attraction.groupMask & body.groups))
+                {
+                    continue;
+                }
+
+                m_attractionFields[i] += IsAttractionSource(attraction, body)
+                    ? m_sourceFields[i]
+                    : m_attractorTree.CalculateField(
+                        body.linearMotion.position, i, attraction.openingAngle, attraction.softening
+                    );
+            }
+        });
+    }
+}
+
+bool Scene::IsAttractionSource(force::MutualAttraction const& attraction, mechanics::Body const& body)
+{
+    return (attraction.sourceMask & body.groups) && !body.material.HasInfiniteMass();
+}
+
+void Scene::BuildAttractorTree(force::MutualAttraction const& attraction)
+{
+    std::vector<Asset<mechanics::Body>> const& bodies = m_assetManager.GetBodies();
+
+    m_attractorTree.Clear();
+    for (uint32_t i = 0; i < static_cast<uint32_t>(bodies.size()); ++i)
+    {
+        mechanics::Body const& body = bodies[i].data;
+        if (bodies[i].id != ZERO_HANDLE && IsAttractionSource(attraction, body))
+        {
+            m_attractorTree.Add({
+                body.linearMotion.position, attraction.gravitationalConstant * body.material.GetMass(), i
+            });
+        }
+    }
+    m_attractorTree.Build();
+}
+
+void Scene::ApplyStageForces(
+    ForceTargets const& targets, glm::vec3* positionForces, float duration, integration::StageMotions& stages
+)
+{
+    integration::ApplyStageForces(m_integrator, targets.bodies, positionForces, targets.count, duration, stages,
+        [this, &targets](mechanics::Body* const* stages) {
+            ApplyBodyForces({ targets.begin, targets.count, stages });
+        }
+    );
+}
+
+void Scene::IntegrateArticulations(float duration)
+{
+    std::vector<Asset<mechanics::Body>>& bodies = m_assetManager.GetBodies();
+    m_articulatedBodies.assign(bodies.size(), 0);
+
+    for (Asset<mechanics::Articulation>& asset : m_assetManager.GetArticulations())
+    {
+        if (asset.id == ZERO_HANDLE)
+        {
+            continue;
+        }
+
+        //Links are driven by the joint state, they never rest on their own
+        for (mechanics::ArticulationLink const& link : asset.data.links)
+        {
+            mechanics::Body* body = &bodies[link.body - 1].data;
+            m_articulatedBodies[link.body - 1] = 1;
+            WakeUp(*body);
+            ApplyBodyForces({ link.body - 1, 1, &body });
+        }
+
+        mechanics::IntegrateArticulation(asset.data, bodies, duration);
+
+        for (mechanics::ArticulationLink const& link : asset.data.links)
+        {
+            ApplyBodyBindings(m_shapeBindings, link.body - 1, m_assetManager, bodies[link.body - 1].data, duration);
+        }
+    }
+}
+
+void Scene::UpdateSleeping(float duration)
+{
+    float const linearVelocitySq = sleepLinearVelocity * sleepLinearVelocity;
+    float const angularVelocitySq = sleepAngularVelocity * sleepAngularVelocity;
+
+    //Moving kinematic bodies wake up what they touch, the islands follow below
+    for (collision::Contact const& contact : m_previousContacts)
+    {
+        if (collision::IsMovingKinematic(GetBody(contact.bBodyHandle)))
+        {
+            WakeUp(GetBody(contact.aBodyHandle));
+        }
+    }
+
+    //Update rest timers
     for (Asset<mechanics::Body>& asset : m_assetManager.GetBodies())
     {
-        if (asset.id != ZERO_HANDLE)
+        mechanics::Body& body = asset.data;
+        if (asset.id == ZERO_HANDLE || body.asleep || body.material.HasInfiniteMass())
+        {
+            continue;
+        }
+
+        if (glm::length2(body.linearMotion.velocity) > linearVelocitySq
+            || glm::length2(body.angularMotion.velocity) > angularVelocitySq)
+        {
+            body.restDuration = 0;
+        }
+        else
+        {
+            body.restDuration += duration;
+        }
+    }
+
+    //Islands wake up and fall asleep as a whole
+    for (collision::Island const& island : m_solver.islands.islands)
+    {
+        uint32_t const* begin = m_solver.islands.bodies.data() + island.bodyOffset;
+        uint32_t const* end = begin + island.bodyCount;
+
+        bool hasAwakeBodies = false;
+        bool hasSleepingBodies = false;
+        float restDuration = sleepDuration;
+        for (uint32_t const* index = begin; index != end; ++index)
+        {
+            mechanics::Body const& body = GetBody(m_solver.bodies.handles[*index]);
+            hasAwakeBodies = hasAwakeBodies || !body.asleep;
+            hasSleepingBodies = hasSleepingBodies || body.asleep;
+            restDuration = glm::min(restDuration, body.restDuration);
+        }
+
+        if (hasAwakeBodies && hasSleepingBodies)
+        {
+            for (uint32_t const* index = begin; index != end; ++index)
+            {
+                WakeUp(GetBody(m_solver.bodies.handles[*index]));
+            }
+        }
+        else if (hasAwakeBodies && restDuration >= sleepDuration)
+        {
+            for (uint32_t const* index = begin; index != end; ++index)
+            {
+                Sleep(GetBody(m_solver.bodies.handles[*index]));
+            }
+        }
+    }
+
+    //Bodies without contacts fall asleep on their own once they rested with nothing pushing them
+    std::vector<Asset<mechanics::Body>>& bodies = m_assetManager.GetBodies();
+    for (uint32_t i = 0; i < static_cast<uint32_t>(bodies.size()); ++i)
+    {
+        mechanics::Body& body = bodies[i].data;
+        if (bodies[i].id == ZERO_HANDLE || body.asleep || body.material.HasInfiniteMass()
+            || body.restDuration < sleepDuration)
+        {
+            continue;
+        }
+
+        bool const hasContacts = i < m_solver.bodies.indices.size()
+            && m_solver.bodies.indices[i] != collision::INVALID_SOLVER_BODY;
+        if (!hasContacts && !HasForces(i, body))
+        {
+            Sleep(body);
+        }
+    }
+
+    //Contacts of the sleeping bodies are not detected, so they are kept to wake the bodies once their support is removed
+    m_sleepingContacts.erase(std::remove_if(m_sleepingContacts.begin(), m_sleepingContacts.end(),
+        [this](std::pair<Handle, Handle> const& contact) {
+            return !GetBody(contact.first).asleep && !GetBody(contact.second).asleep;
+        }
+    ), m_sleepingContacts.end());
+    for (collision::Contact const& contact : m_previousContacts)
+    {
+        if (GetBody(contact.aBodyHandle).asleep || GetBody(contact.bBodyHandle).asleep)
+        {
+            m_sleepingContacts.emplace_back(contact.aBodyHandle, contact.bBodyHandle);
+        }
+    }
+}
+
+bool Scene::HasForces(uint32_t index, mechanics::Body const& body) const
+{
+    if (index < m_boundBodies.size() && m_boundBodies[index])
+    {
+        return true;
+    }
+
+    for (force::GlobalField const& field : m_globalFields)
+    {
+        if (field.groupMask & body.groups)
+        {
+            return true;
+        }
+    }
+
+    for (force::MutualAttraction const& attraction : m_attractions)
+    {
+        if (attraction.groupMask & body.groups)
         {
-            integration::Integrate(asset.data, duration);
+            return true;
         }
     }
 
-    UpdateShapes<DynamicBody, arion::Plane>();
-    UpdateShapes<DynamicBody, arion::Sphere>();
-    UpdateShapes<DynamicBody, arion::Box>();
+    return false;
+}
+
+void Scene::WakeUpTouching(Handle handle)
+{
+    for (collision::Contact const& contact : m_previousContacts)
+    {
+        if (contact.aBodyHandle == handle)
+        {
+            WakeUp(contact.bBodyHandle);
+        }
+        else if (contact.bBodyHandle == handle)
+        {
+            WakeUp(contact.aBodyHandle);
+        }
+    }
+
+    for (std::pair<Handle, Handle> const& contact : m_sleepingContacts)
+    {
+        if (contact.first == handle)
+        {
+            WakeUp(contact.second);
+        }
+        else if (contact.second == handle)
+        {
+            WakeUp(contact.first);
+        }
+    }
+    m_sleepingContacts.erase(std::remove_if(m_sleepingContacts.begin(), m_sleepingContacts.end(),
+        [handle](std::pair<Handle, Handle> const& contact) {
+            return contact.first == handle || contact.second == handle;
+        }
+    ), m_sleepingContacts.end());
+}
+
+void Scene::Sleep(mechanics::Body& body)
+{
+    body.asleep = true;
+    body.linearMotion.velocity = glm::vec3(0);
+    body.angularMotion.velocity = glm::vec3(0);
+}
+
+void Scene::WakeUp(mechanics::Body& body)
+{
+    body.asleep = false;
+    body.restDuration = 0;
 }
 
 } // namespace scene
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#ifndef PEGASUS_SIMD_PACK_HPP
+#define PEGASUS_SIMD_PACK_HPP
+
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PEGASUS_SIMD_X86_64
+#endif
+
+#ifdef PEGASUS_SIMD_X86_64
+#include <emmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#endif
+
+/*
+ * Packs are compiled with different instruction sets in different translation units,
+ * so they live in an anonymous namespace and every function that takes them is either
+ * a template or has internal linkage.
+ */
+
+namespace pegasus
+{
+namespace simd
+{
+
+/**
+ * @brief Stores three packs of lanes
+ * @tparam Pack lane pack type
+ */
+template < typename Pack >
+struct Vec3Pack
+{
+    Pack x;
+    Pack y;
+    Pack z;
+};
+
+template < typename Pack >
+Vec3Pack<Pack> operator+(Vec3Pack<Pack> const& a, Vec3Pack<Pack> const& b)
+{
+    return { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+template < typename Pack >
+Vec3Pack<Pack> operator-(Vec3Pack<Pack> const& a, Vec3Pack<Pack> const& b)
+{
+    return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+template < typename Pack >
+Vec3Pack<Pack> operator*(Vec3Pack<Pack> const& a, Pack const& s)
+{
+    return { a.x * s, a.y * s, a.z * s };
+}
+
+template < typename Pack >
+Pack Dot(Vec3Pack<Pack> const& a, Vec3Pack<Pack> const& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+template < typename Pack >
+Vec3Pack<Pack> Cross(Vec3Pack<Pack> const& a, Vec3Pack<Pack> const& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+template < typename Pack >
+Vec3Pack<Pack> Select(Pack const& mask, Vec3Pack<Pack> const& a, Vec3Pack<Pack> const& b)
+{
+    return { Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z) };
+}
+
+/**
+ * @brief Stores upper triangle of symmetric 3x3 matrix of lanes
+ * @tparam Pack lane pack type
+ */
+template < typename Pack >
+struct SymmetricMat3Pack
+{
+    Pack xx, xy, xz, yy, yz, zz;
+};
+
+template < typename Pack >
+Vec3Pack<Pack> operator*(SymmetricMat3Pack<Pack> const& m, Vec3Pack<Pack> const& v)
+{
+    return {
+        m.xx * v.x + m.xy * v.y + m.xz * v.z,
+        m.xy * v.x + m.yy * v.y + m.yz * v.z,
+        m.xz * v.x + m.yz * v.y + m.zz * v.z,
+    };
+}
+
+namespace
+{
+
+/**
+ * @brief Single lane pack, masks are stored as all bits set or cleared
+ */
+struct ScalarPack
+{
+    static uint32_t constexpr WIDTH = 1;
+
+    static ScalarPack Load(float const* data) { return { *data }; }
+    static ScalarPack LoadUnaligned(float const* data) { return { *data }; }
+    static ScalarPack Set(float value) { return { value }; }
+    void Store(float* data) const { *data = value; }
+    void StoreUnaligned(float* data) const { *data = value; }
+
+    static ScalarPack Mask(bool value)
+    {
+        uint32_t const bits = value ? ~0u : 0u;
+        ScalarPack mask;
+        std::memcpy(&mask.value, &bits, sizeof(bits));
+        return mask;
+    }
+
+    bool IsSet() const
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits != 0;
+    }
+
+    float value;
+};
+
+inline ScalarPack operator+(ScalarPack a, ScalarPack b) { return { a.value + b.value }; }
+inline ScalarPack operator-(ScalarPack a, ScalarPack b) { return { a.value - b.value }; }
+inline ScalarPack operator*(ScalarPack a, ScalarPack b) { return { a.value * b.value }; }
+inline ScalarPack operator/(ScalarPack a, ScalarPack b) { return { a.value / b.value }; }
+inline ScalarPack Min(ScalarPack a, ScalarPack b) { return { a.value < b.value ? a.value : b.value }; }
+inline ScalarPack Max(ScalarPack a, ScalarPack b) { return { a.value > b.value ? a.value : b.value }; }
+inline ScalarPack Sqrt(ScalarPack a) { return { std::sqrt(a.value) }; }
+inline ScalarPack And(ScalarPack a, ScalarPack b) { return ScalarPack::Mask(a.IsSet() && b.IsSet()); }
+inline ScalarPack IsNan(ScalarPack a) { return ScalarPack::Mask(a.value != a.value); }
+inline ScalarPack CompareGreater(ScalarPack a, ScalarPack b) { return ScalarPack::Mask(a.value > b.value); }
+inline ScalarPack CompareGreaterEqual(ScalarPack a, ScalarPack b) { return ScalarPack::Mask(a.value >= b.value); }
+inline ScalarPack Select(ScalarPack mask, ScalarPack a, ScalarPack b) { return mask.IsSet() ? a : b; }
+
+#ifdef PEGASUS_SIMD_X86_64
+/**
+ * @brief Four lane pack using SSE2 instructions
+ */
+struct SsePack
+{
+    static uint32_t constexpr WIDTH = 4;
+
+    static SsePack Load(float const* data) { return { _mm_load_ps(data) }; }
+    static SsePack LoadUnaligned(float const* data) { return { _mm_loadu_ps(data) }; }
+    static SsePack Set(float value) { return { _mm_set1_ps(value) }; }
+    void Store(float* data) const { _mm_store_ps(data, value); }
+    void StoreUnaligned(float* data) const { _mm_storeu_ps(data, value); }
+
+    __m128 value;
+};
+
+inline SsePack operator+(SsePack a, SsePack b) { return { _mm_add_ps(a.value, b.value) }; }
+inline SsePack operator-(SsePack a, SsePack b) { return { _mm_sub_ps(a.value, b.value) }; }
+inline SsePack operator*(SsePack a, SsePack b) { return { _mm_mul_ps(a.value, b.value) }; }
+inline SsePack operator/(SsePack a, SsePack b) { return { _mm_div_ps(a.value, b.value) }; }
+inline SsePack Min(SsePack a, SsePack b) { return { _mm_min_ps(a.value, b.value) }; }
+inline SsePack Max(SsePack a, SsePack b) { return { _mm_max_ps(a.value, b.value) }; }
+inline SsePack Sqrt(SsePack a) { return { _mm_sqrt_ps(a.value) }; }
+inline SsePack And(SsePack a, SsePack b) { return { _mm_and_ps(a.value, b.value) }; }
+inline SsePack IsNan(SsePack a) { return { _mm_cmpunord_ps(a.value, a.value) }; }
+inline SsePack CompareGreater(SsePack a, SsePack b) { return { _mm_cmpgt_ps(a.value, b.value) }; }
+inline SsePack CompareGreaterEqual(SsePack a, SsePack b) { return { _mm_cmpge_ps(a.value, b.value) }; }
+
+inline SsePack Select(SsePack mask, SsePack a, SsePack b)
+{
+    return { _mm_or_ps(_mm_and_ps(mask.value, a.value), _mm_andnot_ps(mask.value, b.value)) };
+}
+
+#ifdef __AVX2__
+/**
+ * @brief Eight lane pack using AVX2 instructions
+ */
+struct Avx2Pack
+{
+    static uint32_t constexpr WIDTH = 8;
+
+    static Avx2Pack Load(float const* data) { return { _mm256_load_ps(data) }; }
+    static Avx2Pack LoadUnaligned(float const* data) { return { _mm256_loadu_ps(data) }; }
+    static Avx2Pack Set(float value) { return { _mm256_set1_ps(value) }; }
+    void Store(float* data) const { _mm256_store_ps(data, value); }
+    void StoreUnaligned(float* data) const { _mm256_storeu_ps(data, value); }
+
+    __m256 value;
+};
+
+inline Avx2Pack operator+(Avx2Pack a, Avx2Pack b) { return { _mm256_add_ps(a.value, b.value) }; }
+inline Avx2Pack operator-(Avx2Pack a, Avx2Pack b) { return { _mm256_sub_ps(a.value, b.value) }; }
+inline Avx2Pack operator*(Avx2Pack a, Avx2Pack b) { return { _mm256_mul_ps(a.value, b.value) }; }
+inline Avx2Pack operator/(Avx2Pack a, Avx2Pack b) { return { _mm256_div_ps(a.value, b.value) }; }
+inline Avx2Pack Min(Avx2Pack a, Avx2Pack b) { return { _mm256_min_ps(a.value, b.value) }; }
+inline Avx2Pack Max(Avx2Pack a, Avx2Pack b) { return { _mm256_max_ps(a.value, b.value) }; }
+inline Avx2Pack Sqrt(Avx2Pack a) { return { _mm256_sqrt_ps(a.value) }; }
+inline Avx2Pack And(Avx2Pack a, Avx2Pack b) { return { _mm256_and_ps(a.value, b.value) }; }
+inline Avx2Pack IsNan(Avx2Pack a) { return { _mm256_cmp_ps(a.value, a.value, _CMP_UNORD_Q) }; }
+
+inline Avx2Pack CompareGreater(Avx2Pack a, Avx2Pack b)
+{
+    return { _mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ) };
+}
+
+inline Avx2Pack CompareGreaterEqual(Avx2Pack a, Avx2Pack b)
+{
+    return { _mm256_cmp_ps(a.value, b.value, _CMP_GE_OQ) };
+}
+
+inline Avx2Pack Select(Avx2Pack mask, Avx2Pack a, Avx2Pack b)
+{
+    return { _mm256_blendv_ps(b.value, a.value, mask.value) };
+}
+#endif // __AVX2__
+#endif // PEGASUS_SIMD_X86_64
+
+} // namespace
+} // namespace simd
+} // namespace pegasus
+#endif // PEGASUS_SIMD_PACK_HPP
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#include <pegasus/ThreadPool.hpp>
+
+namespace pegasus
+{
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+    : m_nextTask(0)
+{
+    SetThreadCount(threadCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+    Stop();
+}
+
+void ThreadPool::SetThreadCount(uint32_t threadCount)
+{
+    Stop();
+
+    //New workers must not take the last finished job for a new one
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = false;
+        generation = m_generation;
+    }
+
+    for (uint32_t i = 1; i < threadCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this, generation);
+    }
+}
+
+uint32_t ThreadPool::GetThreadCount() const
+{
+    return static_cast<uint32_t>(m_workers.size()) + 1;
+}
+
+void ThreadPool::ParallelFor(size_t count, std::function<void(size_t)> const& task)
+{
+    if (m_workers.empty() || count < 2)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pTask = &task;
+        m_taskCount = count;
+        m_nextTask = 0;
+        m_activeWorkers = static_cast<uint32_t>(m_workers.size());
+        ++m_generation;
+    }
+    m_jobCondition.notify_all();
+
+    RunTasks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this]() { return m_activeWorkers == 0; });
+    m_pTask = nullptr;
+}
+
+void ThreadPool::RunTasks()
+{
+    for (size_t i = m_nextTask++; i < m_taskCount; i = m_nextTask++)
+    {
+        (*m_pTask)(i);
+    }
+}
+
+void ThreadPool::WorkerLoop(uint64_t generation)
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobCondition.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+            if (m_stop)
+            {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        RunTasks();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_activeWorkers;
+        }
+        m_doneCondition.notify_one();
+    }
+}
+
+void ThreadPool::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_jobCondition.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+} // namespace pegasus
@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#include <pegasus/WideContactSolver.hpp>
+#include <pegasus/CollisionResolver.hpp>
+#include "ContactKernel.hpp"
+
+#if defined(PEGASUS_SIMD_X86_64) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef PEGASUS_SIMD_X86_64
+namespace
+{
+
+/**
+ * @brief Checks whether the CPU and the OS support AVX2 instructions
+ */
+bool IsAvx2Supported()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    __cpuid(info, 1);
+    bool const osxsave = (info[2] & (1 << 27)) != 0;
+    bool const avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+} // namespace
+#endif
+
+namespace pegasus
+{
+namespace collision
+{
+namespace
+{
+
+/**
+ * @brief Copies contact and body data into the lanes buffer
+ * @param[in]  solverBodies solver bodies
+ * @param[in]  contacts     contacts
+ * @param[in]  indices      indices of the lane contacts
+ * @param[in]  width        number of lanes
+ * @param[in]  settings     solver pass parameters
+ * @param[out] lanes        lanes buffer
+ */
+void GatherContactLanes(
+    SolverBodies const& solverBodies, std::vector<Contact> const& contacts, uint32_t const* indices, uint32_t width,
+    ContactSolverSettings const& settings, float* lanes
+)
+{
+    for (uint32_t lane = 0; lane < width; ++lane)
+    {
+        Contact const& contact = contacts[indices[lane]];
+        SolverBody const& aBody = solverBodies.bodies[contact.aSolverBody];
+        SolverBody const& bBody = solverBodies.bodies[contact.bSolverBody];
+
+        auto const set = [lanes, width, lane](uint32_t row, float value) {
+            lanes[row * width + lane] = value;
+        };
+        auto const set3 = [&set](uint32_t row, glm::vec3 const& value) {
+            set(row, value.x);
+            set(row + 1, value.y);
+            set(row + 2, value.z);
+        };
+        auto const set6 = [&set](uint32_t row, mechanics::SymmetricMatrix3 const& value) {
+            set(row, value.xx);
+            set(row + 1, value.xy);
+            set(row + 2, value.xz);
+            set(row + 3, value.yy);
+            set(row + 4, value.yz);
+            set(row + 5, value.zz);
+        };
+
+        set3(kernel::NORMAL_X, contact.manifold.normal);
+        set3(kernel::FIRST_TANGENT_X, contact.manifold.firstTangent);
+        set3(kernel::SECOND_TANGENT_X, contact.manifold.secondTangent);
+        set3(kernel::A_RELATIVE_POSITION_X, contact.aRelativePosition);
+        set3(kernel::B_RELATIVE_POSITION_X, contact.bRelativePosition);
+        set(kernel::PENETRATION, contact.manifold.penetration);
+        set(kernel::RESTITUTION_SPEED, contact.restitutionSpeed);
+        set(kernel::FRICTION, contact.friction);
+        set(kernel::LAGRANGIAN_MULTIPLIER, contact.lagrangianMultiplier * settings.warmStartFactor);
+        set(kernel::TANGENT_LAGRANGIAN_MULTIPLIER_1, contact.tangentLagrangianMultiplier1 * settings.warmStartFactor);
+        set(kernel::TANGENT_LAGRANGIAN_MULTIPLIER_2, contact.tangentLagrangianMultiplier2 * settings.warmStartFactor);
+        set3(kernel::A_LINEAR_VELOCITY_X, aBody.linearVelocity);
+        set3(kernel::A_ANGULAR_VELOCITY_X, aBody.angularVelocity);
+        set3(kernel::B_LINEAR_VELOCITY_X, bBody.linearVelocity);
+        set3(kernel::B_ANGULAR_VELOCITY_X, bBody.angularVelocity);
+        set(kernel::A_INVERSE_MASS, aBody.inverseMass);
+        set(kernel::B_INVERSE_MASS, bBody.inverseMass);
+        set6(kernel::A_INVERSE_INERTIA, aBody.inverseInertia);
+        set6(kernel::B_INVERSE_INERTIA, bBody.inverseInertia);
+    }
+}
+
+/**
+ * @brief Copies solved lanes back into the contacts and the bodies with a finite mass
+ * @param[in,out] solverBodies solver bodies
+ * @param[in,out] contacts     contacts
+ * @param[in]     indices      indices of the lane contacts
+ * @param[in]     width        number of lanes
+ * @param[in]     lanes        lanes buffer
+ */
+void ScatterContactLanes(
+    SolverBodies& solverBodies, std::vector<Contact>& contacts, uint32_t const* indices, uint32_t width,
+    float const* lanes
+)
+{
+    for (uint32_t lane = 0; lane < width; ++lane)
+    {
+        Contact& contact = contacts[indices[lane]];
+        SolverBody& aBody = solverBodies.bodies[contact.aSolverBody];
+        SolverBody& bBody = solverBodies.bodies[contact.bSolverBody];
+
+        auto const get = [lanes, width, lane](uint32_t row) {
+            return lanes[row * width + lane];
+        };
+        auto const get3 = [&get](uint32_t row) {
+            return glm::vec3(get(row), get(row + 1), get(row + 2));
+        };
+
+        contact.manifold.firstTangent = get3(kernel::FIRST_TANGENT_X);
+        contact.manifold.secondTangent = get3(kernel::SECOND_TANGENT_X);
+        contact.lagrangianMultiplier = get(kernel::LAGRANGIAN_MULTIPLIER);
+        contact.tangentLagrangianMultiplier1 = get(kernel::TANGENT_LAGRANGIAN_MULTIPLIER_1);
+        contact.tangentLagrangianMultiplier2 = get(kernel::TANGENT_LAGRANGIAN_MULTIPLIER_2);
+
+        //Bodies with an infinite mass may be shared between lanes and must stay untouched
+        if (aBody.inverseMass != 0)
+        {
+            aBody.linearVelocity = get3(kernel::A_LINEAR_VELOCITY_X);
+            aBody.angularVelocity = get3(kernel::A_ANGULAR_VELOCITY_X);
+        }
+        if (bBody.inverseMass != 0)
+        {
+            bBody.linearVelocity = get3(kernel::B_LINEAR_VELOCITY_X);
+            bBody.angularVelocity = get3(kernel::B_ANGULAR_VELOCITY_X);
+        }
+    }
+}
+
+/**
+ * @brief Solves contacts in groups of the pack width
+ * @return number of solved contacts
+ */
+template < typename SolveLanes >
+uint32_t SolveContactGroups(
+    SolverBodies& solverBodies, std::vector<Contact>& contacts, uint32_t const* indices, uint32_t count,
+    ContactSolverSettings const& settings, uint32_t width, SolveLanes solveLanes
+)
+{
+    alignas(32) float lanes[kernel::CONTACT_LANE_COUNT * kernel::MAX_CONTACT_LANE_WIDTH];
+    kernel::ContactLaneParameters const parameters{
+        settings.duration, settings.impulseFactor, settings.baumgarteFactor, epona::fp::g_floatingPointThreshold
+    };
+
+    uint32_t solved = 0;
+    for (; solved + width <= count; solved += width)
+    {
+        GatherContactLanes(solverBodies, contacts, indices + solved, width, settings, lanes);
+        solveLanes(lanes, parameters);
+        ScatterContactLanes(solverBodies, contacts, indices + solved, width, lanes);
+    }
+
+    return solved;
+}
+
+} // namespace
+
+SimdInstructionSet DetectSimdInstructionSet()
+{
+#ifdef PEGASUS_SIMD_X86_64
+    static SimdInstructionSet const instructionSet =
+        kernel::HasAvx2ContactKernel() && IsAvx2Supported() ? SimdInstructionSet::AVX2 : SimdInstructionSet::SSE;
+    return instructionSet;
+#else
+    return SimdInstructionSet::NONE;
+#endif
+}
+
+void SolveContactBatch(
+    SolverBodies& solverBodies, std::vector<Contact>& contacts,
+    uint32_t const* indices, uint32_t count,
+    ContactSolverSettings const& settings, SimdInstructionSet instructionSet
+)
+{
+    uint32_t solved = 0;
+
+#ifdef PEGASUS_SIMD_X86_64
+    if (instructionSet == SimdInstructionSet::AVX2)
+    {
+        solved += SolveContactGroups(solverBodies, contacts, indices, count, settings, 8,
+            kernel::SolveContactLanesAvx2);
+    }
+    if (instructionSet != SimdInstructionSet::NONE)
+    {
+        solved += SolveContactGroups(solverBodies, contacts, indices + solved, count - solved, settings,
+            simd::SsePack::WIDTH, kernel::SolveContactLanes<simd::SsePack>);
+    }
+#endif
+
+    for (; solved < count; ++solved)
+    {
+        SolveContact(solverBodies, contacts[indices[solved]], settings);
+    }
+}
+
+} // namespace collision
+} // namespace pegasus
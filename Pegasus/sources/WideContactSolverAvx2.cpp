@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#include "ContactKernel.hpp"
+
+#if defined(PEGASUS_SIMD_X86_64) && defined(__AVX2__)
+
+namespace pegasus
+{
+namespace collision
+{
+namespace kernel
+{
+
+bool HasAvx2ContactKernel()
+{
+    return true;
+}
+
+void SolveContactLanesAvx2(float* lanes, ContactLaneParameters const& parameters)
+{
+    SolveContactLanes<simd::Avx2Pack>(lanes, parameters);
+}
+
+} // namespace kernel
+} // namespace collision
+} // namespace pegasus
+
+#else
+
+namespace pegasus
+{
+namespace collision
+{
+namespace kernel
+{
+
+bool HasAvx2ContactKernel()
+{
+    return false;
+}
+
+void SolveContactLanesAvx2(float*, ContactLaneParameters const&)
+{
+}
+
+} // namespace kernel
+} // namespace collision
+} // namespace pegasus
+
+#endif
@@ -525,26 +525,18 @@ void Demo::ComputeFrame(float duration)
 {
     //Compute physical data
     duration = useStaticDuration ? staticDuration : duration;
-    if (duration > physicsTick)
-    {
-        for (uint16_t i = 0; i < (duration / physicsTick); ++i)
-        {
-            m_scene.ComputeFrame(physicsTick);
-        }
-    }
-    else
-    {
-        m_scene.ComputeFrame(duration);
-    }
+    m_scene.fixedStepDuration = physicsTick;
+    m_scene.Step(duration);
 
     //Update render data
     for (Primitive& primitive : m_primitives)
     {
         if (primitive.physicalPrimitive != nullptr)
         {
-            mechanics::Body const physicalBody = primitive.physicalPrimitive->GetBody();
-            glm::mat4 const model = glm::translate(glm::mat4(1), glm::vec3(physicalBody.linearMotion.position))
-                * glm::mat4(glm::toMat4(physicalBody.angularMotion.orientation));
+            scene::BodyTransform const transform
+                = m_scene.GetInterpolatedTransform(primitive.physicalPrimitive->GetBodyHandle());
+            glm::mat4 const model = glm::translate(glm::mat4(1), glm::vec3(transform.position))
+                * glm::mat4(glm::toMat4(transform.orientation));
             primitive.renderPrimitive->SetModel(model);
         }
     }
@@ -573,7 +565,6 @@ Demo::Primitive& Demo::MakePlane(mechanics::Body body, glm::vec3 normal, scene::
         * glm::mat4(glm::toMat4(body.angularMotion.orientation)) };
     render::Primitive* shape = new render::Plane(model, glm::vec3(0.82f, 0.82f, 0.82f),  normal);
     m_primitives.emplace_back(object, shape);
-    m_pGravityForce->Bind(*object);
 
     return m_primitives.back();
 }
@@ -597,8 +588,6 @@ Demo::Primitive& Demo::MakeSphere(mechanics::Body body, float radius, scene::Pri
         * glm::mat4(glm::toMat4(body.angularMotion.orientation)) };
     render::Primitive* shape = new render::Sphere(model, glm::vec3(0.667f, 0.223f, 0.223f), radius);
     m_primitives.emplace_back(object, shape);
-    m_pGravityForce->Bind(*object);
-    m_pDragForce->Bind(*object);
 
     return m_primitives.back();
 }
@@ -625,8 +614,6 @@ Demo::Primitive& Demo::MakeBox(
         * glm::mat4(glm::toMat4(body.angularMotion.orientation)) };
     render::Primitive* shape = new render::Box(model, glm::vec3(0.667f, 0.223f, 0.223f), render::Box::Axes{i, j, k});
     m_primitives.emplace_back(object, shape);
-    m_pGravityForce->Bind(*object);
-    m_pDragForce->Bind(*object);
 
     return m_primitives.back();
 }
@@ -643,11 +630,6 @@ Demo::Primitive& Demo::MakeTriangleCollection(mechanics::Body body, glm::vec3 co
 
 void Demo::Remove(Primitive& primitive)
 {
-    if (primitive.physicalPrimitive)
-    {
-        m_pGravityForce->Unbind(*primitive.physicalPrimitive);
-    }
-
     m_primitives.remove_if([&primitive](Primitive& p) { return &primitive == &p; });
 }
 
@@ -674,8 +656,11 @@ Demo::Demo()
 
     m_renderer.drawUiCallback = ::DrawUi;
 
-    m_pGravityForce = std::make_unique<scene::Force<force::StaticField>>(m_scene, force::StaticField(glm::vec3{ 0, -9.8f, 0 }));
-    m_pDragForce = std::make_unique<scene::Force<force::Drag>>(m_scene, force::Drag(0.01f, 0.05f));
+    m_globalField = m_scene.MakeForce<force::GlobalField>();
+    force::GlobalField& field = m_scene.GetForce<force::GlobalField>(m_globalField);
+    field.acceleration = glm::vec3{ 0, -9.8f, 0 };
+    field.linearDrag = 0.01f;
+    field.quadraticDrag = 0.05f;
 }
 
 } // namespace pegasus
@@ -193,8 +193,7 @@ private:
     scene::Scene m_scene;
     render::Renderer& m_renderer;
     std::list<Primitive> m_primitives;
-    std::unique_ptr<scene::Force<force::StaticField>> m_pGravityForce;
-    std::unique_ptr<scene::Force<force::Drag>> m_pDragForce;
+    scene::Handle m_globalField;
 
     Demo();
 
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <pegasus/Scene.hpp>
+
+#include <cmath>
+#include <vector>
+
+TEST_CASE("Revolute link swings with the pendulum period", "[articulation]")
+{
+    pegasus::scene::Scene scene;
+
+    pegasus::scene::Handle const gravity = scene.MakeForce<pegasus::force::StaticField>();
+    scene.GetForce<pegasus::force::StaticField>(gravity) = pegasus::force::StaticField(glm::vec3(0, -9.8f, 0));
+
+    pegasus::scene::Handle const base = scene.MakeBody();
+    scene.GetBody(base).material.SetInfiniteMass();
+
+    pegasus::scene::Handle const bob = scene.MakeBody();
+    scene.GetBody(bob).linearMotion.position = glm::vec3(0, -1, 0);
+    scene.GetBody(bob).material.SetMomentOfInertia(glm::mat3(1e-4f));
+    scene.BindForce<pegasus::force::StaticField>(bob, gravity);
+
+    pegasus::scene::Handle const articulation = scene.MakeArticulation(base);
+    scene.AddRevoluteLink(articulation, pegasus::mechanics::ARTICULATION_BASE, bob, glm::vec3(0), glm::vec3(0, 0, 1));
+    scene.GetArticulation(articulation).damping = 0.0f;
+    scene.GetArticulation(articulation).links[0].angle = 0.1f;
+
+    float const duration = 1.0f / 600.0f;
+    float previousAngle = 0.1f;
+    std::vector<float> crossings;
+    for (uint32_t i = 0; i < 2000; ++i)
+    {
+        scene.ComputeFrame(duration);
+
+        float const angle = scene.GetArticulation(articulation).links[0].angle;
+        if (previousAngle > 0.0f && angle <= 0.0f)
+        {
+            crossings.push_back(i * duration);
+        }
+        previousAngle = angle;
+    }
+
+    REQUIRE(crossings.size() >= 2);
+    REQUIRE(crossings[1] - crossings[0] == Approx(2.0f * 3.14159265f * std::sqrt(1.0f / 9.8f)).epsilon(0.01f));
+    REQUIRE(glm::length(scene.GetBody(bob).linearMotion.position) == Approx(1.0f).epsilon(1e-4f));
+}
+
+TEST_CASE("Long chain stays connected and settles", "[articulation]")
+{
+    pegasus::scene::Scene scene;
+
+    pegasus::scene::Handle const gravity = scene.MakeForce<pegasus::force::StaticField>();
+    scene.GetForce<pegasus::force::StaticField>(gravity) = pegasus::force::StaticField(glm::vec3(0, -9.8f, 0));
+
+    pegasus::scene::Handle const base = scene.MakeBody();
+    scene.GetBody(base).material.SetInfiniteMass();
+
+    uint32_t const linkCount = 50;
+    float const linkLength = 0.2f;
+    pegasus::scene::Handle const articulation = scene.MakeArticulation(base);
+    std::vector<pegasus::scene::Handle> links;
+    uint32_t parent = pegasus::mechanics::ARTICULATION_BASE;
+    for (uint32_t i = 0; i < linkCount; ++i)
+    {
+        pegasus::scene::Handle const link = scene.MakeBody();
+        pegasus::mechanics::Body& body = scene.GetBody(link);
+        body.linearMotion.position = glm::vec3(linkLength * (i + 0.5f), 0, 0);
+        body.material.SetMass(0.1f);
+        body.material.SetMomentOfInertia(glm::mat3(0.1f * linkLength * linkLength / 12.0f));
+        scene.BindForce<pegasus::force::StaticField>(link, gravity);
+
+        parent = scene.AddRevoluteLink(articulation, parent, link, glm::vec3(linkLength * i, 0, 0), glm::vec3(0, 0, 1));
+        links.push_back(link);
+    }
+
+    for (uint32_t i = 0; i < 1200; ++i)
+    {
+        scene.ComputeFrame(1.0f / 60.0f);
+    }
+
+    for (uint32_t i = 1; i < linkCount; ++i)
+    {
+        pegasus::mechanics::Body const& a = scene.GetBody(links[i - 1]);
+        pegasus::mechanics::Body const& b = scene.GetBody(links[i]);
+        glm::vec3 const aEnd = a.linearMotion.position + a.angularMotion.orientation * glm::vec3(linkLength * 0.5f, 0, 0);
+        glm::vec3 const bStart = b.linearMotion.position - b.angularMotion.orientation * glm::vec3(linkLength * 0.5f, 0, 0);
+        REQUIRE(glm::distance(aEnd, bStart) < 1e-3f);
+    }
+
+    pegasus::mechanics::Body const& end = scene.GetBody(links.back());
+    REQUIRE(end.linearMotion.position.y == Approx(-linkLength * (linkCount - 0.5f)).epsilon(0.01f));
+    REQUIRE(glm::length(end.linearMotion.velocity) < 0.1f);
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <pegasus/AttractorTree.hpp>
+#include <random>
+
+TEST_CASE("Barnes-Hut field follows the direct sum", "[attractor]")
+{
+    uint32_t const count = 2000;
+    float const softening = 0.01f;
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> distribution(-20.0f, 20.0f);
+
+    std::vector<pegasus::force::Attractor> attractors;
+    pegasus::force::AttractorTree tree;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        pegasus::force::Attractor const attractor{
+            glm::vec3(distribution(generator), distribution(generator), distribution(generator)), 1.0f + (i % 3), i
+        };
+        attractors.push_back(attractor);
+        tree.Add(attractor);
+    }
+    tree.Build();
+
+    std::vector<glm::vec3> fields(count, glm::vec3(0));
+    tree.AddGroupFields(0, tree.GetGroupCount(), 0.5f, softening, fields);
+
+    for (uint32_t i = 0; i < count; i += 97)
+    {
+        glm::vec3 expected(0);
+        for (pegasus::force::Attractor const& source : attractors)
+        {
+            glm::vec3 const direction = source.position - attractors[i].position;
+            float const distanceSq = glm::dot(direction, direction) + softening * softening;
+            expected += direction * (source.strength / (distanceSq * glm::sqrt(distanceSq)));
+        }
+
+        glm::vec3 const point = tree.CalculateField(attractors[i].position, i, 0.5f, softening);
+        REQUIRE(glm::length(fields[i] - expected) < 0.02f * glm::length(expected));
+        REQUIRE(glm::length(point - expected) < 0.02f * glm::length(expected));
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <pegasus/Scene.hpp>
+
+namespace
+{
+
+//!Pushes bodies around the vertical axis
+struct Vortex
+{
+    glm::vec3 CalculateForce(pegasus::mechanics::Body const& body) const
+    {
+        return glm::cross(glm::vec3(0, strength, 0), body.linearMotion.position);
+    }
+
+    float strength = 1.0f;
+};
+
+//!Pushes all bound bodies away from their common center and spins them
+struct Explosion
+{
+    void CalculateForces(
+        pegasus::mechanics::Body const* const* bodies, glm::vec3* forces, glm::vec3* torques, size_t count
+    ) const
+    {
+        glm::vec3 center(0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            center += bodies[i]->linearMotion.position / static_cast<float>(count);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            forces[i] = (bodies[i]->linearMotion.position - center) * strength;
+            torques[i] = glm::vec3(0, strength, 0);
+        }
+    }
+
+    float strength = 1.0f;
+};
+
+//!Pushes bodies along the x axis
+struct Breeze
+{
+    glm::vec3 CalculateForce(pegasus::mechanics::Body const&) const
+    {
+        return glm::vec3(strength, 0, 0);
+    }
+
+    float strength = 1.0f;
+};
+
+pegasus::scene::Handle MakeBody(pegasus::scene::Scene& scene, glm::vec3 position)
+{
+    pegasus::scene::Handle const handle = scene.MakeBody();
+    scene.GetBody(handle).linearMotion.position = position;
+    return handle;
+}
+
+} // namespace ::
+
+TEST_CASE("User force types are applied to the bound bodies", "[force]")
+{
+    pegasus::scene::Scene scene;
+    scene.sleepingEnabled = false;
+
+    uint32_t const vortexType = scene.RegisterForce<Vortex>();
+    uint32_t const explosionType = scene.RegisterForce<Explosion>();
+    REQUIRE(explosionType == vortexType + 1);
+    REQUIRE(scene.RegisterForce<Vortex>() == vortexType);
+
+    pegasus::scene::Handle const a = MakeBody(scene, glm::vec3(1, 0, 0));
+    pegasus::scene::Handle const b = MakeBody(scene, glm::vec3(-1, 0, 0));
+    pegasus::scene::Handle const c = MakeBody(scene, glm::vec3(0, 0, 2));
+
+    pegasus::scene::Handle const vortex = scene.MakeForce<Vortex>();
+    scene.BindForce<Vortex>(c, vortex);
+
+    pegasus::scene::Handle const explosion = scene.MakeForce<Explosion>();
+    scene.GetForce<Explosion>(explosion).strength = 10.0f;
+    scene.BindForce<Explosion>(a, explosion);
+    scene.BindForce<Explosion>(b, explosion);
+
+    scene.GetAssets().PushFrame();
+    scene.ComputeFrame(0.1f);
+
+    REQUIRE(scene.GetBody(a).linearMotion.velocity.x == Approx(1.0f));
+    REQUIRE(scene.GetBody(b).linearMotion.velocity.x == Approx(-1.0f));
+    REQUIRE(scene.GetBody(b).angularMotion.velocity.y == Approx(1.0f));
+    REQUIRE(scene.GetBody(c).linearMotion.velocity.x == Approx(0.2f));
+    REQUIRE(scene.GetBody(c).linearMotion.velocity.z == Approx(0.0f));
+
+    //Restored frame keeps its own copy of the user forces and binds
+    scene.GetForce<Explosion>(explosion).strength = 0.0f;
+    scene.GetAssets().Top();
+    REQUIRE(scene.GetForce<Explosion>(explosion).strength == Approx(10.0f));
+    REQUIRE(scene.GetAssets().GetForceBinds<Explosion>().size() == 2);
+}
+
+TEST_CASE("User force types are registered on the first use", "[force]")
+{
+    pegasus::scene::Scene scene;
+    scene.sleepingEnabled = false;
+
+    pegasus::scene::Handle const body = MakeBody(scene, glm::vec3(0));
+    pegasus::scene::Handle const breeze = scene.MakeForce<Breeze>();
+    scene.BindForce<Breeze>(body, breeze);
+
+    REQUIRE(scene.RegisterForce<Breeze>() == scene.GetAssets().GetForceRegistry().GetTypeIndex<Breeze>());
+    REQUIRE(scene.GetAssets().GetForceRegistry().GetTypeIndex<Vortex>() == pegasus::scene::INVALID_FORCE_TYPE);
+
+    scene.ComputeFrame(0.1f);
+    REQUIRE(scene.GetBody(body).linearMotion.velocity.x == Approx(0.1f));
+}
+
+TEST_CASE("Global fields apply to the bodies of their groups", "[force]")
+{
+    pegasus::scene::Scene scene;
+
+    pegasus::scene::Handle const first = MakeBody(scene, glm::vec3(0));
+    pegasus::scene::Handle const second = MakeBody(scene, glm::vec3(2, 0, 0));
+    scene.GetBody(second).groups = 2;
+
+    pegasus::scene::Handle const gravity = scene.MakeForce<pegasus::force::GlobalField>();
+    scene.GetForce<pegasus::force::GlobalField>(gravity).acceleration = glm::vec3(0, -10, 0);
+    scene.GetForce<pegasus::force::GlobalField>(gravity).groupMask = 2;
+
+    pegasus::scene::Handle const wind = scene.MakeForce<pegasus::force::GlobalField>();
+    scene.GetForce<pegasus::force::GlobalField>(wind).flowVelocity = glm::vec3(1, 0, 0);
+    scene.GetForce<pegasus::force::GlobalField>(wind).linearDrag = 2.0f;
+    scene.GetForce<pegasus::force::GlobalField>(wind).groupMask = 1;
+
+    scene.ComputeFrame(0.1f);
+
+    //Only the masked group falls, only the other one is pushed by the flow
+    REQUIRE(scene.GetBody(first).linearMotion.velocity.y == Approx(0.0f));
+    REQUIRE(scene.GetBody(first).linearMotion.velocity.x == Approx(0.2f));
+    REQUIRE(scene.GetBody(second).linearMotion.velocity.y == Approx(-1.0f));
+    REQUIRE(scene.GetBody(second).linearMotion.velocity.x == Approx(0.0f));
+
+    //Sleeping bodies of the groups of an edited field are woken up
+    scene.GetBody(second).asleep = true;
+    scene.ComputeFrame(0.1f);
+    REQUIRE(scene.GetBody(second).asleep);
+    REQUIRE(scene.GetBody(second).linearMotion.velocity.y == Approx(-1.0f));
+
+    scene.GetForce<pegasus::force::GlobalField>(gravity).acceleration = glm::vec3(0, -20, 0);
+    scene.ComputeFrame(0.1f);
+    REQUIRE_FALSE(scene.GetBody(second).asleep);
+    REQUIRE(scene.GetBody(second).linearMotion.velocity.y == Approx(-3.0f));
+}
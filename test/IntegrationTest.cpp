@@ -8,9 +8,13 @@
 
 #include <pegasus/Body.hpp>
 #include <pegasus/Integration.hpp>
+#include <pegasus/WideContactSolver.hpp>
 #include <Epona/FloatingPoint.hpp>
 #include <glm/glm.hpp>
 
+#include <cmath>
+#include <vector>
+
 TEST_CASE("Integration", "[integration]")
 {
     glm::vec3 const force = pegasus::integration::IntegrateForce({0, 0, 0}, {1, 1, 1});
@@ -33,3 +37,142 @@ TEST_CASE("Angular integration torque", "[integration]")
         true == epona::fp::IsZero(glm::distance(body.angularMotion.velocity, torque))
     );
 }
+
+TEST_CASE("Wide integration matches the single body one", "[integration]")
+{
+    using pegasus::collision::SimdInstructionSet;
+
+    //Odd count leaves a remainder for the narrower packs
+    uint32_t const count = 27;
+    std::vector<pegasus::mechanics::Body> expected(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        pegasus::mechanics::Body& body = expected[i];
+        body.linearMotion.velocity = glm::vec3(std::sin(i * 1.1f), std::sin(i * 2.3f), std::sin(i * 0.7f)) * (i * 10.0f);
+        body.linearMotion.force = glm::vec3(0, -9.8f, std::sin(i * 0.4f));
+        body.angularMotion.velocity = glm::vec3(std::sin(i * 0.3f), std::sin(i * 1.9f), 1e-5f) * 3.0f;
+        body.angularMotion.torque = glm::vec3(std::sin(i * 1.3f), 1.0f, 0.0f);
+        body.material.damping = (i % 3) ? 0.9f : 0.5f;
+        body.material.SetMomentOfInertia(pegasus::mechanics::CalculateSolidCuboidMomentOfInertia(1, 2, 3, 1.0f + i));
+        pegasus::mechanics::UpdateInverseInertia(body);
+    }
+    std::vector<pegasus::mechanics::Body> const initial = expected;
+    for (pegasus::mechanics::Body& body : expected)
+    {
+        pegasus::integration::Integrate(body, 0.016f);
+    }
+
+    for (SimdInstructionSet instructionSet : { SimdInstructionSet::NONE, SimdInstructionSet::SSE, SimdInstructionSet::AVX2 })
+    {
+        if (instructionSet > pegasus::collision::DetectSimdInstructionSet())
+        {
+            continue;
+        }
+
+        std::vector<pegasus::mechanics::Body> bodies = initial;
+        pegasus::integration::BodyMotions motions;
+        pegasus::integration::ResizeBodyMotions(motions, count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            pegasus::integration::LoadBodyMotion(motions, i, bodies[i]);
+        }
+        pegasus::integration::Integrate(
+            motions, 0.016f, pegasus::integration::Integrator::EXPLICIT_EULER, false, instructionSet
+        );
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            pegasus::integration::StoreBodyMotion(motions, i, bodies[i]);
+            REQUIRE(bodies[i].linearMotion.position == expected[i].linearMotion.position);
+            REQUIRE(bodies[i].linearMotion.velocity == expected[i].linearMotion.velocity);
+            REQUIRE(bodies[i].angularMotion.orientation == expected[i].angularMotion.orientation);
+            REQUIRE(bodies[i].angularMotion.velocity == expected[i].angularMotion.velocity);
+            REQUIRE(bodies[i].inverseInertia.xy == expected[i].inverseInertia.xy);
+            REQUIRE(bodies[i].inverseInertia.zz == expected[i].inverseInertia.zz);
+        }
+    }
+}
+
+TEST_CASE("Higher order integrators follow an oscillator closer", "[integration]")
+{
+    using pegasus::integration::Integrator;
+
+    //Unit spring and mass, the body returns to the start after one period
+    float const period = 6.2831853f;
+    uint32_t const steps = 40;
+    float const duration = period / steps;
+    auto const spring = [](pegasus::mechanics::Body& body) {
+        body.linearMotion.force = -body.linearMotion.position;
+        body.angularMotion.torque = glm::vec3(0);
+    };
+
+    float errors[4];
+    for (Integrator integrator : { Integrator::EXPLICIT_EULER, Integrator::SEMI_IMPLICIT_EULER,
+        Integrator::VELOCITY_VERLET, Integrator::RUNGE_KUTTA_4 })
+    {
+        pegasus::mechanics::Body body;
+        body.material.damping = 1.0f;
+        body.linearMotion.position = glm::vec3(0.5f, 0, 0);
+
+        pegasus::integration::BodyMotions motions;
+        pegasus::integration::ResizeBodyMotions(motions, 1);
+        for (uint32_t i = 0; i < steps; ++i)
+        {
+            glm::vec3 const positionForce = pegasus::integration::ApplyStageForces(integrator, body, duration, spring);
+            pegasus::integration::LoadBodyMotion(motions, 0, body, positionForce);
+            pegasus::integration::Integrate(
+                motions, duration, integrator, false, pegasus::collision::SimdInstructionSet::NONE
+            );
+            pegasus::integration::StoreBodyMotion(motions, 0, body);
+        }
+
+        errors[static_cast<uint32_t>(integrator)] = glm::distance(body.linearMotion.position, glm::vec3(0.5f, 0, 0));
+    }
+
+    REQUIRE(errors[1] < errors[0]);
+    REQUIRE(errors[2] < errors[1]);
+    REQUIRE(errors[3] < errors[2]);
+}
+
+TEST_CASE("Gyroscopic torque is stable and keeps the angular momentum", "[integration]")
+{
+    using pegasus::mechanics::Body;
+
+    Body initial;
+    initial.material.damping = 1.0f;
+    initial.material.SetMomentOfInertia(pegasus::mechanics::CalculateSolidCuboidMomentOfInertia(0.2f, 1.0f, 3.0f, 1.0f));
+    initial.angularMotion.velocity = glm::vec3(10.0f, 10.0f, 0.0f);
+    pegasus::mechanics::UpdateInverseInertia(initial);
+
+    auto const spin = [&initial](float duration, uint32_t steps) {
+        Body body = initial;
+        pegasus::integration::BodyMotions motions;
+        pegasus::integration::ResizeBodyMotions(motions, 1);
+        for (uint32_t i = 0; i < steps; ++i)
+        {
+            pegasus::integration::LoadBodyMotion(motions, 0, body);
+            pegasus::integration::Integrate(
+                motions, duration, pegasus::integration::Integrator::EXPLICIT_EULER, true,
+                pegasus::collision::SimdInstructionSet::NONE
+            );
+            pegasus::integration::StoreBodyMotion(motions, 0, body);
+        }
+        return body;
+    };
+    auto const momentum = [](Body const& body) {
+        return pegasus::mechanics::RotateInertia(body.angularMotion.orientation, body.material.GetMomentOfInertia())
+            * body.angularMotion.velocity;
+    };
+    auto const energy = [&momentum](Body const& body) {
+        return glm::dot(momentum(body), body.angularMotion.velocity) * 0.5f;
+    };
+
+    //Spinning around a non principal axis at 60 Hz loses energy instead of gaining it
+    Body const coarse = spin(1.0f / 60.0f, 600);
+    REQUIRE(energy(coarse) <= energy(initial));
+    REQUIRE(energy(coarse) > 0.0f);
+
+    //Small steps converge to the conserved angular momentum
+    Body const fine = spin(1e-4f, 5000);
+    REQUIRE(glm::distance(momentum(fine), momentum(initial)) < 0.01f * glm::length(momentum(initial)));
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <pegasus/CollisionResolver.hpp>
+#include <pegasus/Island.hpp>
+
+namespace
+{
+
+pegasus::collision::Contact MakeContact(uint32_t a, uint32_t b)
+{
+    pegasus::collision::Contact contact(a + 1, b + 1, {}, 0, 0);
+    contact.aSolverBody = a;
+    contact.bSolverBody = b;
+    return contact;
+}
+
+} // namespace ::
+
+TEST_CASE("Islands are split by static bodies", "[island]")
+{
+    pegasus::collision::SolverBodies solverBodies;
+    solverBodies.bodies.resize(5);
+    for (pegasus::collision::SolverBody& body : solverBodies.bodies)
+    {
+        body.inverseMass = 1.0f;
+    }
+    solverBodies.bodies[2].inverseMass = 0.0f;
+
+    std::vector<pegasus::collision::Contact> contacts{
+        MakeContact(0, 1), MakeContact(1, 2), MakeContact(2, 3), MakeContact(3, 4)
+    };
+
+    pegasus::collision::Islands islands;
+    pegasus::collision::BuildIslands(solverBodies, contacts, islands);
+
+    REQUIRE(islands.islands.size() == 2);
+    REQUIRE(islands.bodyIslands[2] == pegasus::collision::INVALID_ISLAND);
+    REQUIRE(islands.bodyIslands[0] == islands.bodyIslands[1]);
+    REQUIRE(islands.bodyIslands[3] == islands.bodyIslands[4]);
+    REQUIRE(islands.bodyIslands[0] != islands.bodyIslands[3]);
+
+    for (pegasus::collision::Island const& island : islands.islands)
+    {
+        REQUIRE(island.bodyCount == 2);
+        REQUIRE(island.contactCount == 2);
+    }
+}
+
+TEST_CASE("Island iterations follow the distance to a static body", "[island]")
+{
+    pegasus::collision::SolverData solver;
+    solver.adaptiveIterations = true;
+    solver.bodies.bodies.resize(6);
+    for (uint32_t i = 0; i < solver.bodies.bodies.size(); ++i)
+    {
+        solver.bodies.bodies[i].inverseMass = 1.0f;
+        solver.bodies.handles.push_back(i + 1);
+    }
+    solver.bodies.bodies[2].inverseMass = 0.0f;
+
+    std::vector<pegasus::collision::Contact> contacts{
+        MakeContact(0, 1), MakeContact(1, 2), MakeContact(2, 3), MakeContact(3, 4), MakeContact(4, 5)
+    };
+    pegasus::collision::BuildContactOrder(solver, contacts);
+
+    uint32_t const shallow = solver.islands.bodyIslands[0];
+    uint32_t const deep = solver.islands.bodyIslands[5];
+
+    REQUIRE(pegasus::collision::PlanIslandIterations(solver, contacts) == 5);
+    REQUIRE(solver.islandIterations.iterations[shallow] == 3);
+    REQUIRE(solver.islandIterations.iterations[deep] == 5);
+
+    solver.iterationBudget = 10;
+    REQUIRE(pegasus::collision::PlanIslandIterations(solver, contacts) == 2);
+    REQUIRE(solver.islandIterations.iterations[shallow] == 1);
+    REQUIRE(solver.islandIterations.iterations[deep] == 2);
+
+    solver.islandIterations.residuals.assign(solver.islands.islands.size(), 0.5f);
+    pegasus::collision::StoreIslandResiduals(solver);
+    REQUIRE(solver.islandIterations.bodyResiduals[5] == 0.5f);
+
+    //Bodies that left all islands forget their residuals
+    solver.bodies.bodies.pop_back();
+    solver.bodies.handles.pop_back();
+    contacts.pop_back();
+    pegasus::collision::BuildContactOrder(solver, contacts);
+    pegasus::collision::PlanIslandIterations(solver, contacts);
+    solver.islandIterations.residuals.assign(solver.islands.islands.size(), 0.25f);
+    pegasus::collision::StoreIslandResiduals(solver);
+    REQUIRE(solver.islandIterations.bodyResiduals[4] == 0.25f);
+    REQUIRE(solver.islandIterations.bodyResiduals[5] == 0.0f);
+}
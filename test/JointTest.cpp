@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <pegasus/Scene.hpp>
+
+namespace
+{
+
+pegasus::scene::Handle MakeBody(pegasus::scene::Scene& scene, glm::vec3 position, bool infiniteMass)
+{
+    pegasus::scene::Handle const handle = scene.MakeBody();
+    pegasus::mechanics::Body& body = scene.GetBody(handle);
+    body.linearMotion.position = position;
+    if (infiniteMass)
+    {
+        body.material.SetInfiniteMass();
+    }
+
+    return handle;
+}
+
+glm::vec3 GetAnchor(pegasus::scene::Scene& scene, pegasus::scene::Handle handle, glm::vec3 anchor)
+{
+    pegasus::mechanics::Body const& body = scene.GetBody(handle);
+    return body.linearMotion.position + body.angularMotion.orientation * anchor;
+}
+
+} // namespace ::
+
+TEST_CASE("Joints keep the anchor points together", "[joint]")
+{
+    pegasus::scene::Scene scene;
+    scene.sleepingEnabled = false;
+
+    pegasus::scene::Handle const gravity = scene.MakeForce<pegasus::force::StaticField>();
+    scene.GetForce<pegasus::force::StaticField>(gravity) = pegasus::force::StaticField(glm::vec3(0, -9.8f, 0));
+
+    pegasus::scene::Handle const anchor = MakeBody(scene, glm::vec3(0, 0, 0), true);
+    pegasus::scene::Handle const pendulum = MakeBody(scene, glm::vec3(1, 0, 0), false);
+    pegasus::scene::Handle const rod = MakeBody(scene, glm::vec3(0, 0, 3), false);
+    scene.BindForce<pegasus::force::StaticField>(pendulum, gravity);
+    scene.BindForce<pegasus::force::StaticField>(rod, gravity);
+
+    pegasus::scene::Handle const ballSocket = scene.MakeJoint(anchor, pendulum,
+        pegasus::joint::BallSocket(scene.GetBody(anchor), scene.GetBody(pendulum), glm::vec3(0, 0, 0)));
+    pegasus::scene::Handle const distance = scene.MakeJoint(anchor, rod,
+        pegasus::joint::Distance(scene.GetBody(anchor), scene.GetBody(rod), glm::vec3(0, 0, 2), glm::vec3(0, 0, 3)));
+
+    for (uint32_t i = 0; i < 120; ++i)
+    {
+        scene.ComputeFrame(1.0f / 60.0f);
+    }
+
+    pegasus::joint::BallSocket const& ballSocketJoint = scene.GetJoint<pegasus::joint::BallSocket>(ballSocket);
+    glm::vec3 const pivot = GetAnchor(scene, pendulum, ballSocketJoint.bAnchor);
+    REQUIRE(glm::length(pivot) < 0.05f);
+    REQUIRE(scene.GetBody(pendulum).linearMotion.position.y < -0.1f);
+
+    pegasus::joint::Distance const& distanceJoint = scene.GetJoint<pegasus::joint::Distance>(distance);
+    float const length = glm::distance(
+        GetAnchor(scene, anchor, distanceJoint.aAnchor), GetAnchor(scene, rod, distanceJoint.bAnchor)
+    );
+    REQUIRE(length == Approx(distanceJoint.distance).margin(0.05f));
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <pegasus/CollisionDetector.hpp>
+#include <pegasus/Primitives.hpp>
+#include <pegasus/Scene.hpp>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+/**
+ * @brief Makes a dynamic unit sphere at the given position
+ * @param scene     scene instance
+ * @param position  sphere center
+ * @return sphere primitive
+ */
+std::unique_ptr<pegasus::scene::Sphere> MakeSphere(pegasus::scene::Scene& scene, glm::vec3 position)
+{
+    pegasus::mechanics::Body body;
+    body.linearMotion.position = position;
+    body.material.SetMomentOfInertia(pegasus::mechanics::CalculateSolidSphereMomentOfInertia(0.5f, 1.0f));
+
+    return std::unique_ptr<pegasus::scene::Sphere>(new pegasus::scene::Sphere(
+        scene, pegasus::scene::Primitive::Type::DYNAMIC, body, arion::Sphere(position, {}, 0.5f)
+    ));
+}
+
+/**
+ * @brief Makes a static ground plane through the origin
+ * @param scene scene instance
+ * @return plane primitive
+ */
+std::unique_ptr<pegasus::scene::Plane> MakeGround(pegasus::scene::Scene& scene)
+{
+    return std::unique_ptr<pegasus::scene::Plane>(new pegasus::scene::Plane(
+        scene, pegasus::scene::Primitive::Type::STATIC, pegasus::mechanics::Body(), arion::Plane({}, {}, {0, 1, 0})
+    ));
+}
+
+/**
+ * @brief Computes frames until the body falls asleep
+ * @param scene     scene instance
+ * @param sphere    sphere primitive
+ * @return @c true if the body fell asleep within 10 seconds
+ */
+bool FallsAsleep(pegasus::scene::Scene& scene, pegasus::scene::Sphere const& sphere)
+{
+    for (uint32_t i = 0; i < 600 && !sphere.GetBody().asleep; ++i)
+    {
+        scene.ComputeFrame(1.0f / 60.0f);
+    }
+
+    return sphere.GetBody().asleep;
+}
+
+} // namespace ::
+
+TEST_CASE("Resting bodies fall asleep and wake up", "[scene]")
+{
+    pegasus::scene::Scene scene;
+    pegasus::scene::Force<pegasus::force::StaticField> gravity(scene, pegasus::force::StaticField(glm::vec3(0, -9.8f, 0)));
+
+    std::unique_ptr<pegasus::scene::Plane> ground = MakeGround(scene);
+    std::unique_ptr<pegasus::scene::Sphere> sphere = MakeSphere(scene, glm::vec3(0, 0.5f, 0));
+    gravity.Bind(*sphere);
+
+    SECTION("Sleeping bodies are stopped and skipped by the integration")
+    {
+        REQUIRE(FallsAsleep(scene, *sphere));
+        REQUIRE(glm::length(sphere->GetBody().linearMotion.velocity) == 0.0f);
+        REQUIRE(glm::length(sphere->GetBody().angularMotion.velocity) == 0.0f);
+
+        glm::vec3 const position = sphere->GetBody().linearMotion.position;
+        for (uint32_t i = 0; i < 60; ++i)
+        {
+            scene.ComputeFrame(1.0f / 60.0f);
+        }
+        REQUIRE(sphere->GetBody().asleep);
+        REQUIRE(sphere->GetBody().linearMotion.position == position);
+    }
+
+    SECTION("Impulses wake bodies up")
+    {
+        REQUIRE(FallsAsleep(scene, *sphere));
+
+        scene.ApplyImpulse(sphere->GetBodyHandle(), glm::vec3(1, 0, 0), sphere->GetBody().linearMotion.position);
+        REQUIRE_FALSE(sphere->GetBody().asleep);
+
+        scene.ComputeFrame(1.0f / 60.0f);
+        REQUIRE(sphere->GetBody().linearMotion.position.x > 0.0f);
+    }
+
+    SECTION("Awake bodies wake up the bodies they touch")
+    {
+        REQUIRE(FallsAsleep(scene, *sphere));
+
+        std::unique_ptr<pegasus::scene::Sphere> falling = MakeSphere(scene, glm::vec3(0, 2.0f, 0));
+        gravity.Bind(*falling);
+        for (uint32_t i = 0; i < 60 && sphere->GetBody().asleep; ++i)
+        {
+            scene.ComputeFrame(1.0f / 60.0f);
+        }
+        REQUIRE_FALSE(sphere->GetBody().asleep);
+    }
+
+    SECTION("Bodies wake up when their support is removed")
+    {
+        REQUIRE(FallsAsleep(scene, *sphere));
+
+        ground.reset();
+        scene.ComputeFrame(1.0f / 60.0f);
+        REQUIRE_FALSE(sphere->GetBody().asleep);
+
+        scene.ComputeFrame(1.0f / 60.0f);
+        REQUIRE(sphere->GetBody().linearMotion.position.y < 0.5f);
+    }
+}
+
+TEST_CASE("Sphere stack keeps its height without sub-steps", "[scene]")
+{
+    pegasus::scene::Scene scene;
+    scene.sleepingEnabled = false;
+    pegasus::scene::Force<pegasus::force::StaticField> gravity(scene, pegasus::force::StaticField(glm::vec3(0, -9.8f, 0)));
+
+    std::unique_ptr<pegasus::scene::Plane> ground = MakeGround(scene);
+    std::vector<std::unique_ptr<pegasus::scene::Sphere>> stack;
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        stack.push_back(MakeSphere(scene, glm::vec3(0, 0.5f + i, 0)));
+        gravity.Bind(*stack.back());
+    }
+
+    for (uint32_t i = 0; i < 60; ++i)
+    {
+        scene.ComputeFrame(1.0f / 60.0f);
+    }
+    float const height = stack.back()->GetBody().linearMotion.position.y;
+    REQUIRE(height > 5.4f);
+
+    for (uint32_t i = 0; i < 600; ++i)
+    {
+        scene.ComputeFrame(1.0f / 60.0f);
+    }
+    REQUIRE(stack.back()->GetBody().linearMotion.position.y == Approx(height).margin(1e-3f));
+    REQUIRE(std::abs(stack.back()->GetBody().linearMotion.position.x) < 1e-3f);
+}
+
+TEST_CASE("Fixed steps accumulate the real time", "[scene]")
+{
+    pegasus::scene::Scene scene;
+    scene.fixedStepDuration = 0.25f;
+    scene.maxFixedSteps = 4;
+
+    pegasus::scene::Handle const body = scene.MakeBody();
+    scene.GetBody(body).linearMotion.velocity = glm::vec3(1, 0, 0);
+
+    //The remainder is carried to the next call
+    REQUIRE(scene.Step(0.625f) == 2);
+    REQUIRE(scene.GetInterpolationAlpha() == Approx(0.5f));
+    REQUIRE(scene.GetPreviousTransform(body).position.x == Approx(0.25f));
+    REQUIRE(scene.GetCurrentTransform(body).position.x == Approx(0.5f));
+    REQUIRE(scene.GetInterpolatedTransform(body).position.x == Approx(0.375f));
+
+    REQUIRE(scene.Step(0.125f) == 1);
+    REQUIRE(scene.GetInterpolationAlpha() == Approx(0.0f).margin(1e-6f));
+    REQUIRE(scene.GetCurrentTransform(body).position.x == Approx(0.75f));
+    REQUIRE(scene.GetInterpolatedTransform(body).position.x == Approx(0.5f));
+
+    //Time beyond the step limit is dropped
+    REQUIRE(scene.Step(2.625f) == 4);
+    REQUIRE(scene.GetCurrentTransform(body).position.x == Approx(1.75f));
+    REQUIRE(scene.GetInterpolationAlpha() == Approx(0.5f));
+
+    for (uint32_t i = 0; i < 50; ++i)
+    {
+        scene.Step(0.01f + 0.07f * i);
+        REQUIRE(scene.GetInterpolationAlpha() >= 0.0f);
+        REQUIRE(scene.GetInterpolationAlpha() < 1.0f);
+    }
+}
+
+TEST_CASE("Kinematic bodies follow their velocities and carry dynamic bodies", "[scene]")
+{
+    pegasus::scene::Scene scene;
+    pegasus::scene::Force<pegasus::force::StaticField> gravity(scene, pegasus::force::StaticField(glm::vec3(0, -9.8f, 0)));
+
+    pegasus::mechanics::Body platformBody;
+    pegasus::scene::Box platform(scene, pegasus::scene::Primitive::Type::KINEMATIC, platformBody,
+        arion::Box(glm::vec3(0), {}, glm::vec3(2, 0, 0), glm::vec3(0, 0.5f, 0), glm::vec3(0, 0, 2))
+    );
+    gravity.Bind(platform);
+
+    std::unique_ptr<pegasus::scene::Sphere> sphere = MakeSphere(scene, glm::vec3(0, 1.0f, 0));
+    gravity.Bind(*sphere);
+
+    //Bound forces do not move kinematic bodies
+    REQUIRE(FallsAsleep(scene, *sphere));
+    REQUIRE(platform.GetBody().linearMotion.position == glm::vec3(0));
+
+    platformBody = platform.GetBody();
+    platformBody.linearMotion.velocity = glm::vec3(0, 1, 0);
+    platform.SetBody(platformBody);
+    for (uint32_t i = 0; i < 60; ++i)
+    {
+        scene.ComputeFrame(1.0f / 60.0f);
+    }
+
+    REQUIRE(platform.GetBody().linearMotion.position.y == Approx(1.0f));
+    REQUIRE(platform.GetBody().linearMotion.velocity == glm::vec3(0, 1, 0));
+    REQUIRE_FALSE(sphere->GetBody().asleep);
+    REQUIRE(sphere->GetBody().linearMotion.position.y == Approx(2.0f).margin(0.05f));
+    REQUIRE(sphere->GetBody().linearMotion.velocity.y == Approx(1.0f).margin(0.05f));
+}
+
+TEST_CASE("Kinematic bodies do not collide with kinematic and static bodies", "[scene]")
+{
+    pegasus::scene::Scene scene;
+    std::unique_ptr<pegasus::scene::Plane> ground = MakeGround(scene);
+
+    pegasus::mechanics::Body body;
+    body.linearMotion.position = glm::vec3(0, 0.25f, 0);
+    body.linearMotion.velocity = glm::vec3(1, 0, 0);
+    pegasus::scene::Sphere first(scene, pegasus::scene::Primitive::Type::KINEMATIC, body,
+        arion::Sphere(body.linearMotion.position, {}, 0.5f)
+    );
+
+    body.linearMotion.position = glm::vec3(0.5f, 0.25f, 0);
+    body.linearMotion.velocity = glm::vec3(-1, 0, 0);
+    pegasus::scene::Sphere second(scene, pegasus::scene::Primitive::Type::KINEMATIC, body,
+        arion::Sphere(body.linearMotion.position, {}, 0.5f)
+    );
+
+    REQUIRE(pegasus::collision::DetectContacts(scene.GetAssets()).empty());
+
+    scene.ComputeFrame(0.125f);
+    REQUIRE(first.GetBody().linearMotion.position == glm::vec3(0.125f, 0.25f, 0));
+    REQUIRE(second.GetBody().linearMotion.position == glm::vec3(0.375f, 0.25f, 0));
+    REQUIRE(pegasus::collision::DetectContacts(scene.GetAssets()).empty());
+}
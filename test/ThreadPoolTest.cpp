@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <pegasus/ThreadPool.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+/**
+ * @brief Runs a parallel loop and checks that every index ran exactly once before it returned
+ * @param pool thread pool
+ * @param count number of indices
+ * @return @c true if every index ran once
+ */
+bool RunsEachIndexOnce(pegasus::ThreadPool& pool, size_t count)
+{
+    std::vector<std::atomic<uint32_t>> runs(count);
+    for (std::atomic<uint32_t>& run : runs)
+    {
+        run = 0;
+    }
+
+    pool.ParallelFor(count, [&runs](size_t index) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        ++runs[index];
+    });
+
+    for (std::atomic<uint32_t> const& run : runs)
+    {
+        if (run != 1)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace ::
+
+TEST_CASE("Parallel loops finish after the thread count changes", "[thread_pool]")
+{
+    pegasus::ThreadPool pool;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        pool.SetThreadCount(2);
+        REQUIRE(RunsEachIndexOnce(pool, 64));
+
+        pool.SetThreadCount(4);
+        REQUIRE(pool.GetThreadCount() == 4);
+        REQUIRE(RunsEachIndexOnce(pool, 64));
+        REQUIRE(RunsEachIndexOnce(pool, 3));
+    }
+}
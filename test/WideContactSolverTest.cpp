@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2018 by Godlike
+ * This code is licensed under the MIT license (MIT)
+ * (http://opensource.org/licenses/MIT)
+ */
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+#include <pegasus/CollisionResolver.hpp>
+
+#include <cmath>
+
+namespace
+{
+
+uint32_t const CONTACT_COUNT = 19;
+
+float Wave(uint32_t index, float frequency)
+{
+    return std::sin(index * frequency);
+}
+
+void MakeScene(pegasus::collision::SolverBodies& solverBodies, std::vector<pegasus::collision::Contact>& contacts)
+{
+    //Body 0 is static and shared by every third contact
+    solverBodies.bodies.resize(2 * CONTACT_COUNT + 1);
+    for (uint32_t i = 1; i < solverBodies.bodies.size(); ++i)
+    {
+        pegasus::collision::SolverBody& body = solverBodies.bodies[i];
+        body.linearVelocity = glm::vec3(Wave(i, 1.1f), Wave(i, 2.3f) - 1.0f, Wave(i, 0.7f));
+        body.angularVelocity = glm::vec3(Wave(i, 0.3f), Wave(i, 1.9f), Wave(i, 2.9f)) * 2.0f;
+        body.inverseMass = 0.5f + 0.25f * Wave(i, 1.3f);
+        body.inverseInertia = pegasus::mechanics::SymmetricMatrix3(glm::mat3(2.0f + Wave(i, 0.5f)));
+        body.inverseInertia.xy = 0.3f * Wave(i, 0.9f);
+    }
+
+    for (uint32_t i = 0; i < CONTACT_COUNT; ++i)
+    {
+        pegasus::collision::Manifold manifold;
+        manifold.normal = glm::normalize(glm::vec3(Wave(i, 0.9f), 1.0f, Wave(i, 1.7f)));
+        manifold.firstTangent = glm::normalize(glm::cross(manifold.normal, glm::vec3(1, 0, 0)));
+        manifold.secondTangent = glm::cross(manifold.firstTangent, manifold.normal);
+        manifold.penetration = 0.01f * Wave(i, 2.1f);
+
+        pegasus::collision::Contact contact(1, 2, manifold, 0.5f, 0.4f);
+        contact.aSolverBody = i % 3 ? 2 * i + 1 : 0;
+        contact.bSolverBody = 2 * i + 2;
+        contact.aRelativePosition = glm::vec3(Wave(i, 0.4f), -0.5f, Wave(i, 0.8f)) * 0.5f;
+        contact.bRelativePosition = glm::vec3(Wave(i, 1.4f), 0.5f, Wave(i, 0.6f)) * 0.5f;
+        contact.lagrangianMultiplier = 1.0f + Wave(i, 0.2f);
+        contact.tangentLagrangianMultiplier1 = 0.1f * Wave(i, 0.5f);
+        contact.tangentLagrangianMultiplier2 = 0.1f * Wave(i, 1.5f);
+        contacts.push_back(contact);
+    }
+}
+
+/**
+ * @brief Makes a body falling and spinning onto a static one with two contacts
+ *
+ * The second contact lists the bodies in the opposite order.
+ *
+ * @param[out] solverBodies     solver bodies
+ * @param[out] contacts         contacts between the bodies
+ * @param[in]  angularVelocity  spin of the falling body around the z axis
+ */
+void MakeContactPair(
+    pegasus::collision::SolverBodies& solverBodies, std::vector<pegasus::collision::Contact>& contacts, float angularVelocity
+)
+{
+    solverBodies.bodies.resize(2);
+    solverBodies.bodies[1].linearVelocity = glm::vec3(0, -1, 0);
+    solverBodies.bodies[1].angularVelocity = glm::vec3(0, 0, angularVelocity);
+    solverBodies.bodies[1].inverseMass = 1.0f;
+    solverBodies.bodies[1].inverseInertia = pegasus::mechanics::SymmetricMatrix3(glm::mat3(6.0f));
+
+    pegasus::collision::Manifold manifold;
+    manifold.normal = glm::vec3(0, 1, 0);
+    manifold.firstTangent = glm::vec3(1, 0, 0);
+    manifold.secondTangent = glm::vec3(0, 0, 1);
+
+    pegasus::collision::Contact first(1, 2, manifold, 0.0f, 0.0f);
+    first.aSolverBody = 0;
+    first.bSolverBody = 1;
+    first.bRelativePosition = glm::vec3(-0.5f, -0.5f, 0.1f);
+    contacts.push_back(first);
+
+    manifold.normal = -manifold.normal;
+    pegasus::collision::Contact second(2, 1, manifold, 0.0f, 0.0f);
+    second.aSolverBody = 1;
+    second.bSolverBody = 0;
+    second.aRelativePosition = glm::vec3(0.3f, -0.5f, -0.2f);
+    contacts.push_back(second);
+}
+
+/**
+ * @brief Returns the relative normal velocity of the contact, positive when the bodies separate
+ * @param solverBodies  solver bodies
+ * @param contact       contact data
+ * @return relative normal velocity
+ */
+float GetNormalVelocity(pegasus::collision::SolverBodies const& solverBodies, pegasus::collision::Contact const& contact)
+{
+    pegasus::collision::SolverBody const& aBody = solverBodies.bodies[contact.aSolverBody];
+    pegasus::collision::SolverBody const& bBody = solverBodies.bodies[contact.bSolverBody];
+
+    return pegasus::collision::GetContactJacobian(contact) * pegasus::collision::Velocity{
+        aBody.linearVelocity, aBody.angularVelocity, bBody.linearVelocity, bBody.angularVelocity
+    };
+}
+
+} // namespace ::
+
+TEST_CASE("Wide contact solver matches the scalar one", "[solver]")
+{
+    using pegasus::collision::SimdInstructionSet;
+
+    pegasus::collision::ContactSolverSettings settings;
+    settings.duration = 0.01f;
+    settings.warmStartFactor = 0.5f;
+    settings.impulseFactor = 0.75f;
+
+    pegasus::collision::SolverBodies expectedBodies;
+    std::vector<pegasus::collision::Contact> expectedContacts;
+    MakeScene(expectedBodies, expectedContacts);
+    for (pegasus::collision::Contact& contact : expectedContacts)
+    {
+        pegasus::collision::SolveContact(expectedBodies, contact, settings);
+    }
+
+    std::vector<uint32_t> indices(CONTACT_COUNT);
+    for (uint32_t i = 0; i < CONTACT_COUNT; ++i)
+    {
+        indices[i] = i;
+    }
+
+    for (SimdInstructionSet instructionSet : { SimdInstructionSet::NONE, SimdInstructionSet::SSE, SimdInstructionSet::AVX2 })
+    {
+        if (instructionSet > pegasus::collision::DetectSimdInstructionSet())
+        {
+            continue;
+        }
+
+        pegasus::collision::SolverBodies solverBodies;
+        std::vector<pegasus::collision::Contact> contacts;
+        MakeScene(solverBodies, contacts);
+        pegasus::collision::SolveContactBatch(
+            solverBodies, contacts, indices.data(), CONTACT_COUNT, settings, instructionSet
+        );
+
+        REQUIRE(solverBodies.bodies[0].linearVelocity == expectedBodies.bodies[0].linearVelocity);
+        for (uint32_t i = 1; i < solverBodies.bodies.size(); ++i)
+        {
+            for (uint32_t j = 0; j < 3; ++j)
+            {
+                REQUIRE(solverBodies.bodies[i].linearVelocity[j]
+                    == Approx(expectedBodies.bodies[i].linearVelocity[j]).margin(1e-4));
+                REQUIRE(solverBodies.bodies[i].angularVelocity[j]
+                    == Approx(expectedBodies.bodies[i].angularVelocity[j]).margin(1e-4));
+            }
+        }
+
+        for (uint32_t i = 0; i < CONTACT_COUNT; ++i)
+        {
+            REQUIRE(contacts[i].lagrangianMultiplier
+                == Approx(expectedContacts[i].lagrangianMultiplier).margin(1e-4));
+            REQUIRE(contacts[i].tangentLagrangianMultiplier1
+                == Approx(expectedContacts[i].tangentLagrangianMultiplier1).margin(1e-4));
+            REQUIRE(contacts[i].tangentLagrangianMultiplier2
+                == Approx(expectedContacts[i].tangentLagrangianMultiplier2).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE("Jacobi solver matches the sequential one on independent contacts", "[solver]")
+{
+    pegasus::collision::ContactSolverSettings settings;
+    settings.duration = 0.01f;
+    settings.warmStartFactor = 0.5f;
+    settings.impulseFactor = 0.75f;
+
+    pegasus::collision::SolverBodies expectedBodies;
+    std::vector<pegasus::collision::Contact> expectedContacts;
+    MakeScene(expectedBodies, expectedContacts);
+    for (pegasus::collision::Contact& contact : expectedContacts)
+    {
+        pegasus::collision::SolveContact(expectedBodies, contact, settings);
+    }
+
+    //Contacts share only the static body, so a fully relaxed Jacobi pass has nothing to blend
+    pegasus::collision::SolverData solver;
+    solver.mode = pegasus::collision::SolverMode::JACOBI;
+    solver.relaxation = 1.0f;
+    std::vector<pegasus::collision::Contact> contacts;
+    MakeScene(solver.bodies, contacts);
+    pegasus::collision::BuildContactOrder(solver, contacts);
+
+    pegasus::ThreadPool threadPool(4);
+    pegasus::collision::SolveContacts(solver, threadPool, contacts, settings);
+
+    for (uint32_t i = 0; i < solver.bodies.bodies.size(); ++i)
+    {
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            REQUIRE(solver.bodies.bodies[i].linearVelocity[j]
+                == Approx(expectedBodies.bodies[i].linearVelocity[j]).margin(1e-5));
+            REQUIRE(solver.bodies.bodies[i].angularVelocity[j]
+                == Approx(expectedBodies.bodies[i].angularVelocity[j]).margin(1e-5));
+        }
+    }
+}
+
+TEST_CASE("Block solver solves two contacts between the same bodies", "[solver]")
+{
+    pegasus::collision::ContactSolverSettings settings;
+    settings.duration = 0.01f;
+    settings.warmStartFactor = 1.0f;
+    settings.baumgarteFactor = 0.0f;
+
+    SECTION("Both contacts are active")
+    {
+        pegasus::collision::SolverBodies expectedBodies;
+        std::vector<pegasus::collision::Contact> expectedContacts;
+        MakeContactPair(expectedBodies, expectedContacts, 0.5f);
+        for (uint32_t i = 0; i < 200; ++i)
+        {
+            for (pegasus::collision::Contact& contact : expectedContacts)
+            {
+                pegasus::collision::SolveContact(expectedBodies, contact, settings);
+            }
+        }
+
+        pegasus::collision::SolverBodies solverBodies;
+        std::vector<pegasus::collision::Contact> contacts;
+        MakeContactPair(solverBodies, contacts, 0.5f);
+        REQUIRE(pegasus::collision::SolveContactPair(solverBodies, contacts[0], contacts[1], settings));
+
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            float const velocity = GetNormalVelocity(solverBodies, contacts[i]);
+            REQUIRE(contacts[i].lagrangianMultiplier > 0.0f);
+            REQUIRE(velocity == Approx(0.0f).margin(1e-5));
+            REQUIRE(contacts[i].lagrangianMultiplier
+                == Approx(expectedContacts[i].lagrangianMultiplier).margin(1e-4));
+        }
+
+        for (uint32_t j = 0; j < 3; ++j)
+        {
+            REQUIRE(solverBodies.bodies[1].linearVelocity[j]
+                == Approx(expectedBodies.bodies[1].linearVelocity[j]).margin(1e-4));
+            REQUIRE(solverBodies.bodies[1].angularVelocity[j]
+                == Approx(expectedBodies.bodies[1].angularVelocity[j]).margin(1e-4));
+        }
+    }
+
+    SECTION("One contact separates")
+    {
+        pegasus::collision::SolverBodies solverBodies;
+        std::vector<pegasus::collision::Contact> contacts;
+        MakeContactPair(solverBodies, contacts, 4.0f);
+        REQUIRE(pegasus::collision::SolveContactPair(solverBodies, contacts[0], contacts[1], settings));
+
+        REQUIRE(contacts[0].lagrangianMultiplier > 0.0f);
+        REQUIRE(GetNormalVelocity(solverBodies, contacts[0]) == Approx(0.0f).margin(1e-5));
+        REQUIRE(contacts[1].lagrangianMultiplier == 0.0f);
+        REQUIRE(GetNormalVelocity(solverBodies, contacts[1]) > 0.0f);
+    }
+}